@@ -0,0 +1,62 @@
+#ifndef CEIT_BENCH_H
+#define CEIT_BENCH_H
+
+#include "ceit.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/** Monotonic wall-clock time in nanoseconds. */
+static inline double bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/** Cheap timestamp for timing single operations: the TSC on x86, nanoseconds elsewhere. */
+static inline unsigned long long bench_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return (unsigned long long)bench_now_ns();
+#endif
+}
+
+static inline int bench_compare(const void* a, const void* b) {
+    unsigned long long x = *(const unsigned long long*)a, y = *(const unsigned long long*)b;
+    return (x > y) - (x < y);
+}
+
+/** Sorts `count` samples and returns the given percentile (0..100) of them. */
+static inline unsigned long long bench_percentile(unsigned long long* samples, size_t count, double percentile) {
+    qsort(samples, count, sizeof(*samples), bench_compare);
+    size_t index = (size_t)(percentile / 100.0 * (count - 1) + 0.5);
+    return samples[index];
+}
+
+/** Resident set size of the process in KiB, from /proc/self/statm. */
+static inline size_t bench_rss_kb(void) {
+    size_t pages = 0, resident = 0;
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (!file) return 0;
+    if (fscanf(file, "%zu %zu", &pages, &resident) != 2) resident = 0;
+    fclose(file);
+    return resident * 4;
+}
+
+/** Shuffles an array of pointers with a fixed seed, so runs are comparable. */
+static inline void bench_shuffle(void** items, size_t count, unsigned seed) {
+    srand(seed);
+    for (size_t i = count - 1; i > 0; i--) {
+        size_t j = ((size_t)rand() * RAND_MAX + rand()) % (i + 1);
+        void* t = items[i];
+        items[i] = items[j];
+        items[j] = t;
+    }
+}
+
+#endif
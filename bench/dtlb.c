@@ -0,0 +1,86 @@
+// dTLB misses of random reads over a large Memchunk, with and without huge pages.
+#include "bench.h"
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define SIZE ((size_t)1 << 30)
+#define READS 20000000
+
+/** Keeps the compiler from dropping the reads. */
+static volatile unsigned long long sink;
+
+/** Opens a counter of the calling thread's dTLB read misses, or returns -1. */
+static int dtlb_counter(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/** Anonymous memory of the process backed by transparent huge pages, in KiB. */
+static size_t anon_huge_kb(void) {
+    char line[256];
+    size_t kb = 0;
+    FILE* file = fopen("/proc/self/smaps_rollup", "r");
+    if (!file) return 0;
+    while (fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "AnonHugePages: %zu", &kb) == 1) break;
+    }
+    fclose(file);
+    return kb;
+}
+
+static void run(const char* mode, unsigned flags) {
+    Memchunk* chunk = memc_init_flags("dtlb", SIZE + (4 << 20), flags);
+    unsigned long long* data = chunk ? memory_alloc(chunk, SIZE, NULL) : NULL;
+    if (!data) {
+        printf("%10s: allocation failed\n", mode);
+        if (chunk) memc_dealloc(chunk);
+        return;
+    }
+    size_t words = SIZE / sizeof(*data);
+    for (size_t i = 0; i < words; i++) data[i] = i;
+
+    int counter = dtlb_counter();
+    unsigned long long state = 88172645463325252ULL, sum = 0, misses = 0;
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    double start = bench_now_ns();
+    for (int i = 0; i < READS; i++) {
+        state ^= state << 13;  // xorshift64
+        state ^= state >> 7;
+        state ^= state << 17;
+        sum += data[(state + sum) % words];  // Each address depends on the previous read
+    }
+    double ns = (bench_now_ns() - start) / READS;
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(counter, &misses, sizeof(misses)) != sizeof(misses)) misses = 0;
+        close(counter);
+    }
+
+    const char* huge = chunk->huge_pages == MEMC_HUGE_EXPLICIT ? "explicit" : chunk->huge_pages == MEMC_HUGE_TRANSPARENT ? "THP" : "none";
+    if (counter >= 0) printf("%10s %10s %12zu %14.3f %12.1f\n", mode, huge, anon_huge_kb() >> 10, (double)misses / READS, ns);
+    else printf("%10s %10s %12zu %14s %12.1f\n", mode, huge, anon_huge_kb() >> 10, "n/a", ns);
+    sink = sum;
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    printf("%10s %10s %12s %14s %12s\n", "chunk", "huge pages", "THP MiB", "dTLB miss/read", "ns/read");
+    run("4K pages", MEMC_MMAP);
+    run("2M pages", MEMC_HUGE_PAGES);
+    int probe = dtlb_counter();
+    if (probe < 0) printf("dTLB counter unavailable (perf_event_open failed); only timings shown\n");
+    else close(probe);
+    return 0;
+}
@@ -0,0 +1,62 @@
+// Fragmentation and latency of each placement strategy under a long random workload.
+#include "bench.h"
+
+#define POOL (64 << 20)
+#define LIVE 40000
+#define OPS 2000000
+
+static const struct { const char* name; unsigned flags; } engines[] = {
+    {"classes", 0}, {"tlsf", MEMC_TLSF}, {"best-fit", MEMC_BEST_FIT}, {"buddy", MEMC_BUDDY},
+};
+
+/** Mostly small requests, some medium and a few large ones: about 40 MiB live at LIVE blocks. */
+static size_t random_size(unsigned* seed) {
+    int kind = rand_r(seed) % 100;
+    if (kind < 80) return 16 + rand_r(seed) % 496;
+    if (kind < 97) return 512 + rand_r(seed) % 7680;
+    return 8192 + rand_r(seed) % 57344;
+}
+
+int main(void) {
+    static void* live[LIVE];
+    static unsigned long long alloc_ticks[OPS], free_ticks[OPS];
+    printf("%9s %8s %8s %10s %8s %8s %7s %9s %10s %10s %7s\n", "engine", "alloc50", "alloc99", "alloc99.99", "free50", "free99",
+           "failed", "used_kb", "free_blks", "largest", "frag");
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        Memchunk* chunk = memc_init_flags("frag", POOL, engines[e].flags);
+        void* all = memory_alloc(chunk, POOL / 2, NULL);  // Fault the pages in up front
+        memset(all, 0, POOL / 2);
+        memory_free_ptr(chunk, all);
+
+        size_t allocs = 0, frees = 0;
+        unsigned seed = 19;
+        for (int op = 0; op < OPS; op++) {
+            int i = rand_r(&seed) % LIVE;
+            unsigned long long t0 = bench_cycles();
+            if (live[i]) {
+                memory_free_ptr(chunk, live[i]);
+                free_ticks[frees++] = bench_cycles() - t0;
+                live[i] = NULL;
+            } else {
+                size_t size = random_size(&seed);
+                live[i] = memory_alloc(chunk, size, NULL);
+                alloc_ticks[allocs++] = bench_cycles() - t0;
+            }
+        }
+
+        // Fragmentation as the workload left it, before the live blocks go
+        Memstats stats;
+        memc_stats(chunk, &stats);
+        printf("%9s %8llu %8llu %10llu %8llu %8llu %7zu %9zu %10zu %10zu %6.1f%%\n", engines[e].name,
+               bench_percentile(alloc_ticks, allocs, 50), bench_percentile(alloc_ticks, allocs, 99),
+               bench_percentile(alloc_ticks, allocs, 99.99), bench_percentile(free_ticks, frees, 50),
+               bench_percentile(free_ticks, frees, 99), stats.failed_count, stats.used_memory / 1024, stats.free_blocks,
+               stats.largest_free, 100.0 * stats.fragmentation);
+        for (int i = 0; i < LIVE; i++) {
+            memory_free_ptr(chunk, live[i]);
+            live[i] = NULL;
+        }
+        memc_dealloc(chunk);
+    }
+    return 0;
+}
@@ -0,0 +1,28 @@
+// Free latency against the number of live blocks: with boundary tags it should stay flat.
+#include "bench.h"
+
+int main(void) {
+    printf("%10s %12s %12s %12s\n", "blocks", "mean ns", "p99 ticks", "max ticks");
+    for (size_t count = 1000; count <= 1000000; count *= 10) {
+        Memchunk* chunk = memc_init("free_latency", count * 96 + (1 << 20));
+        void** blocks = malloc(count * sizeof(void*));
+        unsigned long long* ticks = malloc(count * sizeof(unsigned long long));
+        for (size_t i = 0; i < count; i++) blocks[i] = memory_alloc(chunk, 32 + (i % 4) * 8, NULL);
+        bench_shuffle(blocks, count, 1);
+
+        double start = bench_now_ns();
+        for (size_t i = 0; i < count; i++) {
+            unsigned long long t0 = bench_cycles();
+            memory_free_ptr(chunk, blocks[i]);
+            ticks[i] = bench_cycles() - t0;
+        }
+        double mean = (bench_now_ns() - start) / count;
+        unsigned long long p99 = bench_percentile(ticks, count, 99.0);
+        printf("%10zu %12.1f %12llu %12llu\n", count, mean, p99, ticks[count - 1]);
+
+        free(ticks);
+        free(blocks);
+        memc_dealloc(chunk);
+    }
+    return 0;
+}
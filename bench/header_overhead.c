@@ -0,0 +1,43 @@
+// Memory cost per block of the 16-byte header against the original 112-byte Memory layout.
+#include "bench.h"
+
+/** The original block header, with its inline name and data array. */
+struct LegacyMemory {
+    char name[32];
+    size_t size;
+    int is_free;
+    struct LegacyMemory* next;
+    char data[50];
+};
+
+#define BLOCKS 100000
+
+int main(void) {
+    static const size_t sizes[] = {8, 16, 32, 64, 128, 256, 1024};
+    printf("legacy header: %zu bytes, header: %zu bytes\n", sizeof(struct LegacyMemory), sizeof(Memory));
+    printf("%8s %14s %14s %14s %10s\n", "request", "legacy B/blk", "anon B/blk", "named B/blk", "saved");
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        size_t size = sizes[i];
+        double legacy = (double)(sizeof(struct LegacyMemory) + size);
+
+        // Anonymous blocks: everything they take from the pool
+        Memchunk* chunk = memc_init("overhead", BLOCKS * (size + 64) + (1 << 20));
+        for (int n = 0; n < BLOCKS; n++) memory_alloc(chunk, size, NULL);
+        double anonymous = (double)(chunk->used_memory + BLOCKS * sizeof(Memory)) / BLOCKS;
+        memc_dealloc(chunk);
+
+        // Named blocks: the same, plus the name index and its name strings
+        chunk = memc_init("overhead", BLOCKS * (size + 64) + (1 << 20));
+        char name[CEIT_NAME_LEN];
+        for (int n = 0; n < BLOCKS; n++) {
+            snprintf(name, sizeof(name), "node_%d", n);
+            memory_alloc(chunk, size, name);
+        }
+        size_t index = chunk->name_capacity * (sizeof(Memname) + CEIT_NAME_LEN);
+        double named = (double)(chunk->used_memory + BLOCKS * sizeof(Memory) + index) / BLOCKS;
+        memc_dealloc(chunk);
+
+        printf("%8zu %14.1f %14.1f %14.1f %9.0f%%\n", size, legacy, anonymous, named, 100.0 * (1 - anonymous / legacy));
+    }
+    return 0;
+}
@@ -0,0 +1,34 @@
+// Startup time and RSS of large Memchunks: the mmap reserve-then-commit backend against the malloc backend.
+#include "bench.h"
+
+static void run(const char* backend, unsigned flags, size_t size) {
+    size_t rss_before = bench_rss_kb();
+    double start = bench_now_ns();
+    Memchunk* chunk = memc_init_flags("startup", size, flags);
+    double init_us = (bench_now_ns() - start) / 1000;
+    size_t rss_init = bench_rss_kb() - rss_before;
+    if (!chunk) {
+        printf("%8s %6zu GiB: memc_init failed\n", backend, size >> 30);
+        return;
+    }
+
+    // Touch 64 MiB of 4 KiB blocks
+    start = bench_now_ns();
+    for (int i = 0; i < 16384; i++) memset(memory_alloc(chunk, 4096 - sizeof(Memory), NULL), 1, 4096 - sizeof(Memory));
+    double use_ms = (bench_now_ns() - start) / 1e6;
+    size_t rss_used = bench_rss_kb() - rss_before;
+
+    start = bench_now_ns();
+    memc_dealloc(chunk);
+    double release_us = (bench_now_ns() - start) / 1000;
+    printf("%8s %6zu %12.1f %12zu %12.1f %12zu %12.1f\n", backend, size >> 30, init_us, rss_init, use_ms, rss_used, release_us);
+}
+
+int main(void) {
+    printf("%8s %6s %12s %12s %12s %12s %12s\n", "backend", "GiB", "init us", "init RSS KiB", "64MiB use ms", "used RSS KiB", "release us");
+    for (size_t size = (size_t)1 << 30; size <= (size_t)16 << 30; size *= 4) {
+        run("malloc", 0, size);
+        run("mmap", MEMC_MMAP, size);
+    }
+    return 0;
+}
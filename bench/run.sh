@@ -0,0 +1,18 @@
+#!/bin/sh
+# Builds each benchmark with optimizations the way build.sh builds the demo, and runs it.
+# Usage: bench/run.sh [benchmark ...]    e.g. CC=gcc bench/run.sh free_latency
+# A benchmark can ask for extra flags with a "// cflags: ..." line.
+cd "$(dirname "$0")/.." || exit 1
+CC=${CC:-cc}
+mkdir -p bench/bin
+
+if [ $# -eq 0 ]; then
+    set -- $(ls bench/*.c | sed 's|bench/||; s|\.c$||')
+fi
+
+for name in "$@"; do
+    extra=$(sed -n 's|^// cflags: ||p' "bench/$name.c")
+    $CC -O2 $CFLAGS $extra "bench/$name.c" $(find ./ceit -type f -name "*.c") -o "bench/bin/$name" -I ./ceit -pthread || exit 1
+    echo "== $name"
+    "./bench/bin/$name" || exit 1
+done
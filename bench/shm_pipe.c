@@ -0,0 +1,108 @@
+// Producer to consumer throughput: payloads copied through a pipe against blocks of a shared Memchunk handed over by offset.
+#include "bench.h"
+#include <sched.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define VOLUME ((size_t)512 << 20)
+
+/** Writes or reads exactly `size` bytes. */
+static void pipe_write(int fd, const void* data, size_t size) {
+    for (size_t done = 0; done < size;) {
+        ssize_t n = write(fd, (const char*)data + done, size - done);
+        if (n <= 0) _exit(1);
+        done += (size_t)n;
+    }
+}
+
+static int pipe_read(int fd, void* data, size_t size) {
+    for (size_t done = 0; done < size;) {
+        ssize_t n = read(fd, (char*)data + done, size - done);
+        if (n <= 0) return -1;
+        done += (size_t)n;
+    }
+    return 0;
+}
+
+/** Sums a payload, as a consumer that looks at every byte would. */
+static unsigned long long checksum(const unsigned char* data, size_t size) {
+    unsigned long long sum = 0;
+    for (size_t i = 0; i < size; i += 8) sum += *(const unsigned long long*)(data + i);
+    return sum;
+}
+
+/** The payloads themselves go down the pipe, and the consumer reads them into its own buffer. */
+static double run_pipe(size_t size, size_t count) {
+    int fds[2];
+    if (pipe(fds) != 0) return 0;
+    double t0 = bench_now_ns();
+    pid_t child = fork();
+    if (child == 0) {
+        close(fds[0]);
+        unsigned char* payload = (unsigned char*)malloc(size);
+        for (size_t i = 0; i < count; i++) {
+            memset(payload, (int)i, size);
+            pipe_write(fds[1], payload, size);
+        }
+        _exit(0);
+    }
+    close(fds[1]);
+    unsigned char* buffer = (unsigned char*)malloc(size);
+    unsigned long long sum = 0;
+    for (size_t i = 0; i < count && pipe_read(fds[0], buffer, size) == 0; i++) sum += checksum(buffer, size);
+    waitpid(child, NULL, 0);
+    double elapsed = bench_now_ns() - t0;
+    close(fds[0]);
+    free(buffer);
+    return sum ? elapsed : elapsed + 1;  // Keeps the checksum alive
+}
+
+/** The producer writes each payload into a shared block, and only its offset goes down the pipe. */
+static double run_shared(size_t size, size_t count) {
+    char name[64];
+    snprintf(name, sizeof(name), "/ceit_shm_pipe_%d", (int)getpid());
+    Memchunk* chunk = memc_init_shared(name, 256 << 20);
+    int fds[2];
+    if (!chunk || pipe(fds) != 0) return 0;
+    double t0 = bench_now_ns();
+    pid_t child = fork();
+    if (child == 0) {
+        close(fds[0]);
+        Memchunk* view = memc_init_shared(name, 0);
+        for (size_t i = 0; i < count; i++) {
+            void* block;
+            while (!(block = memory_alloc(view, size, NULL))) sched_yield();  // The consumer is behind
+            memset(block, (int)i, size);
+            size_t offset = memc_offset(view, block);
+            pipe_write(fds[1], &offset, sizeof(offset));
+        }
+        memc_dealloc(view);
+        _exit(0);
+    }
+    close(fds[1]);
+    unsigned long long sum = 0;
+    size_t offset;
+    for (size_t i = 0; i < count && pipe_read(fds[0], &offset, sizeof(offset)) == 0; i++) {
+        void* block = memc_pointer(chunk, offset);
+        sum += checksum((const unsigned char*)block, size);
+        memory_free_ptr(chunk, block);
+    }
+    waitpid(child, NULL, 0);
+    double elapsed = bench_now_ns() - t0;
+    close(fds[0]);
+    memc_dealloc(chunk);
+    return sum ? elapsed : elapsed + 1;
+}
+
+int main(void) {
+    static const size_t sizes[] = {64, 1024, 4096, 65536, 1 << 20};
+    printf("%8s %9s %12s %12s %12s %12s %8s\n", "payload", "count", "pipe_ms", "shm_ms", "pipe_MB/s", "shm_MB/s", "speedup");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t size = sizes[s], count = VOLUME / size > 1000000 ? 1000000 : VOLUME / size;
+        double piped = run_pipe(size, count), shared = run_shared(size, count);
+        double megabytes = (double)(size * count) / 1048576.0;
+        printf("%8zu %9zu %12.1f %12.1f %12.0f %12.0f %7.2fx\n", size, count, piped / 1e6, shared / 1e6,
+               megabytes / (piped / 1e9), megabytes / (shared / 1e9), piped / shared);
+    }
+    return 0;
+}
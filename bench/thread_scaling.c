@@ -0,0 +1,56 @@
+// Alloc/free throughput from 1 to N threads: MEMC_THREAD_SAFE against one mutex around a plain Memchunk.
+#include "bench.h"
+#include <pthread.h>
+#include <unistd.h>
+
+#define OPS 2000000
+#define LIVE 64
+
+static Memchunk* chunk;
+static pthread_mutex_t global_lock = PTHREAD_MUTEX_INITIALIZER;
+static int use_global_lock;
+
+static void* worker(void* arg) {
+    unsigned seed = (unsigned)(size_t)arg;
+    void* blocks[LIVE] = {0};
+    for (int op = 0; op < OPS; op++) {
+        int i = rand_r(&seed) % LIVE;
+        if (use_global_lock) pthread_mutex_lock(&global_lock);
+        if (blocks[i]) {
+            memory_free_ptr(chunk, blocks[i]);
+            blocks[i] = NULL;
+        } else {
+            blocks[i] = memory_alloc(chunk, 16 + rand_r(&seed) % 240, NULL);
+        }
+        if (use_global_lock) pthread_mutex_unlock(&global_lock);
+    }
+    if (use_global_lock) pthread_mutex_lock(&global_lock);
+    for (int i = 0; i < LIVE; i++) memory_free_ptr(chunk, blocks[i]);
+    if (use_global_lock) pthread_mutex_unlock(&global_lock);
+    return NULL;
+}
+
+/** Runs `threads` workers and returns the total operations per microsecond. */
+static double run(int threads, int global) {
+    use_global_lock = global;
+    chunk = memc_init_flags("scaling", 64 << 20, global ? 0 : MEMC_THREAD_SAFE);
+    pthread_t ids[256];
+    double start = bench_now_ns();
+    for (int i = 0; i < threads; i++) pthread_create(&ids[i], NULL, worker, (void*)(size_t)(i + 1));
+    for (int i = 0; i < threads; i++) pthread_join(ids[i], NULL);
+    double elapsed = bench_now_ns() - start;
+    memc_dealloc(chunk);
+    return (double)threads * OPS / (elapsed / 1000);
+}
+
+int main(int argc, char** argv) {
+    long cpus = argc > 1 ? atol(argv[1]) : sysconf(_SC_NPROCESSORS_ONLN);  // The thread count to go up to
+    int max = cpus > 256 ? 256 : cpus < 1 ? 1 : (int)cpus;
+    printf("%8s %16s %16s %10s\n", "threads", "tcache Mops/s", "mutex Mops/s", "speedup");
+    for (int threads = 1; threads <= max; threads *= 2) {
+        double cached = run(threads, 0), locked = run(threads, 1);
+        printf("%8d %16.1f %16.1f %9.1fx\n", threads, cached, locked, cached / locked);
+        if (threads < max && threads * 2 > max) threads = max / 2;  // Always end on all CPUs
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+// Warm restart of a file-backed index against rebuilding it: time until every entry can be looked up by name.
+#include "bench.h"
+#include <unistd.h>
+
+#define RECORD 64
+
+/** Builds `count` named records in a Memchunk, as a restart without a persistent chunk has to. */
+static void build(Memchunk* chunk, size_t count) {
+    char name[32];
+    for (size_t i = 0; i < count; i++) {
+        snprintf(name, sizeof(name), "key_%zu", i);
+        size_t* record = (size_t*)memory_alloc(chunk, RECORD, name);
+        record[0] = i;
+    }
+}
+
+/** Looks up every record and checks it; returns the number found. */
+static size_t lookup_all(Memchunk* chunk, size_t count) {
+    char name[32];
+    size_t found = 0;
+    for (size_t i = 0; i < count; i++) {
+        snprintf(name, sizeof(name), "key_%zu", i);
+        size_t* record = (size_t*)memory_find(chunk, name);
+        found += record && record[0] == i;
+    }
+    return found;
+}
+
+int main(void) {
+    static const size_t counts[] = {10000, 100000, 1000000};
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/ceit_warm_restart_%d", (int)getpid());
+
+    printf("%8s %12s %12s %12s %12s\n", "entries", "rebuild_ms", "reopen_ms", "lookup_ms", "file_mb");
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        size_t count = counts[c], size = count * (RECORD + 64) + (8 << 20);
+
+        // Rebuild: a fresh chunk gets every record inserted again
+        double t0 = bench_now_ns();
+        Memchunk* chunk = memc_init("rebuild", size);
+        build(chunk, count);
+        double rebuild = bench_now_ns() - t0;
+        memc_dealloc(chunk);
+
+        // The same index, kept in a file and saved once
+        unlink(path);
+        chunk = memc_open_file(path, size);
+        build(chunk, count);
+        memc_dealloc(chunk);
+
+        // Warm restart: reopen the file, with its page cache still warm
+        t0 = bench_now_ns();
+        chunk = memc_open_file(path, 0);
+        double reopen = bench_now_ns() - t0;
+        size_t found = lookup_all(chunk, count);
+        double lookup = bench_now_ns() - t0 - reopen;
+        if (found != count) printf("lost %zu records\n", count - found);
+        size_t file_size = chunk->total_size;
+        memc_dealloc(chunk);
+
+        printf("%8zu %12.2f %12.2f %12.2f %12.1f\n", count, rebuild / 1e6, reopen / 1e6, lookup / 1e6, file_size / 1048576.0);
+    }
+    unlink(path);
+    return 0;
+}
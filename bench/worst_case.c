@@ -0,0 +1,91 @@
+// Tail latency of alloc and free under adversarial patterns: size classes, TLSF and best fit.
+#include "bench.h"
+
+#define OPS 1000000
+#define LIVE 20000
+#define CROWD 50000
+
+static const struct { const char* name; unsigned flags; } engines[] = {
+    {"classes", 0}, {"tlsf", MEMC_TLSF}, {"best-fit", MEMC_BEST_FIT},
+};
+
+static void report(const char* engine, const char* pattern, const char* op, unsigned long long* ticks, size_t count) {
+    unsigned long long p50 = bench_percentile(ticks, count, 50), p9999 = bench_percentile(ticks, count, 99.99);
+    printf("%9s %10s %6s %8llu %10llu %10llu\n", engine, pattern, op, p50, p9999, ticks[count - 1]);
+}
+
+/** Touches every page of a Memchunk up front, so page faults stay out of the timings. */
+static void prefault(Memchunk* chunk) {
+    size_t size = chunk->total_size - chunk->total_size / 8;  // Leaves TLSF room to round the request up
+    void* all = memory_alloc(chunk, size, NULL);
+    memset(all, 0, size);
+    memory_free_ptr(chunk, all);
+}
+
+/** Random sizes from 16 bytes to 8 KiB, freed in random order. */
+static void random_pattern(const char* engine, unsigned flags, unsigned long long* alloc_ticks, unsigned long long* free_ticks) {
+    Memchunk* chunk = memc_init_flags("worst", 256 << 20, flags);
+    prefault(chunk);
+    static void* live[LIVE];
+    size_t allocs = 0, frees = 0;
+    unsigned seed = 5;
+    for (int op = 0; op < OPS; op++) {
+        int i = rand_r(&seed) % LIVE;
+        unsigned long long t0 = bench_cycles();
+        if (live[i]) {
+            memory_free_ptr(chunk, live[i]);
+            free_ticks[frees++] = bench_cycles() - t0;
+            live[i] = NULL;
+        } else {
+            size_t size = rand_r(&seed) % 8 ? 16 + rand_r(&seed) % 512 : 16 + rand_r(&seed) % 8192;
+            live[i] = memory_alloc(chunk, size, NULL);
+            alloc_ticks[allocs++] = bench_cycles() - t0;
+        }
+    }
+    for (int i = 0; i < LIVE; i++) {
+        memory_free_ptr(chunk, live[i]);
+        live[i] = NULL;
+    }
+    memc_dealloc(chunk);
+    report(engine, "random", "alloc", alloc_ticks, allocs);
+    report(engine, "random", "free", free_ticks, frees);
+}
+
+/**
+ * Tens of thousands of free blocks crowd one size class, none large enough
+ * for the requests, and nothing else is free: a list walk visits them all.
+ */
+static void crowded_pattern(const char* engine, unsigned flags, unsigned long long* alloc_ticks) {
+    Memchunk* chunk = memc_init_flags("worst", CROWD * 640 + (1 << 20), flags);
+    prefault(chunk);
+    static void* crowd[CROWD];
+    for (int i = 0; i < CROWD; i++) {
+        crowd[i] = memory_alloc(chunk, 528, NULL);
+        memory_alloc(chunk, 16, NULL);  // Keeps the freed blocks apart
+    }
+    while (memory_alloc(chunk, 4096, NULL)) {}
+    while (memory_alloc(chunk, 32, NULL)) {}
+    for (int i = 0; i < CROWD; i++) memory_free_ptr(chunk, crowd[i]);
+
+    size_t count = 0;
+    for (int op = 0; op < 20000; op++) {
+        unsigned long long t0 = bench_cycles();
+        memory_alloc(chunk, 1000, NULL);  // Fits none of them, and fails
+        alloc_ticks[count++] = bench_cycles() - t0;
+    }
+    memc_dealloc(chunk);
+    report(engine, "crowded", "alloc", alloc_ticks, count);
+}
+
+int main(void) {
+    unsigned long long* alloc_ticks = malloc(OPS * sizeof(unsigned long long));
+    unsigned long long* free_ticks = malloc(OPS * sizeof(unsigned long long));
+    printf("%9s %10s %6s %8s %10s %10s\n", "engine", "pattern", "op", "p50", "p99.99", "max");
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        random_pattern(engines[e].name, engines[e].flags, alloc_ticks, free_ticks);
+        crowded_pattern(engines[e].name, engines[e].flags, alloc_ticks);
+    }
+    free(alloc_ticks);
+    free(free_ticks);
+    return 0;
+}
@@ -1 +1 @@
-clang main.c $(find ./ceit -type f -name "*.c") -o test -I ./ceit
+clang main.c $(find ./ceit -type f -name "*.c") -o test -I ./ceit -pthread
@@ -2,22 +2,157 @@
 #define CEIT_H
 
 #include <stddef.h>
+#include <pthread.h>
+
+/** Number of free-list size classes kept per Memchunk (one per power of two). */
+#define CEIT_SIZE_CLASSES 64
+
+/**
+ * Granularity of block sizes and minimum alignment of every allocation. It
+ * matches `max_align_t`, and the low bits of Memory::size are free for flags.
+ */
+#define CEIT_ALIGN 16
+
+/** Maximum stored length of a block name, including the terminating null. */
+#define CEIT_NAME_LEN 32
+
+/** memc_init_flags flag: the Memchunk may be used from several threads at once. */
+#define MEMC_THREAD_SAFE 0x1
+/** memc_init_flags flag: the Memchunk is a bump-pointer arena (see memc_init_arena). */
+#define MEMC_ARENA 0x2
+/** memc_init_flags flag: reserve the region with mmap and commit pages as allocations reach them. */
+#define MEMC_MMAP 0x4
+/** memc_init_flags flag: back the Memchunk with 2 MB pages; implies MEMC_MMAP. */
+#define MEMC_HUGE_PAGES 0x8
+/** memc_init_flags flag: find free blocks in O(1) with two-level segregated fit lists (TLSF). */
+#define MEMC_TLSF 0x10
+/** memc_init_flags flag: a binary buddy allocator (see memc_init_buddy). */
+#define MEMC_BUDDY 0x20
+/** memc_init_flags flag: exact best-fit placement, with free blocks in a tree ordered by (size, address). */
+#define MEMC_BEST_FIT 0x40
+/** Memchunk::flags bit: the Memchunk is mapped from a file by memc_open_file; not accepted by memc_init_flags. */
+#define MEMC_FILE 0x80
+/** Memchunk::flags bit: the Memchunk lives in shared memory (see memc_init_shared); not accepted by memc_init_flags. */
+#define MEMC_SHARED 0x100
+
+/** Memlatency operation: memory_alloc. */
+#define MEMC_OP_ALLOC 0
+/** Memlatency operation: memory_free and memory_free_ptr. */
+#define MEMC_OP_FREE 1
+/** Memlatency operation: memory_realloc. */
+#define MEMC_OP_REALLOC 2
+/** Number of operations with a latency histogram. */
+#define CEIT_LATENCY_OPS 3
+
+/** Log2 of the number of linear sub-buckets per power of two in a latency histogram. */
+#define CEIT_LATENCY_SUB_LOG 4
+/** Number of buckets of a latency histogram: latencies up to 2^48 ticks, within 1/16 of their value. */
+#define CEIT_LATENCY_BUCKETS ((48 - CEIT_LATENCY_SUB_LOG + 1) << CEIT_LATENCY_SUB_LOG)
+
+/** Default mean number of bytes between two heap profile samples (see memc_set_profile). */
+#define CEIT_PROFILE_RATE (512 * 1024)
+
+/** Memchunk::huge_pages value: the Memchunk uses transparent huge pages (MADV_HUGEPAGE). */
+#define MEMC_HUGE_TRANSPARENT 1
+/** Memchunk::huge_pages value: the Memchunk is mapped with explicit huge pages (MAP_HUGETLB). */
+#define MEMC_HUGE_EXPLICIT 2
+
+/** Memory::size flag: the block is free. */
+#define CEIT_BLOCK_FREE 0x1
+/** Memory::size flag: the physically previous block is free and ends in a size footer. */
+#define CEIT_BLOCK_PREV_FREE 0x2
+/** Memory::size flag: the block has an entry in its Memchunk's name index. */
+#define CEIT_BLOCK_NAMED 0x4
+/** Mask of all Memory::size flag bits. */
+#define CEIT_BLOCK_FLAGS 0x7
 
 // Forward declarations
 typedef struct Memory Memory;
 typedef struct Memchunk Memchunk;
+typedef struct Memname Memname;
+typedef struct Memslab Memslab;
+typedef struct Memstats Memstats;
+typedef struct Memlatency Memlatency;
+typedef struct Memprofile Memprofile;
+typedef struct Memtag Memtag;
 extern Memchunk* global_memchunk_list;  // Global pointer to the list of Memchunks
 
 /**
  * @brief Structure representing a block of memory allocated from a Page.
  * Contains metadata for block management.
+ *
+ * The header is 16 bytes and is followed directly by the block data. Blocks
+ * are laid out back to back, so the next block starts right after the data
+ * and a free block stores its size in a footer for its successor to find it.
+ * A free block keeps its free-list links, as offsets, in its data area. Block
+ * names live in the Memchunk's name index, not in the header.
  */
 struct Memory {
-    char name[32];          ///< Name of the memory block for easy reference.
-    size_t size;            ///< Size of the allocated block.
-    int is_free;            ///< Indicates if the block is free (1) or allocated (0).
-    Memory* next;           ///< Pointer to the next memory block in the list.
-    char data[50];          ///< Flexible array member for block data.
+    size_t size;            ///< Size of the block data, a multiple of CEIT_ALIGN, ORed with CEIT_BLOCK_* flags.
+    size_t name_hash;       ///< Hash of the block name (named blocks only); purge state and time of a free block.
+};
+
+/**
+ * @brief Slot of a Memchunk's open-addressing name index.
+ * The cached hash lets probes skip most name comparisons.
+ */
+struct Memname {
+    size_t hash;            ///< Hash of the block name.
+    Memory* block;          ///< Named block, or NULL for an empty slot.
+    unsigned tag;           ///< Index of the block's tag in Memchunk::tags.
+};
+
+/**
+ * @brief Statistics of a Memchunk, as returned by memc_stats.
+ *
+ * The counters are kept up to date by the allocation and free paths; the
+ * fields from used_memory on are only filled in by memc_stats. The counts
+ * cover the program's calls, including those a thread cache serves without
+ * the lock; blocks waiting in a cache are not live, but their bytes stay in
+ * used_memory until they are flushed.
+ */
+struct Memstats {
+    size_t alloc_count;     ///< Blocks allocated so far.
+    size_t free_count;      ///< Blocks freed so far.
+    size_t failed_count;    ///< Allocation requests that returned NULL.
+    size_t requested_bytes; ///< Bytes requested by the allocations so far, rounded up to CEIT_ALIGN.
+    size_t reserved_bytes;  ///< Bytes of the blocks that served them; the excess is internal fragmentation.
+    size_t live_blocks;     ///< Blocks currently allocated.
+    size_t free_blocks;     ///< Blocks currently in the free lists.
+
+    size_t used_memory;     ///< Used memory in bytes, as in Memchunk::used_memory.
+    size_t free_memory;     ///< Free memory in bytes, as in Memchunk::free_memory.
+    size_t header_bytes;    ///< Bytes taken by block headers.
+    size_t largest_free;    ///< Size of the largest free block: the largest request that fits without growing.
+    double fragmentation;   ///< External fragmentation: 1 - largest_free / bytes in free blocks, from 0 to 1.
+};
+
+/**
+ * @brief Memory accounted to one tag, as kept by a Memchunk and returned by memc_tag_stats.
+ *
+ * A block's tag is its name without a trailing number and the separator
+ * before it, so "SJOY_1" and "SJOY_2" both count towards "SJOY". Only
+ * named blocks are tagged.
+ */
+struct Memtag {
+    char name[CEIT_NAME_LEN]; ///< The tag.
+    size_t live_bytes;      ///< Bytes of the live blocks with this tag, headers excluded.
+    size_t live_blocks;     ///< Live blocks with this tag.
+    size_t alloc_count;     ///< Blocks given this tag so far, including moves by memory_realloc.
+};
+
+/**
+ * @brief Latency histograms of a Memchunk's operations, as returned by memc_latency.
+ *
+ * Latencies are measured in ticks of the CPU's cycle counter. Each
+ * histogram is log-linear, as in HdrHistogram: every power of two is split
+ * into 16 linear buckets, so a bucket's bounds are within 1/16 of each
+ * other at any scale. Buckets 0-15 hold 0-15 ticks exactly.
+ */
+struct Memlatency {
+    unsigned long long counts[CEIT_LATENCY_OPS][CEIT_LATENCY_BUCKETS]; ///< Operations per bucket, indexed by MEMC_OP_*.
+    unsigned long long total[CEIT_LATENCY_OPS]; ///< Operations recorded.
+    unsigned long long max[CEIT_LATENCY_OPS];   ///< Slowest operation, in ticks.
 };
 
 /**
@@ -26,12 +161,75 @@ struct Memory {
  */
 struct Memchunk {
     char name[32];          ///< Name of the page for reference.
-    size_t total_size;      ///< Total size of the Page's memory.
+    size_t total_size;      ///< Total size of the Page's memory; for MEMC_MMAP, the committed part.
+    size_t reserve_size;    ///< Size the Page can reach; larger than total_size only for MEMC_MMAP.
     Memory* memory_pool;    ///< Head pointer to linked list of Memory blocks.
+    size_t free_lists[CEIT_SIZE_CLASSES];  ///< Offset of the first free block of each size class (floor(log2(size))), or for MEMC_BUDDY of each order.
+    unsigned long long free_map;           ///< Bit i is set when free_lists[i] is non-empty.
+    size_t* tlsf_lists;     ///< For MEMC_TLSF, 16 second-level lists per size class, replacing free_lists.
+    unsigned tlsf_maps[CEIT_SIZE_CLASSES]; ///< For MEMC_TLSF, bit j of entry i is set when list j of class i is non-empty.
+    size_t fit_root;        ///< For MEMC_BEST_FIT, offset of the root of the treap of free blocks, replacing free_lists.
+    size_t largest_free;    ///< Size of the largest block in free_lists or tlsf_lists; only an upper bound while largest_stale is set.
+    int largest_stale;      ///< Whether a block of size largest_free left the lists since it was last looked for.
+    Memname* name_index;    ///< Linear-probing index from block name to block.
+    char* name_text;        ///< Block names, CEIT_NAME_LEN bytes per name_index slot.
+    size_t name_capacity;   ///< Number of slots in name_index (a power of two).
+    size_t name_count;      ///< Number of named live blocks.
+    Memtag* tags;           ///< Tags of the named blocks, indexed by Memname::tag.
+    unsigned* tag_index;    ///< Linear-probing index from tag name to tag, UINT_MAX for empty slots.
+    size_t tag_count;       ///< Number of tags.
+    size_t tag_capacity;    ///< Room in tags; tag_index has twice as many slots (a power of two).
 
     size_t used_memory;     ///< Used memory in bytes.
     size_t free_memory;     ///< Free memory in bytes.
-    Memchunk* next;         ///< Pointer to the next page (if chaining pages).
+    Memchunk* next;         ///< Pointer to the next page (if chaining pages, see memc_set_growth).
+    Memchunk* global_next;  ///< Next Memchunk in global_memchunk_list.
+
+    unsigned flags;         ///< MEMC_* flags given at initialization.
+    unsigned long long id;  ///< Unique id, so thread caches can tell a reused address apart.
+    pthread_mutex_t lock;   ///< Serializes operations on a MEMC_THREAD_SAFE Memchunk.
+    struct Tcache* tcaches; ///< For MEMC_THREAD_SAFE, the thread caches of this Memchunk, whose counters memc_stats adds in.
+    size_t arena_top;       ///< Bytes handed out so far by a MEMC_ARENA Memchunk.
+    unsigned long long* arena_starts; ///< For MEMC_ARENA, bit i is set when an allocation starts i * CEIT_ALIGN bytes into the pool, up to arena_top; followed by the same map for named allocations.
+    int tail_free;          ///< Whether the last block of the memory pool is free.
+    size_t commit_unit;     ///< Granularity in which a MEMC_MMAP Memchunk commits its reservation.
+    unsigned huge_pages;    ///< 0, MEMC_HUGE_TRANSPARENT or MEMC_HUGE_EXPLICIT.
+
+    size_t purged_memory;   ///< Bytes returned to the OS by memc_trim and decay.
+    unsigned decay_ms;      ///< Time after which free memory is purged, or 0 (see memc_set_decay).
+    size_t decay_next;      ///< Time, in milliseconds, before which decay does not run again.
+    unsigned decay_polls;   ///< Locked allocations since decay last read the clock.
+    size_t arena_clean;     ///< Offset from which an arena's pages are purged or untouched.
+
+    pthread_mutex_t grow_lock; ///< Serializes growth and named allocation on a MEMC_THREAD_SAFE chain head.
+    size_t grow_size;       ///< Size of the next Memchunk the chain grows by.
+    double grow_factor;     ///< Growth factor between chained Memchunks; 0 when growth is off.
+    size_t grow_limit;      ///< Cap on chain_size, or 0 for none.
+    size_t chain_size;      ///< Total size of the chain headed by this Memchunk.
+
+    unsigned buddy_min_order;  ///< For MEMC_BUDDY, log2 of the smallest block size.
+    unsigned buddy_max_order;  ///< For MEMC_BUDDY, log2 of total_size, the size of the pool as one block.
+    unsigned long long* buddy_free; ///< For MEMC_BUDDY, bit i is set when a free block starts at slot i (slots are min-order blocks); owns the other buddy maps.
+    unsigned* buddy_requests;  ///< For MEMC_BUDDY, bytes requested for the block at each slot, in CEIT_ALIGN units.
+    unsigned char* buddy_orders; ///< For MEMC_BUDDY, order of the block starting at each slot, or 0.
+    size_t* buddy_names;       ///< For MEMC_BUDDY, name hash of the named block starting at each slot; allocated with the first name.
+    size_t requested_memory;   ///< For MEMC_BUDDY, bytes requested by live blocks; used_memory minus this is internal fragmentation.
+
+    Memstats stats;         ///< Counters kept on the allocation and free paths (see memc_stats).
+    Memlatency* latency;    ///< Latency histograms, created on first use when built with CEIT_LATENCY.
+    Memprofile* profile;    ///< Sampling heap profile of the chain, or NULL (see memc_set_profile).
+};
+
+/**
+ * @brief Pool of equally sized object slots carved from one Memchunk block.
+ * Free slots form a lock-free stack linked by 32-bit slot indices.
+ */
+struct Memslab {
+    unsigned long long head; ///< Free-list head: update tag in the high 32 bits, slot index in the low 32.
+    Memchunk* chunk;        ///< Memchunk the pool's block was allocated from.
+    char* slots;            ///< First slot.
+    size_t slot_size;       ///< Size of each slot in bytes.
+    size_t count;           ///< Number of slots.
 };
 
 /**
@@ -48,22 +246,303 @@ struct Memchunk {
  */
 Memchunk* memc_init(const char* name, size_t total_size);
 
+/**
+ * @brief Initializes a new memory Memchunk with the given behaviour flags.
+ * 
+ * Works like `memc_init`. With MEMC_THREAD_SAFE, the Memchunk may be shared
+ * by several threads: its operations are serialized by a per-Memchunk lock,
+ * and each thread keeps a small cache of freed blocks per size class so that
+ * most small anonymous allocations and frees do not take the lock at all.
+ * Cached blocks count as used in the statistics until they are flushed, see
+ * `memc_flush`. With MEMC_ARENA, the Memchunk is an arena as created by
+ * `memc_init_arena`. With MEMC_MMAP, the region is reserved with `mmap`
+ * but not backed, and pages are committed only as allocations reach them,
+ * so a multi-gigabyte Memchunk costs next to nothing until it is used.
+ * MEMC_HUGE_PAGES additionally backs the Memchunk with 2 MB pages, which
+ * cuts TLB misses for large, randomly accessed Memchunks. With MEMC_TLSF,
+ * finding a free block takes a bounded number of steps (two-level
+ * segregated fit), for a slightly less tight fit. With MEMC_BEST_FIT, a
+ * request always gets the smallest free block that fits, the lowest one
+ * among equals, found in O(log n) in a tree of free blocks. MEMC_BUDDY makes
+ * a buddy allocator as `memc_init_buddy` does, with 64-byte smallest blocks.
+ * 
+ * @param name The name of the Memchunk to initialize.
+ * @param total_size The total size of the memory Memchunk.
+ * @param flags A combination of MEMC_* flags, or 0.
+ * 
+ * @return A pointer to the initialized Memchunk structure, or NULL if memory 
+ *         allocation fails.
+ */
+Memchunk* memc_init_flags(const char* name, size_t total_size, unsigned flags);
+
+/**
+ * @brief Initializes a new arena Memchunk for data that is discarded all at once.
+ * 
+ * An arena hands out memory by bumping a pointer: allocations have no header
+ * and there is no free list. `memory_free` and `memory_free_ptr` do nothing
+ * on an arena; the whole arena is reclaimed at once with `memc_reset`. Names
+ * still work with `memory_find`.
+ * 
+ * @param name The name of the arena.
+ * @param total_size The total size of the arena.
+ * 
+ * @return A pointer to the initialized Memchunk structure, or NULL if memory 
+ *         allocation fails.
+ */
+Memchunk* memc_init_arena(const char* name, size_t total_size);
+
+/**
+ * @brief Initializes a new Memchunk managed as a binary buddy allocator.
+ * 
+ * Blocks are powers of two from 2^min_order bytes up to the pool, which is
+ * `total_size` rounded down to a power of two. Allocating splits a larger
+ * free block in halves and freeing merges a block with its buddy, both in
+ * O(log n) steps. Blocks have no header, so a power-of-two request takes a
+ * block of exactly its size, aligned to that size up to a page. `memc_dbg`
+ * reports the internal fragmentation of the rounding.
+ * 
+ * @param name The name of the Memchunk to initialize.
+ * @param total_size The size of the pool.
+ * @param min_order Log2 of the smallest block size; at least 4.
+ * 
+ * @return A pointer to the initialized Memchunk structure, or NULL if memory 
+ *         allocation fails.
+ */
+Memchunk* memc_init_buddy(const char* name, size_t total_size, unsigned min_order);
+
+/**
+ * @brief Opens a Memchunk kept in a file, creating the file if needed.
+ * 
+ * The file is mapped with `mmap` and holds the memory pool itself. Blocks
+ * are laid out back to back and free lists link them by offset, so the
+ * pool works at whatever address it is mapped. A new file is created with
+ * room for `total_size` bytes. An existing file is reopened as it was last
+ * left, and `total_size` is ignored; its free lists are rebuilt from the
+ * block headers. Blocks then keep their data at the same offsets, and names
+ * saved by `memc_sync` or `memc_dealloc` find them again with `memory_find`.
+ * 
+ * @param path The file to open or create.
+ * @param total_size The size of the memory pool of a new file.
+ * 
+ * @return A pointer to the Memchunk, or NULL if the file cannot be opened or
+ *         mapped, or does not hold a valid Memchunk.
+ */
+Memchunk* memc_open_file(const char* path, size_t total_size);
+
+/**
+ * @brief Saves a file-backed Memchunk's names and flushes it to the file.
+ * 
+ * When it returns, the file holds everything written to the Memchunk so
+ * far, and reopening it finds the named blocks live at this point. The
+ * names are kept in a block of the Memchunk, which counts as used until
+ * the file is reopened. `memc_dealloc` does the same before unmapping.
+ * 
+ * @param page The Memchunk returned by `memc_open_file`.
+ * 
+ * @return 0 on success, -1 if `page` is not file-backed, the names do not
+ *         fit in the Memchunk or the flush fails.
+ */
+int memc_sync(Memchunk* page);
+
+/**
+ * @brief Creates or attaches to a Memchunk in shared memory that several
+ * processes allocate from concurrently.
+ * 
+ * The Memchunk lives in the POSIX shared memory object `name`. The first
+ * process creates it with room for `total_size` bytes; later ones attach to
+ * it. Blocks are linked by offset and the allocator state sits with a
+ * process-shared lock in the object, so every process may allocate and free
+ * blocks. A block is handed to another process as `memc_offset` and turned
+ * back into a pointer there with `memc_pointer`, without copying. Blocks
+ * cannot be named and the Memchunk cannot grow. `memc_dealloc` detaches;
+ * the last process to detach removes the object.
+ * 
+ * If a process dies while holding the lock, the Memchunk is poisoned:
+ * allocations return NULL and frees are ignored until `memc_reset`.
+ * 
+ * @param name The name of the shared memory object.
+ * @param total_size The size of the memory pool if it is created, or 0 to
+ *                   only attach.
+ * 
+ * @return A pointer to this process's view of the Memchunk, or NULL if the
+ *         object cannot be created, opened or mapped.
+ */
+Memchunk* memc_init_shared(const char* name, size_t total_size);
+
+/**
+ * @brief Returns the offset of a block from the start of its Memchunk's pool.
+ * 
+ * The offset is valid wherever the pool is mapped, e.g. in another process
+ * attached to the same shared Memchunk.
+ * 
+ * @param page The Memchunk holding the block.
+ * @param ptr A pointer into the block's data.
+ * 
+ * @return The offset, or (size_t)-1 if `ptr` is not inside the Memchunk.
+ */
+size_t memc_offset(Memchunk* page, const void* ptr);
+
+/**
+ * @brief Returns the pointer at an offset given by `memc_offset`.
+ * 
+ * @param page The Memchunk, as mapped by the calling process.
+ * @param offset The offset of the block.
+ * 
+ * @return The pointer, or NULL if the offset is outside the Memchunk.
+ */
+void* memc_pointer(Memchunk* page, size_t offset);
+
+/**
+ * @brief Lets a Memchunk grow by chaining new Memchunks when it runs out of space.
+ * 
+ * Once enabled, an allocation that does not fit in the Memchunk is tried in
+ * the Memchunks chained after it through `next`. If none has room, a new
+ * Memchunk with the same flags is created and appended. The first one has
+ * `initial_size` bytes and each following one is `growth_factor` times
+ * larger, or just large enough for the request. Frees find the chain member
+ * that owns a block by address, and `memc_dbg` reports totals for the
+ * whole chain. Chain members are released with the head. A file-backed
+ * or shared Memchunk cannot grow.
+ * 
+ * @param page The head of the chain.
+ * @param initial_size The size of the first added Memchunk, or 0 to use the
+ *                     head's size.
+ * @param growth_factor How much larger each added Memchunk is than the
+ *                      previous one; at least 1.
+ * @param max_size The cap on the total size of the chain, or 0 for no cap.
+ * 
+ * @return 0 on success, -1 if the arguments are invalid or the Memchunk is
+ *         file-backed or shared.
+ */
+int memc_set_growth(Memchunk* page, size_t initial_size, double growth_factor, size_t max_size);
+
+/**
+ * @brief Turns on time-based purging of memory that stays free.
+ * 
+ * A free block of at least one page that stays free for `decay_ms`
+ * milliseconds has its whole pages returned to the OS, as `memc_trim` does.
+ * Decay is lazy: it runs, at most every quarter of `decay_ms`, when a
+ * large block is freed, on every 64th allocation that takes the lock, and
+ * from `memc_stats`. A Memchunk that sees none of these calls never decays;
+ * call `memc_trim` or `memc_stats` from a timer to purge an idle one. Arenas
+ * are only purged by `memc_trim`. The setting applies to the whole growth
+ * chain.
+ * 
+ * @param page The Memchunk to configure.
+ * @param decay_ms How long memory stays free before it is purged, or 0 to
+ *                 turn decay off.
+ * 
+ * @return 0 on success, -1 if `page` is NULL.
+ */
+int memc_set_decay(Memchunk* page, unsigned decay_ms);
+
+/**
+ * @brief Frees everything allocated from a Memchunk at once.
+ * 
+ * For an arena this only rewinds its top pointer, which is O(1). Any other
+ * Memchunk is turned back into a single free block. Named blocks are dropped
+ * from the name index in both cases. Every Memchunk of a growth chain is
+ * reset, and they all stay available for reuse.
+ * 
+ * WARNING: Every pointer previously returned by the Memchunk becomes invalid,
+ * and no other thread may use the Memchunk during the call.
+ * 
+ * @param page The Memchunk to reset.
+ */
+void memc_reset(Memchunk* page);
+
+/**
+ * @brief Returns the free memory of a Memchunk to the OS.
+ * 
+ * Every free block has the whole pages inside it released with
+ * `madvise(MADV_DONTNEED)`; for an arena, the pages above its top are. The
+ * pages read back as zero when they are allocated again. The bytes purged
+ * are added to `purged_memory`.
+ * 
+ * @param page The Memchunk to trim, along with its growth chain.
+ * 
+ * @return The number of bytes returned to the OS.
+ */
+size_t memc_trim(Memchunk* page);
+
 /**
  * @brief Allocates memory from the Memchunk's memory pool.
  * 
- * This function searches for the best-fit memory block in the pool that is large
- * enough to satisfy the request and allocates it. If the block is larger than 
- * necessary, it is split. The allocated memory block is marked as used, and 
- * the Memchunk's used/free memory statistics are updated.
+ * This function looks up a free block large enough to satisfy the request in
+ * the Memchunk's size-class free lists and allocates it. Only free blocks are
+ * visited, so the lookup does not depend on the number of allocated blocks.
+ * If the block is larger than necessary, it is split. The allocated memory
+ * block is marked as used, and the Memchunk's used/free memory statistics
+ * are updated. The returned pointer is aligned to CEIT_ALIGN, which satisfies
+ * `max_align_t`.
  * 
  * @param page The Memchunk from which memory is allocated.
  * @param size The size of the memory block to allocate.
- * @param block_name The name of the allocated memory block.
+ * @param block_name The name of the allocated memory block, or NULL for an
+ *                   anonymous block that can only be freed by pointer. Names
+ *                   are unique within a Memchunk; only the first 31 characters
+ *                   are kept.
  * 
- * @return A pointer to the allocated memory block, or NULL if allocation fails.
+ * @return A pointer to the allocated memory block, or NULL if allocation fails
+ *         or a live block in the Memchunk already has the same name.
  */
 void* memory_alloc(Memchunk* page, size_t size, const char* block_name);
 
+/**
+ * @brief Allocates memory whose data pointer is a multiple of `align`.
+ * 
+ * Works like `memory_alloc`, but places the block so that its data starts on
+ * an `align`-byte boundary, e.g. 64 for a cache line or 4096 for a page. The
+ * padding in front of the block is split off and returned to the free lists
+ * as a block of its own, so only the space that alignment really needs is
+ * consumed.
+ * 
+ * @param page The Memchunk from which memory is allocated.
+ * @param size The size of the memory block to allocate.
+ * @param align The required alignment, a power of two. Values below
+ *              CEIT_ALIGN are raised to it.
+ * @param block_name The name of the allocated memory block, or NULL.
+ * 
+ * @return A pointer to the aligned memory block, or NULL if allocation fails,
+ *         `align` is not a power of two, or the name is already in use.
+ */
+void* memory_alloc_aligned(Memchunk* page, size_t size, size_t align, const char* block_name);
+
+/**
+ * @brief Allocates zero-initialized memory for an array of `count` elements.
+ * 
+ * Works like `memory_alloc`, but the returned data is zero. Free memory that
+ * is known to be zero, because it was never handed out since it was mapped
+ * (MEMC_MMAP) or was purged by `memc_trim` or decay, is not cleared again,
+ * so its untouched pages are not faulted in.
+ * 
+ * @param page The Memchunk from which memory is allocated.
+ * @param count The number of elements.
+ * @param size The size of each element.
+ * @param block_name The name of the allocated memory block, or NULL.
+ * 
+ * @return A pointer to the zeroed memory block, or NULL if allocation fails,
+ *         `count * size` overflows or the name is already in use.
+ */
+void* memory_calloc(Memchunk* page, size_t count, size_t size, const char* block_name);
+
+/**
+ * @brief Allocates several anonymous blocks with a single search and lock.
+ * 
+ * When one free block is large enough for the whole batch, the blocks are
+ * carved out of it back to back and the counters are updated once.
+ * Otherwise they are allocated one by one under the same lock. Either all
+ * blocks are allocated or none is.
+ * 
+ * @param page The Memchunk from which memory is allocated.
+ * @param n The number of blocks.
+ * @param sizes The size of each block; none may be 0.
+ * @param out Receives the data pointer of each block.
+ * 
+ * @return 0 on success, or -1 if the batch could not be allocated.
+ */
+int memory_alloc_batch(Memchunk* page, size_t n, const size_t* sizes, void** out);
+
 /**
  * @brief Writes data to the allocated memory block.
  * 
@@ -99,13 +578,147 @@ int memory_read(const void* mem_block, void* buffer, size_t size);
  * 
  * This function frees the memory block with the specified name and updates 
  * the Memchunk's used and free memory statistics. If adjacent free memory 
- * blocks exist, they will be coalesced to form a larger free block.
+ * blocks exist, they will be coalesced to form a larger free block. Only the
+ * block's two physical neighbours are inspected, so coalescing is O(1). The
+ * block is found through the Memchunk's name index, also in O(1).
  * 
  * @param page The Memchunk to free the memory from.
  * @param block_name The name of the memory block to free.
  */
 void memory_free(Memchunk* page, const char* block_name);
 
+/**
+ * @brief Looks up a live memory block by name.
+ * 
+ * The lookup goes through the Memchunk's name index and takes O(1) on
+ * average, independent of the number of blocks.
+ * 
+ * @param page The Memchunk to search.
+ * @param block_name The name given to `memory_alloc`.
+ * 
+ * @return The block's data pointer, or NULL if no live block has that name.
+ */
+void* memory_find(Memchunk* page, const char* block_name);
+
+/**
+ * @brief Frees the memory block at the given data pointer.
+ * 
+ * The block header sits at a fixed offset before the pointer returned by
+ * `memory_alloc`, so the block is found and freed in O(1) without looking at
+ * its name. Pointers outside the Memchunk and blocks that are already free
+ * are ignored.
+ * 
+ * @param page The Memchunk the block was allocated from.
+ * @param ptr The pointer returned by `memory_alloc`.
+ */
+void memory_free_ptr(Memchunk* page, void* ptr);
+
+/**
+ * @brief Frees several blocks, taking each Memchunk's lock once.
+ * 
+ * The blocks go straight back to the free lists, bypassing the thread
+ * caches. NULL entries and unknown or already free blocks are ignored.
+ * 
+ * @param page The Memchunk the blocks were allocated from.
+ * @param ptrs The pointers to free.
+ * @param n The number of pointers.
+ */
+void memory_free_batch(Memchunk* page, void** ptrs, size_t n);
+
+/**
+ * @brief Changes the size of an allocated block, moving it only if needed.
+ * 
+ * The block is resized in place whenever possible: shrinking splits off its
+ * tail, and growing absorbs a free block right after it. Only when neither
+ * works is a new block allocated, the data copied and the old block freed.
+ * A named block keeps its name when it moves. In an arena, an anonymous
+ * block shrinks in place and the last block grows in place by moving the
+ * top; other blocks move, and the old copy stays until the arena is reset.
+ * A moved block is aligned to CEIT_ALIGN.
+ * 
+ * @param page The Memchunk the block was allocated from.
+ * @param ptr The pointer returned by `memory_alloc`, or NULL to allocate a
+ *            new anonymous block.
+ * @param size The new size of the block, or 0 to free it.
+ * 
+ * @return The new data pointer, which may equal `ptr`, or NULL if there is
+ *         not enough memory; in that case the old block is left untouched.
+ */
+void* memory_realloc(Memchunk* page, void* ptr, size_t size);
+
+/**
+ * @brief Frees the memory block at the given data pointer without naming its Memchunk.
+ * 
+ * The owning Memchunk is found by address among the registered Memchunks,
+ * and the block is then freed as with `memory_free_ptr`.
+ * 
+ * @param ptr The pointer returned by `memory_alloc`.
+ */
+void mem_free(void* ptr);
+
+/**
+ * @brief Returns the calling thread's cached blocks to the Memchunk.
+ * 
+ * In a MEMC_THREAD_SAFE Memchunk, blocks freed by a thread may wait in that
+ * thread's cache and still count as used. This hands them back so that they
+ * can be coalesced and the statistics are exact for this thread. Caches are
+ * also flushed automatically when a thread exits. Does nothing for other
+ * Memchunks.
+ * 
+ * @param page The Memchunk whose cached blocks to return.
+ */
+void memc_flush(Memchunk* page);
+
+/**
+ * @brief Creates a pool of equally sized slots carved from a Memchunk.
+ * 
+ * The pool takes a single block from the Memchunk and splits it into `count`
+ * slots of `obj_size` bytes with no per-object header. Free slots form a
+ * lock-free stack, so `memslab_alloc` and `memslab_free` may be called from
+ * several threads at once without taking any lock.
+ * 
+ * @param chunk The Memchunk to carve the pool from.
+ * @param obj_size The size of each object in bytes.
+ * @param count The number of objects the pool holds.
+ * 
+ * @return A pointer to the new Memslab, or NULL if the Memchunk has no room
+ *         or the arguments are invalid.
+ */
+Memslab* memslab_create(Memchunk* chunk, size_t obj_size, size_t count);
+
+/**
+ * @brief Takes an object slot from the pool.
+ * 
+ * Lock-free: the head of the free list is swapped with a compare-and-swap on
+ * a (tag, index) pair. The tag changes on every update, so a head that was
+ * popped and pushed back in between (the ABA problem) is still detected.
+ * 
+ * @param slab The Memslab to allocate from.
+ * 
+ * @return A pointer to an uninitialized slot, or NULL if the pool is empty.
+ */
+void* memslab_alloc(Memslab* slab);
+
+/**
+ * @brief Returns an object slot to the pool.
+ * 
+ * Lock-free, like `memslab_alloc`. Pointers that do not point at a slot of
+ * this pool are ignored.
+ * 
+ * @param slab The Memslab the object was allocated from.
+ * @param ptr The pointer returned by `memslab_alloc`.
+ */
+void memslab_free(Memslab* slab, void* ptr);
+
+/**
+ * @brief Releases the pool's block back to its Memchunk.
+ * 
+ * WARNING: No thread may use the pool or any of its objects afterwards.
+ * 
+ * @param slab The Memslab to destroy.
+ */
+void memslab_destroy(Memslab* slab);
+
 /**
  * @brief Deallocates the memory Memchunk.
  * 
@@ -117,11 +730,104 @@ void memory_free(Memchunk* page, const char* block_name);
  */
 void memc_dealloc(Memchunk* page);
 
+/**
+ * @brief Reads the statistics of a Memchunk and its growth chain.
+ * 
+ * Counters are kept as blocks are allocated and freed, and so is the size
+ * of the largest free block, so reading them does not walk the blocks: the
+ * cost is a lock per chain member. Only when the largest free block left
+ * the free lists since the last read, and for shared Memchunks, is the top
+ * size class walked to find the new one. It is cheap enough to poll
+ * periodically in production, unlike `memc_dbg`.
+ * 
+ * @param page The Memchunk to read.
+ * @param stats Receives the statistics.
+ * 
+ * @return 0 on success, -1 if an argument is NULL.
+ */
+int memc_stats(Memchunk* page, Memstats* stats);
+
+/**
+ * @brief Reads, and optionally resets, the latency histograms of a Memchunk.
+ * 
+ * Only available when the library is built with `-DCEIT_LATENCY`. Every
+ * `memory_alloc`, `memory_free`, `memory_free_ptr` and `memory_realloc`
+ * then records its latency, in cycle-counter ticks, into the histograms of
+ * the Memchunk passed to it. Without the define, the calls are not timed
+ * at all.
+ * 
+ * @param page The Memchunk to read.
+ * @param snapshot Receives the histograms.
+ * @param reset Non-zero to clear the histograms as they are read.
+ * 
+ * @return 0 on success, -1 if an argument is NULL or the library was built
+ *         without CEIT_LATENCY.
+ */
+int memc_latency(Memchunk* page, Memlatency* snapshot, int reset);
+
+/**
+ * @brief Returns the latency below which a percentile of an operation's
+ * calls completed.
+ * 
+ * @param latency Histograms from `memc_latency`.
+ * @param op MEMC_OP_ALLOC, MEMC_OP_FREE or MEMC_OP_REALLOC.
+ * @param percentile The percentile, from 0 to 100, e.g. 99.9.
+ * 
+ * @return The upper bound, in ticks, of the bucket holding the percentile,
+ *         or 0 if no call was recorded.
+ */
+unsigned long long memlatency_percentile(const Memlatency* latency, unsigned op, double percentile);
+
+/**
+ * @brief Starts, retunes or stops the sampling heap profiler of a Memchunk.
+ * 
+ * One allocation is sampled, with its stack trace, every `sample_bytes`
+ * requested bytes on average, and tracked until it is freed. Stopping with
+ * 0 keeps what was recorded. Call this before other threads use the
+ * Memchunk.
+ * 
+ * @param page The Memchunk to profile, along with its growth chain.
+ * @param sample_bytes Mean number of bytes between two samples, e.g.
+ *                     CEIT_PROFILE_RATE, or 0 to stop sampling.
+ * 
+ * @return 0 on success, -1 if `page` is NULL or shared, or the profile
+ *         could not be allocated.
+ */
+int memc_set_profile(Memchunk* page, size_t sample_bytes);
+
+/**
+ * @brief Reports the memory of a Memchunk by tag, largest first.
+ * 
+ * Named blocks are counted under their tag, their name without a trailing
+ * number, as they are allocated and freed, so the report does not walk the
+ * blocks. The tags of a growth chain are merged.
+ * 
+ * @param page The Memchunk to read.
+ * @param tags Receives up to `max` tags, by live bytes in decreasing order.
+ * @param max The number of entries in `tags`.
+ * 
+ * @return The number of entries written.
+ */
+size_t memc_tag_stats(Memchunk* page, Memtag* tags, size_t max);
+
+/**
+ * @brief Writes the live and cumulative heap profile of a Memchunk in the
+ * gperftools `heap_v2` text format, for `pprof`.
+ * 
+ * @param page The profiled Memchunk.
+ * @param path The file to write.
+ * 
+ * @return 0 on success, -1 if an argument is NULL, the Memchunk was never
+ *         profiled, or the file could not be written.
+ */
+int memc_profile_dump(Memchunk* page, const char* path);
+
 /**
  * @brief Debug function to display the status of multiple Memchunks.
  * 
  * This function prints details of each Memchunk, including its total size, used 
- * memory, free memory, and the memory blocks inside it.
+ * memory, free memory, and the memory blocks inside it. For a Memchunk that
+ * grew a chain, the totals cover the whole chain and each member is listed.
  * 
  * @param num_pages The number of Memchunks to display.
  */
@@ -130,7 +836,8 @@ void memc_dbg(int num_pages, ...);
 /**
  * @brief Debug function to display details of memory blocks.
  * 
- * This function prints details of the specified memory blocks.
+ * This function prints details of the specified memory blocks, given as the
+ * pointers returned by `memory_alloc`.
  * 
  * @param num_mem The number of memory blocks to display.
  */
@@ -1,68 +1,2977 @@
+// Linux and POSIX extensions (madvise, rwlocks, robust mutexes, strnlen) must be visible in strict C modes
+#define _GNU_SOURCE
+
 #include "ceit.h"
 #include <stdio.h>
 #include <stdarg.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <limits.h>
+#include <execinfo.h>
+#if defined(CEIT_LATENCY) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#endif
+
+/** Global pointer to the head of the Memchunk list. */
+Memchunk* global_memchunk_list = NULL;
+
+/** Guards global_memchunk_list; lookups by address only take it for reading. */
+static pthread_rwlock_t global_memchunk_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+/** Source of Memchunk::id values; taken with an atomic increment, so no lock guards it. */
+static unsigned long long next_memchunk_id = 1;
+
+/** Number of blocks probed in a request's own size class before moving up a class. */
+#define CEIT_FIT_PROBES 4
+
+/** Initial number of slots in a Memchunk's name index (a power of two). */
+#define CEIT_NAME_INDEX_MIN 64
+
+/** Largest block size served from the per-thread caches. */
+#define CEIT_TCACHE_MAX 1024
+
+/** Number of per-thread cache bins, one per CEIT_ALIGN step up to CEIT_TCACHE_MAX. */
+#define CEIT_TCACHE_BINS (CEIT_TCACHE_MAX / CEIT_ALIGN + 1)
+
+/** Number of blocks a per-thread cache bin can hold. */
+#define CEIT_TCACHE_DEPTH 16
+
+/** Number of blocks moved between a per-thread cache bin and its Memchunk at once. */
+#define CEIT_TCACHE_BATCH 8
+
+/** Number of thread-safe Memchunks a thread keeps caches for. */
+#define CEIT_TCACHE_CHUNKS 4
+
+/**
+ * Memory::name_hash of an allocated block that waits in a thread's cache, so
+ * freeing it again is caught. Its low bits rule out a free-list link or
+ * CEIT_NIL, and its top bit a free block's state, so stale header bytes do
+ * not pass for it.
+ */
+#define CEIT_TCACHE_HELD ((size_t)0xcac4ed0b10c4ed07ULL)
+
+/** Smallest step, in bytes, by which a MEMC_MMAP Memchunk commits more of its reservation. */
+#define CEIT_COMMIT_MIN (64 * 1024)
+
+/** Size of the huge pages a MEMC_HUGE_PAGES Memchunk is backed with. */
+#define CEIT_HUGE_PAGE (2 * 1024 * 1024)
+
+/** Number of locked allocations between two decay checks that no free triggered. */
+#define CEIT_DECAY_POLL 64
+
+/** Free block state, kept in Memory::name_hash: the block's whole pages were returned to the OS. */
+#define CEIT_FREE_PURGED 0x1
+
+/** Free block state: the block's data is zero apart from its free-list links and footer. */
+#define CEIT_FREE_ZERO 0x2
+
+/** Position, in a free block's state, of the time in milliseconds at which it was last dirtied. */
+#define CEIT_FREE_STAMP_SHIFT 2
+
+/** Log2 of the number of second-level free lists per size class of a MEMC_TLSF Memchunk. */
+#define CEIT_TLSF_SL_LOG 4
+
+/** Number of second-level free lists per size class of a MEMC_TLSF Memchunk. */
+#define CEIT_TLSF_SL (1 << CEIT_TLSF_SL_LOG)
+
+/** Smallest order of a MEMC_BUDDY Memchunk: a free block must hold its free-list links. */
+#define CEIT_BUDDY_MIN_ORDER 4
+
+/** Order of the smallest blocks of a Memchunk created with the MEMC_BUDDY flag. */
+#define CEIT_BUDDY_ORDER 6
+
+/** Memchunk::buddy_orders bit: the block has an entry in the name index. */
+#define CEIT_BUDDY_NAMED 0x80
+
+/** Magic bytes at the start of a file written by memc_open_file. */
+#define CEIT_FILE_MAGIC "CEITHEAP"
+
+/** Layout version of Memchunk files, changed whenever blocks or the file header change. */
+#define CEIT_FILE_VERSION 1
+
+/** Magic bytes at the start of a shared memory object created by memc_init_shared. */
+#define CEIT_SHARED_MAGIC "CEITSHM"
+
+/** Layout version of shared Memchunks; processes of different versions do not attach. */
+#define CEIT_SHARED_VERSION 2
+
+/** Longest time, in milliseconds, an attaching process waits for the creator to finish. */
+#define CEIT_SHARED_WAIT_MS 1000
+
+/** Number of return addresses kept per sampled allocation. */
+#define CEIT_PROFILE_DEPTH 32
+
+/** Number of counters in a heap profile's filter of sampled addresses (a power of two). */
+#define CEIT_PROFILE_FILTER 16384
+
+/** Initial number of slots of a heap profile's sample and site tables (a power of two). */
+#define CEIT_PROFILE_TABLE_MIN 256
+
+/** Null value for free-list offsets. */
+#define CEIT_NIL ((size_t)-1)
+
+/**
+ * @brief Free-list links stored in the payload of a free block.
+ *
+ * Links are offsets from the start of the memory pool rather than pointers.
+ */
+typedef struct FreeLinks {
+    size_t prev_free;       ///< Offset of the previous free block of the same size class.
+    size_t next_free;       ///< Offset of the next free block of the same size class.
+} FreeLinks;
+
+/**
+ * @brief Tree links stored in the payload of a free block of a MEMC_BEST_FIT
+ * Memchunk, in place of its FreeLinks.
+ */
+typedef struct FitNode {
+    size_t left;            ///< Offset of the subtree of smaller (size, address) keys.
+    size_t right;           ///< Offset of the subtree of larger (size, address) keys.
+} FitNode;
+
+_Static_assert(sizeof(FitNode) <= sizeof(FreeLinks), "tree links must fit where free-list links do");
+
+/**
+ * @brief Header of a Memchunk file, in the page before the memory pool.
+ *
+ * Only what the block headers cannot tell is kept: the free lists are
+ * rebuilt from the blocks when the file is opened.
+ */
+typedef struct FileHeader {
+    char magic[8];          ///< CEIT_FILE_MAGIC.
+    unsigned version;       ///< CEIT_FILE_VERSION.
+    unsigned align;         ///< CEIT_ALIGN of the library that wrote the file.
+    size_t page;            ///< Page size, and offset of the memory pool in the file.
+    size_t file_size;       ///< Size of the whole file.
+    size_t names;           ///< Offset of the block holding the saved names, or CEIT_NIL.
+    size_t name_count;      ///< Number of saved names.
+} FileHeader;
+
+/**
+ * @brief A named block, as saved in a Memchunk file by memc_sync.
+ */
+typedef struct FileName {
+    size_t offset;          ///< Offset of the block header from the start of the memory pool.
+    char name[CEIT_NAME_LEN]; ///< The block name, null-terminated.
+} FileName;
+
+/**
+ * @brief Header of a shared Memchunk, in the page before the memory pool.
+ *
+ * It holds the process-shared lock and the allocator state that every
+ * attached process works on. Each process copies the state into its own
+ * Memchunk when it takes the lock and back when it releases it.
+ */
+typedef struct SharedHeader {
+    char magic[8];          ///< CEIT_SHARED_MAGIC, written last by the creator.
+    unsigned version;       ///< CEIT_SHARED_VERSION.
+    unsigned align;         ///< CEIT_ALIGN of the creating library.
+    size_t page;            ///< Page size, and offset of the memory pool in the object.
+    size_t map_size;        ///< Size of the whole object.
+    char path[64];          ///< Name of the object for shm_open and shm_unlink.
+    pthread_mutex_t lock;   ///< Process-shared, robust lock over everything below.
+    size_t attached;        ///< Number of processes that have the object mapped.
+    int closed;             ///< Set when the last process detached and the name was unlinked.
+    int poisoned;           ///< Set when a process died holding the lock, possibly halfway through a change.
+    int tail_free;          ///< Shared copy of Memchunk::tail_free.
+    size_t free_lists[CEIT_SIZE_CLASSES]; ///< Shared copy of Memchunk::free_lists.
+    unsigned long long free_map; ///< Shared copy of Memchunk::free_map.
+    size_t used_memory;     ///< Shared copy of Memchunk::used_memory.
+    size_t free_memory;     ///< Shared copy of Memchunk::free_memory.
+    size_t purged_memory;   ///< Shared copy of Memchunk::purged_memory.
+    Memstats stats;         ///< Shared copy of Memchunk::stats.
+} SharedHeader;
+
+/**
+ * @brief An allocation site of a heap profile: a distinct stack trace, with
+ * the sampled allocations made from it.
+ */
+typedef struct ProfileSite {
+    size_t hash;            ///< Hash of the stack trace.
+    int depth;              ///< Number of return addresses in frames.
+    void* frames[CEIT_PROFILE_DEPTH]; ///< Return addresses, innermost first.
+    size_t live_count;      ///< Sampled allocations from here that are not freed yet.
+    size_t live_bytes;      ///< Bytes requested by them.
+    size_t alloc_count;     ///< Sampled allocations from here so far.
+    size_t alloc_bytes;     ///< Bytes requested by them.
+} ProfileSite;
+
+/**
+ * @brief A sampled allocation that is not freed yet.
+ */
+typedef struct ProfileSample {
+    const void* ptr;        ///< Data pointer of the block, or NULL for an empty slot.
+    size_t size;            ///< Bytes requested.
+    size_t site;            ///< Index of its site in Memprofile::sites.
+} ProfileSample;
+
+/**
+ * @brief Sampling heap profile of a Memchunk and its growth chain (see memc_set_profile).
+ *
+ * Live samples are found by address in an open-addressing table. Frees
+ * first check a counting filter of the sampled addresses, without the
+ * lock, so the table is only searched for sampled blocks and the few
+ * others that share their filter counter.
+ */
+struct Memprofile {
+    pthread_mutex_t lock;   ///< Guards everything below but the filter reads and the rate.
+    size_t rate;            ///< Mean number of bytes allocated between two samples, or 0 when stopped.
+    ProfileSample* samples; ///< Live samples, by address.
+    size_t sample_capacity; ///< Number of slots in samples (a power of two).
+    size_t sample_count;    ///< Number of live samples.
+    ProfileSite* sites;     ///< Allocation sites, in order of first sample.
+    size_t site_count;      ///< Number of sites.
+    size_t* site_index;     ///< Open-addressing index from stack hash to site, CEIT_NIL for empty slots.
+    size_t site_capacity;   ///< Number of slots in site_index and of room in sites (a power of two).
+    unsigned char filter[CEIT_PROFILE_FILTER]; ///< Live samples per address slot, sticky at UCHAR_MAX.
+};
+
+/** Rounds `value` up to a multiple of the power of two `align`. */
+#define CEIT_ROUND_UP(value, align) (((value) + (align) - 1) & ~(size_t)((align) - 1))
+
+/** Smallest payload a block can have: its free-list links plus the size footer. */
+#define CEIT_MIN_PAYLOAD CEIT_ROUND_UP(sizeof(FreeLinks) + sizeof(size_t), CEIT_ALIGN)
+
+_Static_assert(CEIT_ALIGN >= _Alignof(max_align_t), "CEIT_ALIGN must satisfy max_align_t");
+_Static_assert(sizeof(Memory) % CEIT_ALIGN == 0, "block data must stay CEIT_ALIGN-aligned");
+_Static_assert(sizeof(FreeLinks) <= (1 << CEIT_BUDDY_MIN_ORDER), "a free buddy block must hold its links");
+
+/**
+ * @brief Returns the payload size of a block, without its flag bits.
+ */
+static size_t block_size(const Memory* block) {
+    return block->size & ~(size_t)CEIT_BLOCK_FLAGS;
+}
+
+/**
+ * @brief Sets the payload size of a block, keeping its flag bits.
+ */
+static void block_set_size(Memory* block, size_t size) {
+    block->size = size | (block->size & CEIT_BLOCK_FLAGS);
+}
+
+/**
+ * @brief Returns the header of the block at `offset` bytes into the memory pool.
+ */
+static Memory* block_at(const Memchunk* Memchunk, size_t offset) {
+    return (Memory*)((char*)Memchunk->memory_pool + offset);
+}
+
+/**
+ * @brief Returns the offset of a block header from the start of the memory pool.
+ */
+static size_t block_offset(const Memchunk* Memchunk, const Memory* block) {
+    return (size_t)((const char*)block - (const char*)Memchunk->memory_pool);
+}
+
+/**
+ * @brief Returns the free-list links kept in a free block's payload.
+ */
+static FreeLinks* block_links(Memory* block) {
+    return (FreeLinks*)(block + 1);
+}
+
+/**
+ * @brief Returns the physically next block, or NULL for the last block.
+ */
+static Memory* block_next(const Memchunk* Memchunk, const Memory* block) {
+    const char* next = (const char*)(block + 1) + block_size(block);
+    const char* end = (const char*)(Memchunk->memory_pool + 1) + Memchunk->total_size;
+    return next < end ? (Memory*)next : NULL;
+}
+
+/**
+ * @brief Returns the physically previous block, which must be free.
+ *
+ * A free block keeps its size in a footer at the end of its payload, right
+ * before the next header, so it can be found from its successor.
+ */
+static Memory* block_prev_free(Memory* block) {
+    size_t prev_size = ((size_t*)block)[-1];
+    return (Memory*)((char*)block - prev_size - sizeof(Memory));
+}
+
+/**
+ * @brief Sets or clears the PREV_FREE flag of a block.
+ *
+ * The block may be allocated and read by its owner without the Memchunk's
+ * lock (see memory_free_ptr), so the word is stored atomically. Writers
+ * still hold the lock, and a relaxed store is a plain store on common targets.
+ */
+static void block_set_prev_free(Memory* block, int prev_free) {
+    size_t word = block->size;
+    word = prev_free ? word | CEIT_BLOCK_PREV_FREE : word & ~(size_t)CEIT_BLOCK_PREV_FREE;
+    __atomic_store_n(&block->size, word, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Flags a block as free: writes its footer and tells its successor.
+ */
+static void mark_free(Memchunk* Memchunk, Memory* block) {
+    block->size |= CEIT_BLOCK_FREE;
+    *(size_t*)((char*)(block + 1) + block_size(block) - sizeof(size_t)) = block_size(block);
+    Memory* next = block_next(Memchunk, block);
+    if (next) block_set_prev_free(next, 1);
+    else Memchunk->tail_free = 1;
+}
+
+/**
+ * @brief Flags a block as allocated and tells its successor.
+ */
+static void mark_used(Memchunk* Memchunk, Memory* block) {
+    block->size &= ~(size_t)CEIT_BLOCK_FREE;
+    Memory* next = block_next(Memchunk, block);
+    if (next) block_set_prev_free(next, 0);
+    else Memchunk->tail_free = 0;
+}
+
+/**
+ * @brief Returns the size class of a block size: floor(log2(size)).
+ */
+static int size_class(size_t size) {
+    return 63 - __builtin_clzll((unsigned long long)size);
+}
+
+/**
+ * @brief Returns the second-level list of a block size within its size class
+ * (TLSF): the next CEIT_TLSF_SL_LOG bits below the top bit.
+ */
+static int tlsf_second(size_t size, int cls) {
+    return (int)(size >> (cls - CEIT_TLSF_SL_LOG)) & (CEIT_TLSF_SL - 1);
+}
+
+/**
+ * @brief Returns the tree links of the free block at `offset` (MEMC_BEST_FIT).
+ */
+static FitNode* fit_node(const Memchunk* Memchunk, size_t offset) {
+    return (FitNode*)(block_at(Memchunk, offset) + 1);
+}
+
+/**
+ * @brief Checks whether the key (size, offset) comes before the free block at
+ * `node`: free blocks are ordered by size, then address, as a best-fit scan
+ * in address order would pick them.
+ */
+static int fit_less(const Memchunk* Memchunk, size_t size, size_t offset, size_t node) {
+    size_t node_size = block_size(block_at(Memchunk, node));
+    return size < node_size || (size == node_size && offset < node);
+}
+
+/**
+ * @brief Returns the heap priority of a tree node: a hash of its offset, so
+ * the treap stays balanced in expectation without storing anything.
+ */
+static size_t fit_priority(size_t offset) {
+    unsigned long long x = offset;
+    x = (x ^ (x >> 33)) * 0xff51afd7ed558ccdULL;
+    x = (x ^ (x >> 33)) * 0xc4ceb9fe1a85ec53ULL;
+    return (size_t)(x ^ (x >> 33));
+}
+
+/**
+ * @brief Inserts the free block at `offset`, of `size` bytes, into the treap
+ * rooted at `root`, rotating it up while its priority is higher; returns the
+ * new root.
+ */
+static size_t fit_insert(Memchunk* Memchunk, size_t root, size_t offset, size_t size) {
+    if (root == CEIT_NIL) return offset;
+
+    FitNode* node = fit_node(Memchunk, root);
+    if (fit_less(Memchunk, size, offset, root)) {
+        node->left = fit_insert(Memchunk, node->left, offset, size);
+        if (fit_priority(node->left) > fit_priority(root)) {
+            size_t child = node->left;
+            node->left = fit_node(Memchunk, child)->right;
+            fit_node(Memchunk, child)->right = root;
+            return child;
+        }
+    } else {
+        node->right = fit_insert(Memchunk, node->right, offset, size);
+        if (fit_priority(node->right) > fit_priority(root)) {
+            size_t child = node->right;
+            node->right = fit_node(Memchunk, child)->left;
+            fit_node(Memchunk, child)->left = root;
+            return child;
+        }
+    }
+    return root;
+}
+
+/**
+ * @brief Joins two treaps whose keys are all smaller in `a` than in `b`.
+ */
+static size_t fit_merge(Memchunk* Memchunk, size_t a, size_t b) {
+    if (a == CEIT_NIL) return b;
+    if (b == CEIT_NIL) return a;
+    if (fit_priority(a) > fit_priority(b)) {
+        fit_node(Memchunk, a)->right = fit_merge(Memchunk, fit_node(Memchunk, a)->right, b);
+        return a;
+    }
+    fit_node(Memchunk, b)->left = fit_merge(Memchunk, a, fit_node(Memchunk, b)->left);
+    return b;
+}
+
+/**
+ * @brief Removes the free block at `offset` from the treap rooted at `root`;
+ * returns the new root. The block's size must not have changed since it was
+ * inserted.
+ */
+static size_t fit_remove(Memchunk* Memchunk, size_t root, size_t offset, size_t size) {
+    FitNode* node = fit_node(Memchunk, root);
+    if (root == offset) return fit_merge(Memchunk, node->left, node->right);
+    if (fit_less(Memchunk, size, offset, root)) node->left = fit_remove(Memchunk, node->left, offset, size);
+    else node->right = fit_remove(Memchunk, node->right, offset, size);
+    return root;
+}
+
+/**
+ * @brief Pushes a free block onto the free list of its size class, or into
+ * the tree of a MEMC_BEST_FIT Memchunk.
+ */
+static void freelist_insert(Memchunk* Memchunk, Memory* block) {
+    Memchunk->stats.free_blocks++;
+    if (Memchunk->flags & MEMC_BEST_FIT) {
+        FitNode* node = (FitNode*)(block + 1);
+        node->left = node->right = CEIT_NIL;
+        Memchunk->fit_root = fit_insert(Memchunk, Memchunk->fit_root, block_offset(Memchunk, block), block_size(block));
+        return;
+    }
+
+    // Nothing listed is larger than largest_free, so a block at least as large is the largest
+    if (block_size(block) >= Memchunk->largest_free) {
+        Memchunk->largest_free = block_size(block);
+        Memchunk->largest_stale = 0;
+    }
+
+    int cls = size_class(block_size(block));
+    size_t* head = &Memchunk->free_lists[cls];
+    if (Memchunk->tlsf_lists) {
+        int second = tlsf_second(block_size(block), cls);
+        head = &Memchunk->tlsf_lists[cls * CEIT_TLSF_SL + second];
+        Memchunk->tlsf_maps[cls] |= 1U << second;
+    }
+
+    FreeLinks* links = block_links(block);
+    links->prev_free = CEIT_NIL;
+    links->next_free = *head;
+    if (links->next_free != CEIT_NIL) block_links(block_at(Memchunk, links->next_free))->prev_free = block_offset(Memchunk, block);
+    *head = block_offset(Memchunk, block);
+    Memchunk->free_map |= 1ULL << cls;
+}
+
+/**
+ * @brief Unlinks a free block from the free list of its size class, or from
+ * the tree of a MEMC_BEST_FIT Memchunk.
+ */
+static void freelist_remove(Memchunk* Memchunk, Memory* block) {
+    Memchunk->stats.free_blocks--;
+    if (Memchunk->flags & MEMC_BEST_FIT) {
+        Memchunk->fit_root = fit_remove(Memchunk, Memchunk->fit_root, block_offset(Memchunk, block), block_size(block));
+        return;
+    }
+
+    if (block_size(block) == Memchunk->largest_free) Memchunk->largest_stale = 1;  // Found again when it is next read
+
+    int cls = size_class(block_size(block));
+    FreeLinks* links = block_links(block);
+    if (links->prev_free != CEIT_NIL) {
+        block_links(block_at(Memchunk, links->prev_free))->next_free = links->next_free;
+    } else if (Memchunk->tlsf_lists) {
+        int second = tlsf_second(block_size(block), cls);
+        Memchunk->tlsf_lists[cls * CEIT_TLSF_SL + second] = links->next_free;
+        if (links->next_free == CEIT_NIL && !(Memchunk->tlsf_maps[cls] &= ~(1U << second))) Memchunk->free_map &= ~(1ULL << cls);
+    } else {
+        Memchunk->free_lists[cls] = links->next_free;
+        if (links->next_free == CEIT_NIL) Memchunk->free_map &= ~(1ULL << cls);
+    }
+    if (links->next_free != CEIT_NIL) block_links(block_at(Memchunk, links->next_free))->prev_free = links->prev_free;
+}
+
+/**
+ * @brief Merges a newly freed block with its free physical neighbours.
+ *
+ * The block's size word and the footer of a free predecessor act as boundary
+ * tags, so at most two neighbours are looked at regardless of how many blocks
+ * the Memchunk holds. The resulting block is put on the free list of its size
+ * class, and is returned.
+ */
+static Memory* coalesce(Memchunk* Memchunk, Memory* block) {
+    Memory* next = block_next(Memchunk, block);
+    if (next && (next->size & CEIT_BLOCK_FREE)) {
+        freelist_remove(Memchunk, next);
+        block_set_size(block, block_size(block) + sizeof(Memory) + block_size(next));
+    }
+
+    if (block->size & CEIT_BLOCK_PREV_FREE) {
+        Memory* prev = block_prev_free(block);
+        block->size |= CEIT_BLOCK_FREE;  // The stale header inside prev keeps catching double frees
+        freelist_remove(Memchunk, prev);
+        block_set_size(prev, block_size(prev) + sizeof(Memory) + block_size(block));
+        block = prev;
+    }
+
+    block->name_hash = 0;  // The merged block is dirty, and freed "long ago" unless decay stamps it
+    mark_free(Memchunk, block);
+    freelist_insert(Memchunk, block);
+    return block;
+}
+
+/**
+ * @brief Hashes a block name (FNV-1a), looking at no more than the stored part of it.
+ */
+static size_t name_hash(const char* name) {
+    unsigned long long hash = 1469598103934665603ULL;
+    for (size_t i = 0; i < CEIT_NAME_LEN - 1 && name[i]; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 1099511628211ULL;
+    }
+    return (size_t)hash;
+}
+
+/**
+ * @brief Returns the stored name of a name index slot.
+ */
+static char* nameindex_name(const Memchunk* Memchunk, size_t slot) {
+    return Memchunk->name_text + slot * CEIT_NAME_LEN;
+}
+
+/**
+ * @brief Returns the name index slot holding `name`, or -1 if it is not indexed.
+ */
+static long nameindex_lookup(const Memchunk* Memchunk, const char* name) {
+    if (!Memchunk->name_index) return -1;
+
+    size_t mask = Memchunk->name_capacity - 1, hash = name_hash(name);
+    for (size_t i = hash & mask; Memchunk->name_index[i].block; i = (i + 1) & mask) {
+        if (Memchunk->name_index[i].hash == hash && strncmp(nameindex_name(Memchunk, i), name, CEIT_NAME_LEN - 1) == 0) {
+            return (long)i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Returns the name index slot of a named block, or -1 if it is not indexed.
+ *
+ * The block's name hash is kept beside it, so only its probe run is visited.
+ */
+static long nameindex_slot_of(const Memchunk* Memchunk, const Memory* block, size_t hash) {
+    if (!Memchunk->name_index) return -1;
+
+    size_t mask = Memchunk->name_capacity - 1;
+    for (size_t i = hash & mask; Memchunk->name_index[i].block; i = (i + 1) & mask) {
+        if (Memchunk->name_index[i].block == block) return (long)i;
+    }
+    return -1;
+}
+
+/**
+ * @brief Writes the tag of a block name: the name without a trailing number
+ * and one separator before it, or the whole name if nothing else is left.
+ */
+static void tag_of_name(const char* name, char* tag) {
+    size_t length = strnlen(name, CEIT_NAME_LEN - 1), end = length;
+    while (end > 0 && name[end - 1] >= '0' && name[end - 1] <= '9') end--;
+    if (end < length && end > 1 && strchr("_-.:# ", name[end - 1])) end--;
+    if (end == 0) end = length;
+    memcpy(tag, name, end);
+    tag[end] = '\0';
+}
+
+/**
+ * @brief Makes room for one more tag, doubling the tags at 50% index load.
+ *
+ * @return 0 on success, -1 if the tags could not be grown.
+ */
+static int tag_reserve(Memchunk* Memchunk) {
+    if (Memchunk->tag_count < Memchunk->tag_capacity) return 0;
+
+    size_t capacity = Memchunk->tag_capacity ? Memchunk->tag_capacity * 2 : CEIT_NAME_INDEX_MIN / 2;
+    Memtag* tags = (Memtag*)realloc(Memchunk->tags, capacity * sizeof(Memtag));
+    if (!tags) return -1;
+    Memchunk->tags = tags;
+    unsigned* index = (unsigned*)malloc(capacity * 2 * sizeof(unsigned));
+    if (!index) return -1;
+
+    memset(index, 0xff, capacity * 2 * sizeof(unsigned));  // UINT_MAX everywhere
+    for (size_t tag = 0; tag < Memchunk->tag_count; tag++) {
+        size_t i = name_hash(tags[tag].name) & (capacity * 2 - 1);
+        while (index[i] != UINT_MAX) i = (i + 1) & (capacity * 2 - 1);
+        index[i] = (unsigned)tag;
+    }
+    free(Memchunk->tag_index);
+    Memchunk->tag_index = index;
+    Memchunk->tag_capacity = capacity;
+    return 0;
+}
+
+/**
+ * @brief Returns the tag of a block name, adding the tag if it is new; the
+ * caller made room with tag_reserve.
+ */
+static unsigned tag_intern(Memchunk* Memchunk, const char* name) {
+    char tag[CEIT_NAME_LEN];
+    tag_of_name(name, tag);
+
+    size_t mask = Memchunk->tag_capacity * 2 - 1, i = name_hash(tag) & mask;
+    for (; Memchunk->tag_index[i] != UINT_MAX; i = (i + 1) & mask) {
+        if (strcmp(Memchunk->tags[Memchunk->tag_index[i]].name, tag) == 0) return Memchunk->tag_index[i];
+    }
+
+    Memtag* entry = &Memchunk->tags[Memchunk->tag_count];
+    memset(entry, 0, sizeof(Memtag));
+    strcpy(entry->name, tag);
+    Memchunk->tag_index[i] = (unsigned)Memchunk->tag_count;
+    return (unsigned)Memchunk->tag_count++;
+}
+
+/**
+ * @brief Places an entry in the first free slot of its probe sequence.
+ */
+static void nameindex_place(Memname* index, char* names, size_t capacity, size_t hash, Memory* block, const char* name, unsigned tag) {
+    size_t i = hash & (capacity - 1);
+    while (index[i].block) i = (i + 1) & (capacity - 1);
+    index[i].hash = hash;
+    index[i].block = block;
+    index[i].tag = tag;
+    size_t length = strnlen(name, CEIT_NAME_LEN - 1);  // Longer names are cut to fit
+    memcpy(names + i * CEIT_NAME_LEN, name, length);
+    names[i * CEIT_NAME_LEN + length] = '\0';
+}
+
+/**
+ * @brief Moves the name index to `capacity` slots, a power of two that holds every name.
+ *
+ * @return 0 on success, -1 if the new index could not be allocated.
+ */
+static int nameindex_resize(Memchunk* Memchunk, size_t capacity) {
+    Memname* index = (Memname*)calloc(capacity, sizeof(Memname));
+    char* names = (char*)malloc(capacity * CEIT_NAME_LEN);
+    if (!index || !names) {
+        free(index);
+        free(names);
+        return -1;
+    }
+
+    for (size_t i = 0; i < Memchunk->name_capacity; i++) {
+        if (Memchunk->name_index[i].block) {
+            nameindex_place(index, names, capacity, Memchunk->name_index[i].hash, Memchunk->name_index[i].block, nameindex_name(Memchunk, i), Memchunk->name_index[i].tag);
+        }
+    }
+    free(Memchunk->name_index);
+    free(Memchunk->name_text);
+    Memchunk->name_index = index;
+    Memchunk->name_text = names;
+    Memchunk->name_capacity = capacity;
+    return 0;
+}
+
+/**
+ * @brief Makes room for one more name, and its tag, doubling the index at 75% load.
+ *
+ * @return 0 on success, -1 if the index could not be grown.
+ */
+static int nameindex_reserve(Memchunk* Memchunk) {
+    if (tag_reserve(Memchunk) != 0) return -1;
+    if ((Memchunk->flags & MEMC_BUDDY) && !Memchunk->buddy_names) {
+        Memchunk->buddy_names = (size_t*)malloc(((size_t)1 << (Memchunk->buddy_max_order - Memchunk->buddy_min_order)) * sizeof(size_t));
+        if (!Memchunk->buddy_names) return -1;
+    }
+    if ((Memchunk->name_count + 1) * 4 <= Memchunk->name_capacity * 3) return 0;
+    return nameindex_resize(Memchunk, Memchunk->name_capacity ? Memchunk->name_capacity * 2 : CEIT_NAME_INDEX_MIN);
+}
+
+/**
+ * @brief Empties a name index slot, shifting later entries of its probe run back.
+ *
+ * Backward-shift deletion keeps probe runs short without tombstones.
+ */
+static void nameindex_remove_slot(Memchunk* Memchunk, size_t hole) {
+    size_t mask = Memchunk->name_capacity - 1;
+    Memname* index = Memchunk->name_index;
+    for (size_t i = (hole + 1) & mask; index[i].block; i = (i + 1) & mask) {
+        size_t home = index[i].hash & mask;
+        // Move the entry back if the hole lies between its home slot and its current slot
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            index[hole] = index[i];
+            memcpy(nameindex_name(Memchunk, hole), nameindex_name(Memchunk, i), CEIT_NAME_LEN);
+            hole = i;
+        }
+    }
+    index[hole].block = NULL;
+    Memchunk->name_count--;
+}
+
+/**
+ * @brief Returns the name index slot of a block, or -1 for an anonymous one.
+ *
+ * A MEMC_BUDDY block has no header: its named mark is kept in buddy_orders
+ * and its name hash in buddy_names.
+ */
+static long block_name_slot(const Memchunk* Memchunk, const Memory* block) {
+    if (Memchunk->flags & MEMC_BUDDY) {
+        size_t slot = block_offset(Memchunk, block) >> Memchunk->buddy_min_order;
+        if (!(Memchunk->buddy_orders[slot] & CEIT_BUDDY_NAMED)) return -1;
+        return nameindex_slot_of(Memchunk, block, Memchunk->buddy_names[slot]);
+    }
+    return block->size & CEIT_BLOCK_NAMED ? nameindex_slot_of(Memchunk, block, block->name_hash) : -1;
+}
+
+/**
+ * @brief Returns the data size of an allocated block, which for MEMC_BUDDY
+ * is kept in buddy_orders rather than in a header.
+ */
+static size_t block_reserved(const Memchunk* Memchunk, const Memory* block) {
+    if (!(Memchunk->flags & MEMC_BUDDY)) return block_size(block);
+    return (size_t)1 << (Memchunk->buddy_orders[block_offset(Memchunk, block) >> Memchunk->buddy_min_order] & ~CEIT_BUDDY_NAMED);
+}
+
+/**
+ * @brief Indexes a block under `name` and counts it under its tag; the
+ * caller made room with nameindex_reserve.
+ */
+static void block_name_set(Memchunk* Memchunk, Memory* block, const char* name) {
+    size_t hash = name_hash(name);
+    if (Memchunk->flags & MEMC_BUDDY) {
+        size_t slot = block_offset(Memchunk, block) >> Memchunk->buddy_min_order;
+        Memchunk->buddy_orders[slot] |= CEIT_BUDDY_NAMED;
+        Memchunk->buddy_names[slot] = hash;
+    } else {
+        block->name_hash = hash;
+        block->size |= CEIT_BLOCK_NAMED;
+    }
+    unsigned tag = tag_intern(Memchunk, name);
+    nameindex_place(Memchunk->name_index, Memchunk->name_text, Memchunk->name_capacity, hash, block, name, tag);
+    Memchunk->name_count++;
+    Memchunk->tags[tag].live_bytes += block_reserved(Memchunk, block);
+    Memchunk->tags[tag].live_blocks++;
+    Memchunk->tags[tag].alloc_count++;
+}
+
+/**
+ * @brief Drops a block's entry from the name index and its tag, if it has one.
+ */
+static void block_name_clear(Memchunk* Memchunk, Memory* block) {
+    long slot = block_name_slot(Memchunk, block);
+    if (slot >= 0) {
+        Memtag* tag = &Memchunk->tags[Memchunk->name_index[slot].tag];
+        tag->live_bytes -= block_reserved(Memchunk, block);
+        tag->live_blocks--;
+        nameindex_remove_slot(Memchunk, (size_t)slot);
+    }
+    if (Memchunk->flags & MEMC_BUDDY) {
+        Memchunk->buddy_orders[block_offset(Memchunk, block) >> Memchunk->buddy_min_order] &= ~CEIT_BUDDY_NAMED;
+    } else {
+        block->size &= ~(size_t)CEIT_BLOCK_NAMED;
+    }
+}
+
+/**
+ * @brief Returns the name of a block, or an empty string for an anonymous one.
+ */
+static const char* block_name_of(const Memchunk* Memchunk, const Memory* block) {
+    long slot = block_name_slot(Memchunk, block);
+    return slot >= 0 ? nameindex_name(Memchunk, (size_t)slot) : "";
+}
+
+/**
+ * @brief Returns the header of the block whose data pointer is `ptr`.
+ */
+static Memory* block_of(const void* ptr) {
+    return (Memory*)((char*)ptr - sizeof(Memory));
+}
+
+/**
+ * @brief Checks whether `ptr` lies inside the Memchunk's memory region.
+ */
+static int chunk_owns(const Memchunk* Memchunk, const void* ptr) {
+    const char* start = (const char*)Memchunk->memory_pool;
+    return (const char*)ptr >= start + sizeof(Memory) && (const char*)ptr < start + sizeof(Memory) + Memchunk->reserve_size;
+}
+
+/**
+ * @brief Returns the next Memchunk of a growth chain.
+ *
+ * Chains only ever get appended to, under the head's grow_lock, so readers
+ * can follow them without a lock.
+ */
+static Memchunk* chain_next(const Memchunk* Memchunk) {
+    return __atomic_load_n(&Memchunk->next, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Finds the Memchunk of a growth chain whose memory region contains `ptr`.
+ */
+static Memchunk* chain_find_owner(Memchunk* head, const void* ptr) {
+    Memchunk* current = head;
+    while (current && !chunk_owns(current, ptr)) current = chain_next(current);
+    return current;
+}
+
+/**
+ * @brief Finds the Memchunk whose memory region contains `ptr`, among all
+ * registered Memchunks and their growth chains.
+ */
+static Memchunk* chunk_find_owner(const void* ptr) {
+    Memchunk* owner = NULL;
+    pthread_rwlock_rdlock(&global_memchunk_lock);
+    for (Memchunk* current = global_memchunk_list; current && !owner; current = current->global_next) {
+        owner = chain_find_owner(current, ptr);
+    }
+    pthread_rwlock_unlock(&global_memchunk_lock);
+    return owner;
+}
+
+static size_t page_size(void);
+
+/**
+ * @brief Returns the header of a MEMC_SHARED Memchunk, in the page before
+ * its memory pool.
+ */
+static SharedHeader* shared_header(const Memchunk* Memchunk) {
+    return (SharedHeader*)((char*)Memchunk->memory_pool - page_size());
+}
+
+/**
+ * @brief Takes the process-shared lock of a MEMC_SHARED Memchunk.
+ *
+ * If the process holding it died, the lock is taken over but the Memchunk
+ * is poisoned: the dead process may have left a free list or block header
+ * half updated, so nothing may trust the allocator state any more.
+ *
+ * @return 0, or -1 if the Memchunk is poisoned; the lock is held either way.
+ */
+static int shared_lock(SharedHeader* header) {
+    if (pthread_mutex_lock(&header->lock) == EOWNERDEAD) {
+        header->poisoned = 1;
+        pthread_mutex_consistent(&header->lock);
+    }
+    return header->poisoned ? -1 : 0;
+}
+
+/**
+ * @brief Takes the Memchunk's lock if it was created with MEMC_THREAD_SAFE.
+ *
+ * A MEMC_SHARED Memchunk takes the lock in its shared header and loads
+ * the allocator state other processes may have changed.
+ *
+ * @return 0, or -1 if a MEMC_SHARED Memchunk is poisoned and must not be
+ *         changed; the lock is held either way.
+ */
+static int chunk_lock(Memchunk* Memchunk) {
+    if (Memchunk->flags & MEMC_SHARED) {
+        SharedHeader* header = shared_header(Memchunk);
+        int status = shared_lock(header);
+        memcpy(Memchunk->free_lists, header->free_lists, sizeof(header->free_lists));
+        Memchunk->free_map = header->free_map;
+        Memchunk->used_memory = header->used_memory;
+        Memchunk->free_memory = header->free_memory;
+        Memchunk->purged_memory = header->purged_memory;
+        Memchunk->tail_free = header->tail_free;
+        Memchunk->stats = header->stats;
+        return status;
+    }
+    if (Memchunk->flags & MEMC_THREAD_SAFE) pthread_mutex_lock(&Memchunk->lock);
+    return 0;
+}
+
+/**
+ * @brief Releases the lock taken by chunk_lock, publishing the state of a
+ * MEMC_SHARED Memchunk first.
+ */
+static void chunk_unlock(Memchunk* Memchunk) {
+    if (Memchunk->flags & MEMC_SHARED) {
+        SharedHeader* header = shared_header(Memchunk);
+        memcpy(header->free_lists, Memchunk->free_lists, sizeof(header->free_lists));
+        header->free_map = Memchunk->free_map;
+        header->used_memory = Memchunk->used_memory;
+        header->free_memory = Memchunk->free_memory;
+        header->purged_memory = Memchunk->purged_memory;
+        header->tail_free = Memchunk->tail_free;
+        header->stats = Memchunk->stats;
+        pthread_mutex_unlock(&header->lock);
+    } else if (Memchunk->flags & MEMC_THREAD_SAFE) {
+        pthread_mutex_unlock(&Memchunk->lock);
+    }
+}
+
+/**
+ * @brief Returns whether a free block of a MEMC_BUDDY Memchunk starts at `slot`.
+ */
+static int buddy_is_free(const Memchunk* Memchunk, size_t slot) {
+    return (Memchunk->buddy_free[slot / 64] >> (slot % 64)) & 1;
+}
+
+/**
+ * @brief Pushes the free buddy block at `offset` onto the list of its order.
+ *
+ * Buddy offsets count from the first data byte, and the links sit at the
+ * start of the free block itself.
+ */
+static void buddy_push(Memchunk* Memchunk, size_t offset, unsigned order) {
+    char* base = (char*)(Memchunk->memory_pool + 1);
+    FreeLinks* links = (FreeLinks*)(base + offset);
+    links->prev_free = CEIT_NIL;
+    links->next_free = Memchunk->free_lists[order];
+    if (links->next_free != CEIT_NIL) ((FreeLinks*)(base + links->next_free))->prev_free = offset;
+    Memchunk->free_lists[order] = offset;
+    Memchunk->free_map |= 1ULL << order;
+    Memchunk->stats.free_blocks++;
+
+    size_t slot = offset >> Memchunk->buddy_min_order;
+    Memchunk->buddy_orders[slot] = (unsigned char)order;
+    Memchunk->buddy_requests[slot] = 0;  // A free block's entry records whether it was purged
+    Memchunk->buddy_free[slot / 64] |= 1ULL << (slot % 64);
+}
+
+/**
+ * @brief Unlinks the free buddy block at `offset` from the list of its order.
+ */
+static void buddy_unlink(Memchunk* Memchunk, size_t offset, unsigned order) {
+    char* base = (char*)(Memchunk->memory_pool + 1);
+    FreeLinks* links = (FreeLinks*)(base + offset);
+    if (links->prev_free != CEIT_NIL) {
+        ((FreeLinks*)(base + links->prev_free))->next_free = links->next_free;
+    } else {
+        Memchunk->free_lists[order] = links->next_free;
+        if (links->next_free == CEIT_NIL) Memchunk->free_map &= ~(1ULL << order);
+    }
+    if (links->next_free != CEIT_NIL) ((FreeLinks*)(base + links->next_free))->prev_free = links->prev_free;
+
+    size_t slot = offset >> Memchunk->buddy_min_order;
+    Memchunk->buddy_free[slot / 64] &= ~(1ULL << (slot % 64));
+    Memchunk->stats.free_blocks--;
+}
+
+/**
+ * @brief Frees a block of a MEMC_BUDDY Memchunk; the caller holds the lock.
+ *
+ * The block merges with its buddy, found by flipping one bit of its offset,
+ * for as long as the buddy is a whole free block of the same order.
+ * Pointers that do not start a live block are ignored.
+ */
+static void buddy_release(Memchunk* Memchunk, void* ptr) {
+    size_t offset = (size_t)((char*)ptr - (char*)(Memchunk->memory_pool + 1));
+    size_t slot = offset >> Memchunk->buddy_min_order;
+    if ((offset & (((size_t)1 << Memchunk->buddy_min_order) - 1)) || !Memchunk->buddy_orders[slot] || buddy_is_free(Memchunk, slot)) return;
+
+    block_name_clear(Memchunk, (Memory*)ptr - 1);
+    unsigned order = Memchunk->buddy_orders[slot];
+    Memchunk->used_memory -= (size_t)1 << order;
+    Memchunk->free_memory += (size_t)1 << order;
+    Memchunk->requested_memory -= (size_t)Memchunk->buddy_requests[slot] * CEIT_ALIGN;
+    Memchunk->buddy_orders[slot] = 0;
+    Memchunk->stats.free_count++;
+    Memchunk->stats.live_blocks--;
+
+    while (order < Memchunk->buddy_max_order) {
+        size_t buddy = offset ^ ((size_t)1 << order);
+        size_t buddy_slot = buddy >> Memchunk->buddy_min_order;
+        if (!buddy_is_free(Memchunk, buddy_slot) || Memchunk->buddy_orders[buddy_slot] != order) break;
+        buddy_unlink(Memchunk, buddy, order);
+        Memchunk->buddy_orders[buddy_slot] = 0;
+        offset &= ~((size_t)1 << order);
+        order++;
+    }
+    buddy_push(Memchunk, offset, order);
+}
+
+static void chunk_decay(Memchunk* Memchunk, Memory* block);
+
+/**
+ * @brief Marks an allocated block free, updates the statistics and coalesces it.
+ */
+static void release_block(Memchunk* Memchunk, Memory* block) {
+    if (Memchunk->flags & MEMC_BUDDY) {
+        buddy_release(Memchunk, block + 1);
+        return;
+    }
+    block_name_clear(Memchunk, block);
+
+    Memchunk->used_memory -= block_size(block);
+    Memchunk->free_memory += block_size(block);
+    Memchunk->stats.free_count++;
+    Memchunk->stats.live_blocks--;
+    block = coalesce(Memchunk, block);  // Mark free and merge with free physical neighbours
+    if (Memchunk->decay_ms && block_size(block) >= Memchunk->commit_unit) chunk_decay(Memchunk, block);
+}
+
+static int file_save(Memchunk* Memchunk);
+
+/**
+ * @brief Returns the header of a MEMC_FILE Memchunk's file, in the page
+ * before its memory pool.
+ */
+static FileHeader* file_header(const Memchunk* Memchunk) {
+    return (FileHeader*)((char*)Memchunk->memory_pool - page_size());
+}
+
+/**
+ * @brief Releases a Memchunk's memory pool the way it was obtained.
+ */
+static void chunk_free_pool(Memchunk* Memchunk) {
+    if (Memchunk->flags & MEMC_SHARED) munmap(shared_header(Memchunk), shared_header(Memchunk)->map_size);
+    else if (Memchunk->flags & MEMC_FILE) munmap(file_header(Memchunk), file_header(Memchunk)->file_size);
+    else if (Memchunk->flags & MEMC_MMAP) munmap(Memchunk->memory_pool, Memchunk->reserve_size + sizeof(Memory));
+    else if (Memchunk->flags & MEMC_BUDDY) free((char*)(Memchunk->memory_pool + 1) - page_size());
+    else free(Memchunk->memory_pool);
+}
+
+static void profile_destroy(Memprofile* profile);
+
+/**
+ * @brief Frees a Memchunk's memory pool, name index and the Memchunk itself.
+ */
+static void chunk_destroy(Memchunk* Memchunk) {
+    if (Memchunk) profile_destroy(Memchunk->profile);  // Shared by the chain, owned by its head
+    while (Memchunk) {
+        struct Memchunk* next = Memchunk->next;  // Growth chain members are owned by their head
+        if (Memchunk->flags & MEMC_THREAD_SAFE) {
+            pthread_mutex_destroy(&Memchunk->lock);
+            pthread_mutex_destroy(&Memchunk->grow_lock);
+        }
+
+        // All memory blocks live inside the single memory pool allocation
+        if (Memchunk->flags & MEMC_FILE) file_save(Memchunk);  // Names are kept for the next memc_open_file
+        if (Memchunk->flags & MEMC_SHARED) {
+            // The last process to detach removes the name; the memory goes with the last mapping
+            SharedHeader* header = shared_header(Memchunk);
+            shared_lock(header);
+            if (--header->attached == 0) {
+                header->closed = 1;
+                shm_unlink(header->path);
+            }
+            pthread_mutex_unlock(&header->lock);
+        }
+        chunk_free_pool(Memchunk);
+        free(Memchunk->name_index);
+        free(Memchunk->name_text);
+        free(Memchunk->tags);
+        free(Memchunk->tag_index);
+        free(Memchunk->tlsf_lists);
+        free(Memchunk->buddy_free);
+        free(Memchunk->buddy_names);
+        free(Memchunk->arena_starts);
+        free(Memchunk->latency);
+        free(Memchunk);
+        Memchunk = next;
+    }
+}
+
+/**
+ * @brief Finds a free block of at least `size` bytes in O(1) (TLSF).
+ *
+ * The request is rounded up to the next second-level list boundary, so that
+ * every block of the list it maps to, or of any later non-empty list, fits.
+ * Two bitmap scans then find the first such list.
+ */
+static Memory* tlsf_find(Memchunk* Memchunk, size_t size) {
+    size += ((size_t)1 << (size_class(size) - CEIT_TLSF_SL_LOG)) - 1;
+    int cls = size_class(size);
+    unsigned seconds = Memchunk->tlsf_maps[cls] & (~0U << tlsf_second(size, cls));
+    if (!seconds) {
+        unsigned long long larger = cls < CEIT_SIZE_CLASSES - 1 ? Memchunk->free_map & (~0ULL << (cls + 1)) : 0;
+        if (!larger) return NULL;
+        cls = __builtin_ctzll(larger);
+        seconds = Memchunk->tlsf_maps[cls];
+    }
+    return block_at(Memchunk, Memchunk->tlsf_lists[cls * CEIT_TLSF_SL + __builtin_ctz(seconds)]);
+}
+
+/**
+ * @brief Finds the smallest free block of at least `size` bytes, the lowest
+ * one among equals, in O(log n) (MEMC_BEST_FIT).
+ *
+ * The leftmost tree node whose size fits is the best fit: the search goes
+ * left past every node that fits and right past every node that does not.
+ */
+static Memory* fit_find(Memchunk* Memchunk, size_t size) {
+    size_t best = CEIT_NIL;
+    for (size_t current = Memchunk->fit_root; current != CEIT_NIL;) {
+        if (block_size(block_at(Memchunk, current)) >= size) {
+            best = current;
+            current = fit_node(Memchunk, current)->left;
+        } else {
+            current = fit_node(Memchunk, current)->right;
+        }
+    }
+    return best != CEIT_NIL ? block_at(Memchunk, best) : NULL;
+}
+
+/**
+ * @brief Finds a free block of at least `size` bytes.
+ *
+ * A few blocks of the request's own size class are probed first so that small
+ * holes get reused. Failing that, the head of the first non-empty larger class
+ * is taken, since every block there fits. The own class is only scanned in
+ * full when no larger class has a free block.
+ */
+static Memory* freelist_find(Memchunk* Memchunk, size_t size) {
+    if (Memchunk->flags & MEMC_BEST_FIT) return fit_find(Memchunk, size);
+    if (Memchunk->tlsf_lists) return tlsf_find(Memchunk, size);
+
+    int cls = size_class(size);
+    size_t current = Memchunk->free_lists[cls];
+    for (int probes = 0; current != CEIT_NIL && probes < CEIT_FIT_PROBES; probes++) {
+        if (block_size(block_at(Memchunk, current)) >= size) return block_at(Memchunk, current);
+        current = block_links(block_at(Memchunk, current))->next_free;
+    }
+
+    unsigned long long larger = cls < CEIT_SIZE_CLASSES - 1 ? Memchunk->free_map & (~0ULL << (cls + 1)) : 0;
+    if (larger) return block_at(Memchunk, Memchunk->free_lists[__builtin_ctzll(larger)]);
+
+    while (current != CEIT_NIL) {
+        if (block_size(block_at(Memchunk, current)) >= size) return block_at(Memchunk, current);
+        current = block_links(block_at(Memchunk, current))->next_free;
+    }
+    return NULL;
+}
+
+/**
+ * @brief A thread's cache of recently freed blocks for one thread-safe Memchunk.
+ *
+ * Cached blocks stay allocated as far as the Memchunk is concerned, so they
+ * can be handed out again without taking its lock. Their name hash holds
+ * CEIT_TCACHE_HELD while they wait, so a second free is ignored rather than
+ * caching the block twice. The `id` tells a reused Memchunk address apart
+ * from the Memchunk the blocks came from.
+ *
+ * The Memchunk's counters see the cache as one more user: blocks taken to
+ * fill it count as allocations and blocks flushed from it as frees. The
+ * cache keeps the difference to the program's own calls, which only its
+ * thread writes, and memc_stats adds it in.
+ */
+typedef struct Tcache {
+    Memchunk* chunk;                ///< Memchunk the cached blocks belong to.
+    unsigned long long id;          ///< Memchunk::id of that Memchunk.
+    struct Tcache* next;            ///< Next cache in Memchunk::tcaches, while `id` matches.
+    size_t allocs;                  ///< Allocations served from the cache, less blocks taken to fill it.
+    size_t alloc_bytes;             ///< Bytes of those, in the same way.
+    size_t frees;                   ///< Frees kept in the cache, less blocks flushed from it.
+    unsigned count[CEIT_TCACHE_BINS];                       ///< Number of blocks in each bin.
+    void* blocks[CEIT_TCACHE_BINS][CEIT_TCACHE_DEPTH];       ///< Cached data pointers, by block size.
+} Tcache;
+
+/** The calling thread's caches, one per recently used thread-safe Memchunk. */
+static __thread Tcache* thread_tcaches[CEIT_TCACHE_CHUNKS];
+
+/** Key whose destructor flushes a thread's caches when it exits. */
+static pthread_key_t tcache_exit_key;
+static pthread_once_t tcache_exit_once = PTHREAD_ONCE_INIT;
+
+static void release_block(Memchunk* Memchunk, Memory* block);
+
+/**
+ * @brief Whether a block waits in some thread's cache. Cached blocks are
+ * anonymous, so their name hash is free to carry the mark.
+ */
+static int tcache_held(Memory* block) {
+    return __atomic_load_n(&block->name_hash, __ATOMIC_RELAXED) == CEIT_TCACHE_HELD;
+}
+
+/**
+ * @brief Marks a block as waiting in a thread's cache, or clears the mark.
+ */
+static void tcache_hold(Memory* block, int held) {
+    __atomic_store_n(&block->name_hash, held ? CEIT_TCACHE_HELD : 0, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Adds to one of a cache's counters. Only the cache's thread writes
+ * them, while memc_stats may read them from another.
+ */
+static void tcache_count(size_t* counter, size_t delta) {
+    __atomic_store_n(counter, *counter + delta, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Returns a cached block to its Memchunk; the caller holds the lock.
+ */
+static void tcache_release(Tcache* cache, void* ptr) {
+    release_block(cache->chunk, block_of(ptr));
+    tcache_count(&cache->frees, (size_t)-1);  // Counted once already, when it entered the cache
+}
+
+/**
+ * @brief Returns every block of a cache to its Memchunk, under the Memchunk's lock.
+ */
+static void tcache_flush(Tcache* cache) {
+    chunk_lock(cache->chunk);
+    for (int bin = 0; bin < CEIT_TCACHE_BINS; bin++) {
+        while (cache->count[bin]) tcache_release(cache, cache->blocks[bin][--cache->count[bin]]);
+    }
+    chunk_unlock(cache->chunk);
+}
+
+/**
+ * @brief Adds the counters of a cache into its Memchunk's and takes the
+ * cache out of Memchunk::tcaches; the caller holds the lock.
+ *
+ * Live blocks are left alone: after a flush, or once memc_reset dropped
+ * the blocks, no cached block is left for the difference to cover.
+ */
+static void tcache_fold(Tcache* cache) {
+    Memchunk* Memchunk = cache->chunk;
+    Memchunk->stats.alloc_count += cache->allocs;
+    Memchunk->stats.requested_bytes += cache->alloc_bytes;
+    Memchunk->stats.reserved_bytes += cache->alloc_bytes;
+    Memchunk->stats.free_count += cache->frees;
+    Tcache** link = &Memchunk->tcaches;
+    while (*link && *link != cache) link = &(*link)->next;
+    if (*link) *link = cache->next;
+}
+
+/**
+ * @brief Flushes the exiting thread's caches into Memchunks that are still alive.
+ */
+static void tcache_thread_exit(void* unused) {
+    (void)unused;
+    pthread_rwlock_rdlock(&global_memchunk_lock);
+    for (int i = 0; i < CEIT_TCACHE_CHUNKS; i++) {
+        Tcache* cache = thread_tcaches[i];
+        if (!cache) continue;
+        for (Memchunk* head = global_memchunk_list; head; head = head->global_next) {
+            Memchunk* current = head;
+            while (current && current != cache->chunk) current = chain_next(current);
+            if (current) {
+                // The id is read under the lock, as memc_reset changes it under the lock alone
+                pthread_mutex_lock(&current->lock);
+                if (current->id == cache->id) {
+                    for (int bin = 0; bin < CEIT_TCACHE_BINS; bin++) {
+                        while (cache->count[bin]) tcache_release(cache, cache->blocks[bin][--cache->count[bin]]);
+                    }
+                    tcache_fold(cache);
+                }
+                pthread_mutex_unlock(&current->lock);
+                break;
+            }
+        }
+        free(cache);
+        thread_tcaches[i] = NULL;
+    }
+    pthread_rwlock_unlock(&global_memchunk_lock);
+}
+
+static void tcache_exit_key_create(void) {
+    pthread_key_create(&tcache_exit_key, tcache_thread_exit);
+}
+
+/**
+ * @brief Returns the calling thread's cache for a Memchunk, creating it if needed.
+ *
+ * @return The cache, or NULL if the thread has no cache slot left for it.
+ */
+static Tcache* tcache_get(Memchunk* Memchunk) {
+    Tcache** free_slot = NULL;
+    for (int i = 0; i < CEIT_TCACHE_CHUNKS; i++) {
+        Tcache* cache = thread_tcaches[i];
+        if (cache && cache->chunk == Memchunk) {
+            if (cache->id == Memchunk->id) return cache;
+            // The Memchunk it was made for is gone; its blocks went with it
+            free(cache);
+            thread_tcaches[i] = cache = NULL;
+        }
+        if (!cache && !free_slot) free_slot = &thread_tcaches[i];
+    }
+    if (!free_slot) return NULL;
+
+    Tcache* cache = (Tcache*)calloc(1, sizeof(Tcache));
+    if (!cache) return NULL;
+    cache->chunk = Memchunk;
+    cache->id = Memchunk->id;
+    pthread_mutex_lock(&Memchunk->lock);
+    cache->next = Memchunk->tcaches;
+    Memchunk->tcaches = cache;
+    pthread_mutex_unlock(&Memchunk->lock);
+    *free_slot = cache;
+
+    pthread_once(&tcache_exit_once, tcache_exit_key_create);
+    pthread_setspecific(tcache_exit_key, thread_tcaches);  // Any non-NULL value arms the destructor
+    return cache;
+}
+
+/**
+ * @brief Returns the size of a virtual memory page.
+ */
+static size_t page_size(void) {
+    static size_t page;
+    if (!page) page = (size_t)sysconf(_SC_PAGESIZE);
+    return page;
+}
+
+/**
+ * @brief Commits at least `needed` more bytes of a MEMC_MMAP Memchunk's
+ * reservation; the caller holds the lock.
+ *
+ * The new bytes are appended to the last block when it is free, or become
+ * a new free block. The committed part at least doubles each time, so a
+ * growing Memchunk makes few mprotect calls; pages only become resident
+ * once they are written.
+ *
+ * @return 0 on success, -1 if the reservation is exhausted.
+ */
+static int chunk_commit(Memchunk* Memchunk, size_t needed) {
+    size_t committed = Memchunk->total_size + sizeof(Memory);  // Always a whole number of commit units
+    size_t step = committed > needed ? committed : needed;
+    if (step < CEIT_COMMIT_MIN) step = CEIT_COMMIT_MIN;
+    step = CEIT_ROUND_UP(step, Memchunk->commit_unit);
+    if (step > Memchunk->reserve_size - Memchunk->total_size) step = Memchunk->reserve_size - Memchunk->total_size;
+    if (step < needed || step == 0) return -1;
+
+    if (mprotect((char*)Memchunk->memory_pool + committed, step, PROT_READ | PROT_WRITE) != 0) return -1;
+
+    Memory* end = (Memory*)((char*)(Memchunk->memory_pool + 1) + Memchunk->total_size);
+    Memchunk->total_size += step;
+    Memchunk->free_memory += step;
+    if (Memchunk->flags & MEMC_ARENA) return 0;
+
+    if (Memchunk->tail_free) {
+        Memory* last = block_prev_free(end);
+        freelist_remove(Memchunk, last);
+        // The old footer becomes data, and the page holding it need not be purged
+        if (last->name_hash & CEIT_FREE_ZERO) ((size_t*)end)[-1] = 0;
+        last->name_hash &= ~(size_t)CEIT_FREE_PURGED;
+        block_set_size(last, block_size(last) + step);
+        mark_free(Memchunk, last);
+        freelist_insert(Memchunk, last);
+    } else {
+        end->size = step - sizeof(Memory);
+        end->name_hash = CEIT_FREE_PURGED | CEIT_FREE_ZERO;  // Fresh pages are zero and not resident yet
+        mark_free(Memchunk, end);
+        freelist_insert(Memchunk, end);
+    }
+    return 0;
+}
+
+/**
+ * @brief Returns the whole pages inside a free block to the OS; the caller
+ * holds the lock.
+ *
+ * The free-list links at the start of the block and the footer at its end
+ * stay resident. The pages read back as zero when next touched.
+ *
+ * @return The number of bytes purged.
+ */
+static size_t block_purge(Memchunk* Memchunk, Memory* block) {
+    if (block->name_hash & CEIT_FREE_PURGED) return 0;
+
+    uintptr_t data = (uintptr_t)(block + 1);
+    uintptr_t from = CEIT_ROUND_UP(data + sizeof(FreeLinks), Memchunk->commit_unit);
+    uintptr_t to = (data + block_size(block) - sizeof(size_t)) & ~(uintptr_t)(Memchunk->commit_unit - 1);
+    if (from >= to) {
+        block->name_hash |= CEIT_FREE_PURGED;  // Nothing to purge, and nothing to retry
+        return 0;
+    }
+
+    // Dropping the pages of a file mapping would only reload them from the file; punch them out of it instead
+    if (madvise((void*)from, to - from, Memchunk->flags & (MEMC_FILE | MEMC_SHARED) ? MADV_REMOVE : MADV_DONTNEED) != 0) return 0;
+    block->name_hash |= CEIT_FREE_PURGED;
+    Memchunk->purged_memory += to - from;
+    return to - from;
+}
+
+/**
+ * @brief Purges the free blocks of the subtree at `root` that span a whole
+ * page and were last dirtied at or before `stamp` (MEMC_BEST_FIT).
+ *
+ * Left subtrees of a block smaller than a page hold only smaller blocks, and
+ * are skipped.
+ */
+static size_t fit_purge(Memchunk* Memchunk, size_t root, size_t stamp) {
+    if (root == CEIT_NIL) return 0;
+
+    Memory* block = block_at(Memchunk, root);
+    size_t purged = fit_purge(Memchunk, fit_node(Memchunk, root)->right, stamp);
+    if (block_size(block) < Memchunk->commit_unit) return purged;
+    if ((block->name_hash >> CEIT_FREE_STAMP_SHIFT) <= stamp) purged += block_purge(Memchunk, block);
+    return purged + fit_purge(Memchunk, fit_node(Memchunk, root)->left, stamp);
+}
+
+/**
+ * @brief Purges the free blocks last dirtied at or before `stamp` (in
+ * milliseconds), and for an arena the pages above its top; the caller holds
+ * the lock.
+ *
+ * @return The number of bytes purged.
+ */
+static size_t chunk_purge(Memchunk* Memchunk, size_t stamp) {
+    size_t unit = Memchunk->commit_unit, purged = 0;
+
+    if (Memchunk->flags & MEMC_ARENA) {
+        // Pages from arena_clean on were purged already, or never touched
+        uintptr_t base = (uintptr_t)(Memchunk->memory_pool + 1);
+        uintptr_t from = CEIT_ROUND_UP(base + Memchunk->arena_top, unit);
+        uintptr_t to = CEIT_ROUND_UP(base + Memchunk->arena_clean, unit);
+        uintptr_t end = (base + Memchunk->total_size) & ~(uintptr_t)(unit - 1);
+        if (to > end) to = end;
+        if (from < to && madvise((void*)from, to - from, MADV_DONTNEED) == 0) {
+            purged = to - from;
+            Memchunk->purged_memory += purged;
+            Memchunk->arena_clean = from - base;
+        }
+        return purged;
+    }
+
+    if (Memchunk->flags & MEMC_BUDDY) {
+        char* base = (char*)(Memchunk->memory_pool + 1);
+        for (unsigned order = size_class(unit); order <= Memchunk->buddy_max_order; order++) {
+            for (size_t offset = Memchunk->free_lists[order]; offset != CEIT_NIL; offset = ((FreeLinks*)(base + offset))->next_free) {
+                unsigned* purged_mark = &Memchunk->buddy_requests[offset >> Memchunk->buddy_min_order];
+                uintptr_t from = CEIT_ROUND_UP((uintptr_t)base + offset + sizeof(FreeLinks), unit);
+                uintptr_t to = ((uintptr_t)base + offset + ((size_t)1 << order)) & ~(uintptr_t)(unit - 1);
+                if (*purged_mark || from >= to || madvise((void*)from, to - from, MADV_DONTNEED) != 0) continue;
+                *purged_mark = 1;
+                purged += to - from;
+            }
+        }
+        Memchunk->purged_memory += purged;
+        return purged;
+    }
+
+    // Only blocks of at least one page can have a whole page inside them
+    if (Memchunk->flags & MEMC_BEST_FIT) return fit_purge(Memchunk, Memchunk->fit_root, stamp);
+    size_t* lists = Memchunk->tlsf_lists ? Memchunk->tlsf_lists : Memchunk->free_lists;
+    size_t per_class = Memchunk->tlsf_lists ? CEIT_TLSF_SL : 1;
+    for (size_t list = size_class(unit) * per_class; list < CEIT_SIZE_CLASSES * per_class; list++) {
+        for (size_t offset = lists[list]; offset != CEIT_NIL; offset = block_links(block_at(Memchunk, offset))->next_free) {
+            Memory* block = block_at(Memchunk, offset);
+            if ((block->name_hash >> CEIT_FREE_STAMP_SHIFT) <= stamp) purged += block_purge(Memchunk, block);
+        }
+    }
+    return purged;
+}
+
+/**
+ * @brief Returns the current time in milliseconds, for dirty-page decay.
+ */
+static size_t clock_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (size_t)now.tv_sec * 1000 + (size_t)now.tv_nsec / 1000000;
+}
+
+/**
+ * @brief At most every quarter of the decay time, purges the blocks that
+ * have stayed free for the whole decay time; the caller holds the lock.
+ */
+static void decay_run(Memchunk* Memchunk, size_t now) {
+    if (now < Memchunk->decay_next) return;
+
+    Memchunk->decay_next = now + (Memchunk->decay_ms / 4 ? Memchunk->decay_ms / 4 : 1);
+    if (now >= Memchunk->decay_ms) chunk_purge(Memchunk, now - Memchunk->decay_ms);
+}
+
+/**
+ * @brief Stamps a freshly freed large block and runs decay; the caller holds
+ * the lock.
+ *
+ * Decay runs from frees of large blocks, so small frees never read the clock.
+ */
+static void chunk_decay(Memchunk* Memchunk, Memory* block) {
+    size_t now = clock_ms();
+    block->name_hash = now << CEIT_FREE_STAMP_SHIFT;
+    decay_run(Memchunk, now);
+}
+
+/**
+ * @brief Runs decay without a free to trigger it, so memory freed in a burst
+ * is purged once the program only allocates or reads statistics; the caller
+ * holds the lock.
+ */
+static void decay_poll(Memchunk* Memchunk) {
+    Memchunk->decay_polls = 0;
+    if (Memchunk->decay_ms && !(Memchunk->flags & (MEMC_ARENA | MEMC_BUDDY))) decay_run(Memchunk, clock_ms());
+}
+
+/**
+ * @brief Reserves a MEMC_MMAP Memchunk's region and commits its first pages.
+ *
+ * With MEMC_HUGE_PAGES, the region is first asked for as explicit 2 MB
+ * pages (MAP_HUGETLB). If the huge page pool cannot cover it, a 2 MB aligned region is
+ * marked with MADV_HUGEPAGE so transparent huge pages can back it. Either
+ * way, the region is committed 2 MB at a time. On failure, memory_pool
+ * stays NULL.
+ */
+static void chunk_map(Memchunk* Memchunk, size_t total_size) {
+    int huge = (Memchunk->flags & MEMC_HUGE_PAGES) != 0;
+    Memchunk->commit_unit = huge ? CEIT_HUGE_PAGE : page_size();
+    size_t mapped = CEIT_ROUND_UP(total_size + sizeof(Memory), Memchunk->commit_unit);
+    void* region = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    if (huge) {
+        // Without MAP_NORESERVE the pool's pages are set aside now, so a later fault cannot hit SIGBUS
+        region = mmap(NULL, mapped, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (region != MAP_FAILED) Memchunk->huge_pages = MEMC_HUGE_EXPLICIT;
+    }
+#endif
+    if (region == MAP_FAILED && huge) {
+        // Over-reserve, then trim to a 2 MB aligned range that whole huge pages can cover
+        char* raw = mmap(NULL, mapped + CEIT_HUGE_PAGE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (raw != MAP_FAILED) {
+            char* aligned = (char*)CEIT_ROUND_UP((uintptr_t)raw, CEIT_HUGE_PAGE);
+            if (aligned != raw) munmap(raw, aligned - raw);
+            munmap(aligned + mapped, raw + CEIT_HUGE_PAGE - aligned);
+            region = aligned;
+#ifdef MADV_HUGEPAGE
+            if (madvise(region, mapped, MADV_HUGEPAGE) == 0) Memchunk->huge_pages = MEMC_HUGE_TRANSPARENT;
+#endif
+        }
+    }
+    if (region == MAP_FAILED) {
+        region = mmap(NULL, mapped, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    }
+
+    size_t committed = mapped < CEIT_COMMIT_MIN ? mapped : CEIT_ROUND_UP(CEIT_COMMIT_MIN, Memchunk->commit_unit);
+    if (region != MAP_FAILED && mprotect(region, committed, PROT_READ | PROT_WRITE) != 0) {
+        munmap(region, mapped);
+        region = MAP_FAILED;
+    }
+    if (region == MAP_FAILED) return;
+
+    Memchunk->memory_pool = (Memory*)region;
+    Memchunk->reserve_size = mapped - sizeof(Memory);
+    Memchunk->total_size = committed - sizeof(Memory);
+}
+
+/**
+ * @brief Makes the whole memory pool free again: one free block, or an empty arena.
+ */
+static void chunk_format(Memchunk* Memchunk) {
+    Memchunk->used_memory = 0;  // Initially no memory is used
+    Memchunk->free_memory = Memchunk->total_size;  // All memory is free at the start
+    Memchunk->stats.live_blocks = 0;
+    Memchunk->stats.free_blocks = 0;
+
+    if (Memchunk->flags & MEMC_ARENA) {
+        Memchunk->arena_top = 0;  // arena_clean stays, as the pages above it are still untouched
+        return;
+    }
+
+    for (int i = 0; i < CEIT_SIZE_CLASSES; i++) Memchunk->free_lists[i] = CEIT_NIL;
+    Memchunk->free_map = 0;
+    Memchunk->fit_root = CEIT_NIL;
+    Memchunk->largest_free = 0;
+    Memchunk->largest_stale = 0;
+    if (Memchunk->flags & MEMC_FILE) file_header(Memchunk)->names = CEIT_NIL;
+    if (Memchunk->flags & MEMC_BUDDY) {
+        size_t slots = (size_t)1 << (Memchunk->buddy_max_order - Memchunk->buddy_min_order);
+        memset(Memchunk->buddy_free, 0, (slots + 63) / 64 * sizeof(unsigned long long));
+        memset(Memchunk->buddy_orders, 0, slots);
+        Memchunk->requested_memory = 0;
+        buddy_push(Memchunk, 0, Memchunk->buddy_max_order);  // Initially, the pool is one free block
+        return;
+    }
+    if (Memchunk->tlsf_lists) {
+        for (int i = 0; i < CEIT_SIZE_CLASSES * CEIT_TLSF_SL; i++) Memchunk->tlsf_lists[i] = CEIT_NIL;
+        memset(Memchunk->tlsf_maps, 0, sizeof(Memchunk->tlsf_maps));
+    }
+    Memchunk->memory_pool->size = Memchunk->total_size;  // Initially, the memory is one free block
+    Memchunk->memory_pool->name_hash = Memchunk->decay_ms ? clock_ms() << CEIT_FREE_STAMP_SHIFT : 0;
+    mark_free(Memchunk, Memchunk->memory_pool);
+    freelist_insert(Memchunk, Memchunk->memory_pool);
+}
+
+/**
+ * @brief Initializes a new memory Memchunk with the given name and total size.
+ * 
+ * This function allocates memory for the Memchunk structure and initializes
+ * the memory pool. Initially, all memory in the Memchunk is free.
+ * 
+ * @param name The name of the Memchunk to initialize.
+ * @param total_size The total size of the memory Memchunk.
+ * 
+ * @return A pointer to the initialized Memchunk structure, or NULL if memory 
+ *         allocation fails.
+ * 
+ * Example usage:
+ * ```
+ * Memchunk* chunk = memc_init("Chunk1", 1024);
+ * if (chunk) {
+ *     // Use the chunk
+ * }
+ * ```
+ */
+Memchunk* memc_init(const char* name, size_t total_size) {
+    return memc_init_flags(name, total_size, 0);
+}
+
+/**
+ * @brief Sizes the buddy maps of a MEMC_BUDDY Memchunk for blocks of at
+ * least 2^min_order bytes; the caller formats the Memchunk afterwards.
+ *
+ * @return 0 on success, -1 if the maps could not be allocated.
+ */
+static int buddy_setup(Memchunk* Memchunk, unsigned min_order) {
+    if (min_order < CEIT_BUDDY_MIN_ORDER) min_order = CEIT_BUDDY_MIN_ORDER;
+    if (min_order > Memchunk->buddy_max_order) min_order = Memchunk->buddy_max_order;
+    if (Memchunk->buddy_free && min_order == Memchunk->buddy_min_order) return 0;
+
+    // One allocation holds the free bitmap, then the requests and orders of every slot
+    size_t slots = (size_t)1 << (Memchunk->buddy_max_order - min_order);
+    size_t words = (slots + 63) / 64;
+    unsigned long long* maps = (unsigned long long*)malloc(words * sizeof(unsigned long long) + slots * (sizeof(unsigned) + 1));
+    if (!maps) return -1;
+
+    free(Memchunk->buddy_free);
+    free(Memchunk->buddy_names);  // Sized by slot count; reallocated with the first name
+    Memchunk->buddy_free = maps;
+    Memchunk->buddy_names = NULL;
+    Memchunk->buddy_requests = (unsigned*)(maps + words);
+    Memchunk->buddy_orders = (unsigned char*)(Memchunk->buddy_requests + slots);
+    Memchunk->buddy_min_order = min_order;
+    return 0;
+}
+
+/**
+ * @brief Creates a Memchunk without registering it in global_memchunk_list.
+ */
+static Memchunk* chunk_create(const char* name, size_t total_size, unsigned flags) {
+    total_size &= ~(size_t)(CEIT_ALIGN - 1);  // Keep every block size a multiple of CEIT_ALIGN
+    if (total_size < CEIT_MIN_PAYLOAD) return NULL;
+    flags &= ~(unsigned)(MEMC_FILE | MEMC_SHARED);  // Only memc_open_file and memc_init_shared map objects
+
+    Memchunk* new_Memchunk = (Memchunk*)calloc(1, sizeof(Memchunk));
+    if (new_Memchunk == NULL) return NULL;
+
+    // Ensure the Memchunk name is properly set and null-terminated
+    strncpy(new_Memchunk->name, name, sizeof(new_Memchunk->name));
+    new_Memchunk->name[sizeof(new_Memchunk->name) - 1] = '\0';  // Null-terminate the name string
+
+    if (flags & MEMC_HUGE_PAGES) flags |= MEMC_MMAP;
+    if (flags & MEMC_ARENA) flags &= ~(unsigned)(MEMC_TLSF | MEMC_BEST_FIT);  // Arenas have no free lists
+    if (flags & MEMC_BEST_FIT) flags &= ~(unsigned)MEMC_TLSF;
+    if (flags & MEMC_BUDDY) {
+        // The buddy engine has its own layout: the pool is one block, a power of two in size
+        flags &= ~(unsigned)(MEMC_ARENA | MEMC_MMAP | MEMC_HUGE_PAGES | MEMC_TLSF | MEMC_BEST_FIT);
+        new_Memchunk->buddy_max_order = (unsigned)size_class(total_size);
+        total_size = (size_t)1 << new_Memchunk->buddy_max_order;
+    }
+    new_Memchunk->total_size = total_size;
+    new_Memchunk->reserve_size = total_size;
+    new_Memchunk->flags = flags;
+
+    if (flags & MEMC_MMAP) {
+        chunk_map(new_Memchunk, total_size);
+    } else if (flags & MEMC_BUDDY) {
+        // Data starts on a page boundary, so each block is aligned to its size up to a page
+        new_Memchunk->commit_unit = page_size();
+        char* region = (char*)aligned_alloc(page_size(), CEIT_ROUND_UP(total_size, page_size()) + page_size());
+        if (region) new_Memchunk->memory_pool = (Memory*)(region + page_size()) - 1;
+    } else {
+        new_Memchunk->commit_unit = page_size();
+        new_Memchunk->memory_pool = (Memory*)aligned_alloc(CEIT_ALIGN, total_size + sizeof(Memory));
+    }
+    if (flags & MEMC_TLSF) new_Memchunk->tlsf_lists = (size_t*)malloc(CEIT_SIZE_CLASSES * CEIT_TLSF_SL * sizeof(size_t));
+    if (flags & MEMC_ARENA) {
+        // Two maps of one bit per CEIT_ALIGN bytes of the reservation; large ones are zero pages until used
+        size_t words = (new_Memchunk->reserve_size / CEIT_ALIGN + 63) / 64;
+        new_Memchunk->arena_starts = (unsigned long long*)calloc(2 * words, sizeof(unsigned long long));
+    }
+    if (new_Memchunk->memory_pool == NULL || ((flags & MEMC_TLSF) && new_Memchunk->tlsf_lists == NULL) ||
+        ((flags & MEMC_ARENA) && new_Memchunk->arena_starts == NULL) ||
+        ((flags & MEMC_BUDDY) && buddy_setup(new_Memchunk, CEIT_BUDDY_ORDER) != 0)) {
+        if (new_Memchunk->memory_pool) chunk_free_pool(new_Memchunk);
+        free(new_Memchunk->tlsf_lists);
+        free(new_Memchunk->arena_starts);
+        free(new_Memchunk);
+        return NULL;
+    }
+    new_Memchunk->chain_size = new_Memchunk->reserve_size;
+
+    new_Memchunk->next = NULL;
+    chunk_format(new_Memchunk);
+    if (flags & MEMC_MMAP) {
+        if (!(flags & MEMC_ARENA)) new_Memchunk->memory_pool->name_hash = CEIT_FREE_PURGED | CEIT_FREE_ZERO;  // Fresh pages
+    } else {
+        new_Memchunk->arena_clean = new_Memchunk->total_size;  // Heap memory may hold old data
+    }
+
+    if (flags & MEMC_THREAD_SAFE) {
+        pthread_mutex_init(&new_Memchunk->lock, NULL);
+        pthread_mutex_init(&new_Memchunk->grow_lock, NULL);
+    }
+
+    new_Memchunk->id = __atomic_fetch_add(&next_memchunk_id, 1, __ATOMIC_RELAXED);
+    return new_Memchunk;
+}
+
+/**
+ * @brief Registers a Memchunk so mem_free and mem_clr can find it.
+ */
+static void chunk_register(Memchunk* Memchunk) {
+    pthread_rwlock_wrlock(&global_memchunk_lock);
+    Memchunk->global_next = global_memchunk_list;
+    global_memchunk_list = Memchunk;
+    pthread_rwlock_unlock(&global_memchunk_lock);
+}
+
+/**
+ * @brief Initializes a new memory Memchunk with the given behaviour flags.
+ * 
+ * Works like `memc_init`. With MEMC_THREAD_SAFE, the Memchunk may be shared
+ * by several threads: its operations are serialized by a per-Memchunk lock,
+ * and each thread keeps a small cache of freed blocks per size class so that
+ * most small anonymous allocations and frees do not take the lock at all.
+ * Cached blocks count as used in the statistics until they are flushed, see
+ * `memc_flush`. With MEMC_ARENA, the Memchunk is an arena as created by
+ * `memc_init_arena`. With MEMC_MMAP, the region is reserved with `mmap`
+ * but not backed, and pages are committed only as allocations reach them,
+ * so a multi-gigabyte Memchunk costs next to nothing until it is used.
+ * MEMC_HUGE_PAGES additionally backs the Memchunk with 2 MB pages, which
+ * cuts TLB misses for large, randomly accessed Memchunks. See `memc_dbg`
+ * for whether explicit or transparent huge pages were obtained. With
+ * MEMC_TLSF, free blocks are kept in two-level segregated fit lists, so
+ * finding a block takes a bounded number of steps whatever the heap looks
+ * like, at the price of a slightly less tight fit. With MEMC_BEST_FIT, free
+ * blocks are kept in a treap ordered by (size, address), and a request gets
+ * the smallest free block that fits, the lowest one among equals, in
+ * O(log n); this is the tightest placement, for fragmentation-sensitive
+ * long-running heaps, at a higher cost per operation. It overrides
+ * MEMC_TLSF. MEMC_BUDDY makes a buddy
+ * allocator as `memc_init_buddy` does, with 64-byte smallest blocks, and
+ * overrides the other layout flags.
+ * 
+ * @param name The name of the Memchunk to initialize.
+ * @param total_size The total size of the memory Memchunk.
+ * @param flags A combination of MEMC_* flags, or 0.
+ * 
+ * @return A pointer to the initialized Memchunk structure, or NULL if memory 
+ *         allocation fails.
+ * 
+ * Example usage:
+ * ```
+ * Memchunk* shared = memc_init_flags("Shared", 64 * 1024 * 1024, MEMC_THREAD_SAFE);
+ * ```
+ */
+Memchunk* memc_init_flags(const char* name, size_t total_size, unsigned flags) {
+    Memchunk* new_Memchunk = chunk_create(name, total_size, flags);
+    if (new_Memchunk == NULL) return NULL;
+
+    chunk_register(new_Memchunk);
+    return new_Memchunk;
+}
+
+/**
+ * @brief Initializes a new arena Memchunk for data that is discarded all at once.
+ * 
+ * An arena hands out memory by bumping a pointer: allocations have no header
+ * and there is no free list. `memory_free` and `memory_free_ptr` do nothing
+ * on an arena; the whole arena is reclaimed at once with `memc_reset`. Names
+ * still work with `memory_find`.
+ * 
+ * @param name The name of the arena.
+ * @param total_size The total size of the arena.
+ * 
+ * @return A pointer to the initialized Memchunk structure, or NULL if memory 
+ *         allocation fails.
+ * 
+ * Example usage:
+ * ```
+ * Memchunk* frame = memc_init_arena("Frame", 256 * 1024);
+ * // ... allocate freely while handling one frame ...
+ * memc_reset(frame);
+ * ```
+ */
+Memchunk* memc_init_arena(const char* name, size_t total_size) {
+    return memc_init_flags(name, total_size, MEMC_ARENA);
+}
+
+/**
+ * @brief Initializes a new Memchunk managed as a binary buddy allocator.
+ * 
+ * Every block is a power of two in size, from 2^min_order bytes up to the
+ * whole pool, which is `total_size` rounded down to a power of two. Free
+ * blocks are kept in one list per order. An allocation takes the smallest
+ * order that fits, splitting a larger free block in halves when needed. A
+ * freed block merges with its buddy, the other half of the block it was
+ * split from, found by flipping one bit of its offset, for as long as the
+ * buddy is free too. A bitmap with one bit per smallest block tells which
+ * blocks are free, so both take O(log n) steps with no search.
+ * 
+ * Blocks have no header: a power-of-two request gets a block of exactly its
+ * size, aligned to that size up to a page, which suits I/O buffers and hash
+ * tables. The rounding of other sizes is internal fragmentation, which
+ * `memc_dbg` reports. `memory_alloc`, `memory_free`, `memory_free_ptr` and
+ * the other block functions work as for any Memchunk. Named blocks keep
+ * their hash in a side array with one entry per smallest block, so freeing
+ * one finds its index slot in O(1). Decay does not apply; `memc_trim` does.
+ * For a thread-safe buddy allocator with 64-byte smallest blocks, pass
+ * MEMC_BUDDY | MEMC_THREAD_SAFE to `memc_init_flags`.
+ * 
+ * @param name The name of the Memchunk to initialize.
+ * @param total_size The size of the pool.
+ * @param min_order Log2 of the smallest block size; values below 4 are
+ *                  raised to it.
+ * 
+ * @return A pointer to the initialized Memchunk structure, or NULL if memory 
+ *         allocation fails.
+ * 
+ * Example usage:
+ * ```
+ * Memchunk* buffers = memc_init_buddy("Buffers", 64 * 1024 * 1024, 12);
+ * void* page = memory_alloc(buffers, 4096, NULL);  // A 4 KiB block, page aligned
+ * ```
+ */
+Memchunk* memc_init_buddy(const char* name, size_t total_size, unsigned min_order) {
+    Memchunk* new_Memchunk = memc_init_flags(name, total_size, MEMC_BUDDY);
+    if (new_Memchunk == NULL) return NULL;
+
+    if (buddy_setup(new_Memchunk, min_order) != 0) {
+        memc_dealloc(new_Memchunk);
+        return NULL;
+    }
+    chunk_format(new_Memchunk);
+    return new_Memchunk;
+}
+
+static void* chunk_alloc(Memchunk* Memchunk, size_t size, size_t align, const char* block_name, int zero);
+
+/**
+ * @brief Saves the name index of a MEMC_FILE Memchunk into a block of its own
+ * and flushes the file; the caller holds the lock.
+ *
+ * The block holding the names saved last time is freed first.
+ *
+ * @return 0 on success, -1 if the names do not fit or the flush fails.
+ */
+static int file_save(Memchunk* Memchunk) {
+    FileHeader* header = file_header(Memchunk);
+    if (header->names != CEIT_NIL) {
+        release_block(Memchunk, block_at(Memchunk, header->names));
+        header->names = CEIT_NIL;
+        header->name_count = 0;
+    }
+
+    if (Memchunk->name_count) {
+        FileName* names = (FileName*)chunk_alloc(Memchunk, CEIT_ROUND_UP(Memchunk->name_count * sizeof(FileName), CEIT_ALIGN), CEIT_ALIGN, NULL, 0);
+        if (!names) return -1;
+        size_t count = 0;
+        for (size_t i = 0; i < Memchunk->name_capacity; i++) {
+            if (!Memchunk->name_index[i].block) continue;
+            names[count].offset = block_offset(Memchunk, Memchunk->name_index[i].block);
+            memcpy(names[count].name, nameindex_name(Memchunk, i), CEIT_NAME_LEN);
+            count++;
+        }
+        header->names = block_offset(Memchunk, block_of(names));
+        header->name_count = count;
+    }
+    return msync(header, header->file_size, MS_SYNC) == 0 ? 0 : -1;
+}
+
+/**
+ * @brief Rebuilds the free lists, statistics and name index of a MEMC_FILE
+ * Memchunk from the blocks in its file.
+ *
+ * The block sizes must tile the memory pool exactly, and two free blocks
+ * may not be adjacent; otherwise the file is rejected. Saved names are
+ * restored only for live blocks whose header hash matches; blocks named
+ * after the last save lose their names.
+ *
+ * @return 0 on success, -1 if the file does not hold a valid Memchunk.
+ */
+static int file_load(Memchunk* Memchunk) {
+    FileHeader* header = file_header(Memchunk);
+    const char* end = (const char*)(Memchunk->memory_pool + 1) + Memchunk->total_size;
+    for (Memory* block = Memchunk->memory_pool;; block = block_next(Memchunk, block)) {
+        size_t size = block_size(block), room = (size_t)(end - (const char*)(block + 1));
+        if (size < CEIT_MIN_PAYLOAD || size % CEIT_ALIGN || size > room || (size < room && room - size < sizeof(Memory) + CEIT_MIN_PAYLOAD)) return -1;
+        if (size == room) break;
+    }
+
+    for (int i = 0; i < CEIT_SIZE_CLASSES; i++) Memchunk->free_lists[i] = CEIT_NIL;
+    Memchunk->free_map = 0;
+    Memchunk->fit_root = CEIT_NIL;
+    Memchunk->largest_free = 0;
+    Memchunk->largest_stale = 0;
+    Memchunk->used_memory = 0;
+    Memchunk->tail_free = 0;
+    Memchunk->stats.free_blocks = 0;
+
+    Memory* saved = NULL;
+    int prev_free = 0;
+    for (Memory* block = Memchunk->memory_pool; block; block = block_next(Memchunk, block)) {
+        block_set_prev_free(block, prev_free);
+        if (block_offset(Memchunk, block) == header->names && !(block->size & CEIT_BLOCK_FREE)) saved = block;
+        if (!(block->size & CEIT_BLOCK_FREE)) {
+            block->size &= ~(size_t)CEIT_BLOCK_NAMED;  // Set again for the saved names below
+            Memchunk->used_memory += block_size(block);
+            Memchunk->stats.live_blocks++;
+            prev_free = 0;
+            continue;
+        }
+        if (prev_free) return -1;  // Free neighbours are always merged
+
+        block->name_hash = 0;  // Dirty, as far as anyone can tell
+        mark_free(Memchunk, block);
+        freelist_insert(Memchunk, block);
+        prev_free = 1;
+    }
+    Memchunk->free_memory = Memchunk->total_size - Memchunk->used_memory;  // Headers count as free, as in chunk_format
+
+    // Restore the saved names, then free the block that held them
+    size_t count = saved && header->name_count <= block_size(saved) / sizeof(FileName) ? header->name_count : 0;
+    FileName* names = saved ? (FileName*)(saved + 1) : NULL;
+    size_t capacity = CEIT_NAME_INDEX_MIN;
+    while (count * 4 > capacity * 3) capacity *= 2;
+    if (capacity > Memchunk->name_capacity) nameindex_resize(Memchunk, capacity);  // Sized once, not doubled name by name
+    for (size_t i = 0; i < count; i++) {
+        if (names[i].offset % CEIT_ALIGN || names[i].offset >= Memchunk->total_size || memchr(names[i].name, '\0', CEIT_NAME_LEN) == NULL) continue;
+        Memory* block = block_at(Memchunk, names[i].offset);
+        if ((block->size & (CEIT_BLOCK_FREE | CEIT_BLOCK_NAMED)) || block->name_hash != name_hash(names[i].name)) continue;
+        if (nameindex_lookup(Memchunk, names[i].name) >= 0 || nameindex_reserve(Memchunk) != 0) continue;
+        block->size |= CEIT_BLOCK_NAMED;
+        unsigned tag = tag_intern(Memchunk, names[i].name);
+        nameindex_place(Memchunk->name_index, Memchunk->name_text, Memchunk->name_capacity, block->name_hash, block, names[i].name, tag);
+        Memchunk->name_count++;
+        Memchunk->tags[tag].live_bytes += block_size(block);
+        Memchunk->tags[tag].live_blocks++;
+    }
+    header->names = CEIT_NIL;
+    header->name_count = 0;
+    if (saved) release_block(Memchunk, saved);
+    return 0;
+}
+
+/**
+ * @brief Opens a Memchunk kept in a file, creating the file if needed.
+ * 
+ * The file is mapped with `mmap(MAP_SHARED)` and holds the memory pool
+ * itself, after a one-page header. Blocks are laid out back to back and the
+ * free lists link them by offset, so the pool works at whatever address it
+ * is mapped. A new file is created with room for `total_size` bytes; its
+ * pages only take disk space once written. An existing file is reopened as
+ * it was last left, and `total_size` is ignored. The free lists and
+ * statistics are rebuilt from the block headers in one pass, so a large
+ * index is usable right after a restart instead of being rebuilt. Blocks
+ * keep their data at the same offsets, and names saved by `memc_sync` or
+ * `memc_dealloc` find them again with `memory_find`.
+ * 
+ * Freed pages are punched out of the file by `memc_trim` and decay. A
+ * file-backed Memchunk is not thread-safe and cannot grow. A file written
+ * with a different block layout or page size is rejected.
+ * 
+ * @param path The file to open or create.
+ * @param total_size The size of the memory pool of a new file.
+ * 
+ * @return A pointer to the Memchunk, or NULL if the file cannot be opened or
+ *         mapped, or does not hold a valid Memchunk.
+ * 
+ * Example usage:
+ * ```
+ * Memchunk* index = memc_open_file("/var/lib/app/index.heap", 1ULL << 30);
+ * Entry* root = memory_find(index, "Root");
+ * if (!root) root = memory_calloc(index, 1, sizeof(Entry), "Root");
+ * ```
+ */
+Memchunk* memc_open_file(const char* path, size_t total_size) {
+    if (!path) return NULL;
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return NULL;
+
+    size_t page = page_size(), file_size = 0;
+    struct stat info;
+    int fresh = fstat(fd, &info) == 0 && info.st_size == 0;
+    if (fresh) {
+        file_size = total_size >= CEIT_MIN_PAYLOAD && total_size <= SIZE_MAX / 2 ? page + CEIT_ROUND_UP(total_size + sizeof(Memory), page) : 0;
+        if (file_size && ftruncate(fd, (off_t)file_size) != 0) file_size = 0;
+    } else if (fstat(fd, &info) == 0) {
+        file_size = (size_t)info.st_size;
+    }
+    void* region = file_size >= 2 * page ? mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);  // The mapping keeps the file open
+    if (region == MAP_FAILED) return NULL;
+
+    FileHeader* header = (FileHeader*)region;
+    Memchunk* new_Memchunk = NULL;
+    if (fresh || (memcmp(header->magic, CEIT_FILE_MAGIC, sizeof(header->magic)) == 0 && header->version == CEIT_FILE_VERSION &&
+                  header->align == CEIT_ALIGN && header->page == page && header->file_size == file_size)) {
+        new_Memchunk = (Memchunk*)calloc(1, sizeof(Memchunk));
+    }
+    if (new_Memchunk == NULL) {
+        munmap(region, file_size);
+        return NULL;
+    }
+
+    const char* name = strrchr(path, '/');
+    strncpy(new_Memchunk->name, name ? name + 1 : path, sizeof(new_Memchunk->name));
+    new_Memchunk->name[sizeof(new_Memchunk->name) - 1] = '\0';
+    new_Memchunk->flags = MEMC_FILE;
+    new_Memchunk->memory_pool = (Memory*)((char*)region + page);
+    new_Memchunk->total_size = file_size - page - sizeof(Memory);
+    new_Memchunk->reserve_size = new_Memchunk->total_size;
+    new_Memchunk->chain_size = new_Memchunk->total_size;
+    new_Memchunk->commit_unit = page;
+
+    if (fresh) {
+        memcpy(header->magic, CEIT_FILE_MAGIC, sizeof(header->magic));
+        header->version = CEIT_FILE_VERSION;
+        header->align = CEIT_ALIGN;
+        header->page = page;
+        header->file_size = file_size;
+        chunk_format(new_Memchunk);
+        new_Memchunk->memory_pool->name_hash = CEIT_FREE_PURGED | CEIT_FREE_ZERO;  // The file reads as zero and takes no space yet
+    } else if (file_load(new_Memchunk) != 0) {
+        free(new_Memchunk->name_index);
+        free(new_Memchunk->name_text);
+        free(new_Memchunk->tags);
+        free(new_Memchunk->tag_index);
+        free(new_Memchunk);
+        munmap(region, file_size);
+        return NULL;
+    }
+
+    new_Memchunk->id = __atomic_fetch_add(&next_memchunk_id, 1, __ATOMIC_RELAXED);
+    chunk_register(new_Memchunk);
+    return new_Memchunk;
+}
+
+/**
+ * @brief Saves a file-backed Memchunk's names and flushes it to the file.
+ * 
+ * When it returns, the file holds everything written to the Memchunk so
+ * far, and reopening it finds the named blocks that are live at this
+ * point. The names are saved in a block of the Memchunk, which counts as
+ * used until the file is reopened or the next call replaces it.
+ * `memc_dealloc` and `mem_clr` do the same before unmapping the file.
+ * 
+ * The file is only guaranteed to be consistent as of the last call: after
+ * a crash, pages written since then may or may not have reached it.
+ * 
+ * @param Memchunk The Memchunk returned by `memc_open_file`.
+ * 
+ * @return 0 on success, -1 if the Memchunk is not file-backed, the names do
+ *         not fit in it or the flush fails.
+ * 
+ * Example usage:
+ * ```
+ * if (memc_sync(index) != 0) {
+ *     // Handle the failed durability point
+ * }
+ * ```
+ */
+int memc_sync(Memchunk* Memchunk) {
+    if (!Memchunk || !(Memchunk->flags & MEMC_FILE)) return -1;
+
+    chunk_lock(Memchunk);
+    int status = file_save(Memchunk);
+    chunk_unlock(Memchunk);
+    return status;
+}
+
+/**
+ * @brief Maps the shared memory object `path` and attaches to it, creating
+ * it if it does not exist yet and `total_size` is not 0.
+ *
+ * @return The mapped header, or NULL on failure. `map_size` receives the
+ *         size of the mapping; `retry` is set if the object was being removed.
+ */
+static SharedHeader* shared_attach(const char* path, size_t total_size, size_t* map_size, int* created, int* retry) {
+    size_t page = page_size();
+    *created = 0;
+    *retry = 0;
+    int fd = total_size ? shm_open(path, O_RDWR | O_CREAT | O_EXCL, 0600) : -1;
+    if (fd >= 0) {
+        *created = 1;
+        *map_size = page + CEIT_ROUND_UP(total_size + sizeof(Memory), page);
+        if (ftruncate(fd, (off_t)*map_size) != 0) {
+            close(fd);
+            shm_unlink(path);
+            return NULL;
+        }
+    } else {
+        if ((total_size && errno != EEXIST) || (fd = shm_open(path, O_RDWR, 0)) < 0) {
+            *retry = total_size && errno == ENOENT;  // Removed between the two calls
+            return NULL;
+        }
+        // The creator may not have sized the object yet
+        struct stat info;
+        for (int waited = 0; fstat(fd, &info) == 0 && info.st_size == 0 && waited < CEIT_SHARED_WAIT_MS; waited++) usleep(1000);
+        *map_size = fstat(fd, &info) == 0 ? (size_t)info.st_size : 0;
+    }
+    void* region = *map_size >= 2 * page ? mmap(NULL, *map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);  // The mapping keeps the object open
+    if (region == MAP_FAILED) {
+        if (*created) shm_unlink(path);
+        return NULL;
+    }
+
+    SharedHeader* header = (SharedHeader*)region;
+    if (*created) {
+        header->version = CEIT_SHARED_VERSION;
+        header->align = CEIT_ALIGN;
+        header->page = page;
+        header->map_size = *map_size;
+        strcpy(header->path, path);
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+        pthread_mutex_init(&header->lock, &attr);
+        pthread_mutexattr_destroy(&attr);
+        header->attached = 1;
+        return header;  // The caller formats the pool, then publishes the magic
+    }
+
+    // Wait for the creator to publish the header
+    for (int waited = 0; waited < CEIT_SHARED_WAIT_MS; waited++) {
+        if (__atomic_load_n(&header->magic[0], __ATOMIC_ACQUIRE) == CEIT_SHARED_MAGIC[0]) break;
+        usleep(1000);
+    }
+    if (memcmp(header->magic, CEIT_SHARED_MAGIC, sizeof(header->magic)) != 0 || header->version != CEIT_SHARED_VERSION ||
+        header->align != CEIT_ALIGN || header->page != page || header->map_size != *map_size) {
+        munmap(region, *map_size);
+        return NULL;
+    }
+    shared_lock(header);
+    *retry = header->closed;  // The last process detached while we were opening it
+    if (!*retry) header->attached++;
+    pthread_mutex_unlock(&header->lock);
+    if (*retry) {
+        munmap(region, *map_size);
+        return NULL;
+    }
+    return header;
+}
+
+/**
+ * @brief Creates or attaches to a Memchunk in shared memory that several
+ * processes allocate from concurrently.
+ * 
+ * The Memchunk lives in a POSIX shared memory object named after `name`
+ * (see `shm_open`). The first process to call this creates the object with
+ * room for `total_size` bytes; later ones map the same object, and their
+ * `total_size` is ignored. Every process may then allocate and free blocks
+ * with the usual functions. Free lists link blocks by offset, and the
+ * allocator state sits next to a process-shared lock in the object's
+ * header, so each process can map the object at a different address. A
+ * process that dies while holding the lock does not block the others, but
+ * it may have left the allocator state half updated, so the Memchunk is
+ * poisoned: from then on allocations return NULL and frees are ignored in
+ * every process, while the data of live blocks stays readable. `memc_reset`
+ * formats the pool anew and lifts the poison.
+ * 
+ * Blocks are handed between processes without copying: the producer passes
+ * `memc_offset` of its block, and the consumer turns it back into a pointer
+ * into its own mapping with `memc_pointer`, then may free it. Blocks cannot
+ * have names, as the name index would only exist in one process, and the
+ * Memchunk cannot grow. It is always thread-safe; blocks bypass the thread
+ * caches so that a block freed in one process is at once free in all.
+ * 
+ * `memc_dealloc` detaches the calling process. The last process to detach
+ * removes the object's name, and the memory is released when the last
+ * mapping goes away.
+ * 
+ * @param name The name of the shared Memchunk. A leading '/' is added if
+ *             missing; it may not contain any other '/'.
+ * @param total_size The size of the memory pool, if the Memchunk is created;
+ *                   0 to only attach to an existing one.
+ * 
+ * @return A pointer to this process's view of the Memchunk, or NULL if the
+ *         object cannot be created or mapped, or was created by an
+ *         incompatible version of the library.
+ * 
+ * Example usage:
+ * ```
+ * // Producer
+ * Memchunk* ring = memc_init_shared("jobs", 256 * 1024 * 1024);
+ * Job* job = memory_alloc(ring, sizeof(Job), NULL);
+ * size_t handle = memc_offset(ring, job);  // Send the handle down a pipe or queue
+ * 
+ * // Worker
+ * Memchunk* ring = memc_init_shared("jobs", 0);  // Attach only
+ * Job* job = memc_pointer(ring, handle);
+ * // ... process the job ...
+ * memory_free_ptr(ring, job);
+ * ```
+ */
+Memchunk* memc_init_shared(const char* name, size_t total_size) {
+    if (!name || !name[0]) return NULL;
+    total_size &= ~(size_t)(CEIT_ALIGN - 1);
+
+    char path[sizeof(((SharedHeader*)0)->path)];
+    if (snprintf(path, sizeof(path), "%s%s", name[0] == '/' ? "" : "/", name) >= (int)sizeof(path) || strchr(path + 1, '/')) return NULL;
+
+    Memchunk* new_Memchunk = (Memchunk*)calloc(1, sizeof(Memchunk));
+    if (new_Memchunk == NULL) return NULL;
+
+    SharedHeader* header = NULL;
+    size_t map_size = 0;
+    int created = 0, retry = 1;
+    if (total_size < CEIT_MIN_PAYLOAD || total_size > SIZE_MAX / 2) total_size = 0;  // Only attach
+    for (int attempt = 0; !header && retry && attempt < 3; attempt++) {
+        header = shared_attach(path, total_size, &map_size, &created, &retry);
+    }
+    if (!header) {
+        free(new_Memchunk);
+        return NULL;
+    }
+
+    strncpy(new_Memchunk->name, path + 1, sizeof(new_Memchunk->name));
+    new_Memchunk->name[sizeof(new_Memchunk->name) - 1] = '\0';
+    new_Memchunk->flags = MEMC_SHARED | MEMC_THREAD_SAFE;
+    new_Memchunk->memory_pool = (Memory*)((char*)header + header->page);
+    new_Memchunk->total_size = map_size - header->page - sizeof(Memory);
+    new_Memchunk->reserve_size = new_Memchunk->total_size;
+    new_Memchunk->chain_size = new_Memchunk->total_size;
+    new_Memchunk->commit_unit = header->page;
+    pthread_mutex_init(&new_Memchunk->lock, NULL);
+    pthread_mutex_init(&new_Memchunk->grow_lock, NULL);
+
+    if (created) {
+        chunk_format(new_Memchunk);
+        new_Memchunk->memory_pool->name_hash = CEIT_FREE_PURGED | CEIT_FREE_ZERO;  // The object reads as zero and is not backed yet
+        shared_lock(header);
+        chunk_unlock(new_Memchunk);  // Publishes the state
+        memcpy(header->magic + 1, CEIT_SHARED_MAGIC + 1, sizeof(header->magic) - 1);
+        __atomic_store_n(&header->magic[0], CEIT_SHARED_MAGIC[0], __ATOMIC_RELEASE);
+    }
+
+    new_Memchunk->id = __atomic_fetch_add(&next_memchunk_id, 1, __ATOMIC_RELAXED);
+    chunk_register(new_Memchunk);
+    return new_Memchunk;
+}
+
+/**
+ * @brief Returns the offset of a block in its Memchunk.
+ * 
+ * Offsets count from the start of the Memchunk's memory pool, so they stay
+ * valid wherever the pool is mapped: in another process attached to the
+ * same shared Memchunk, or after a file-backed Memchunk is reopened.
+ * 
+ * @param Memchunk The Memchunk that holds the block.
+ * @param ptr A pointer into the block's data, as returned by the allocation.
+ * 
+ * @return The offset of `ptr`, or (size_t)-1 if it is not inside the Memchunk.
+ * 
+ * Example usage:
+ * ```
+ * size_t handle = memc_offset(ring, job);
+ * ```
+ */
+size_t memc_offset(Memchunk* Memchunk, const void* ptr) {
+    if (!Memchunk || !ptr || !chunk_owns(Memchunk, ptr)) return CEIT_NIL;
+    return (size_t)((const char*)ptr - (const char*)Memchunk->memory_pool);
+}
+
+/**
+ * @brief Returns the pointer at an offset given by `memc_offset`.
+ * 
+ * @param Memchunk The Memchunk the offset refers to, as mapped by the
+ *                 calling process.
+ * @param offset The offset from `memc_offset`.
+ * 
+ * @return The pointer into this process's mapping, or NULL if the offset is
+ *         outside the Memchunk.
+ * 
+ * Example usage:
+ * ```
+ * Job* job = memc_pointer(ring, handle);
+ * ```
+ */
+void* memc_pointer(Memchunk* Memchunk, size_t offset) {
+    if (!Memchunk || offset < sizeof(Memory) || offset - sizeof(Memory) >= Memchunk->total_size) return NULL;
+    return (char*)Memchunk->memory_pool + offset;
+}
+
+/**
+ * @brief Lets a Memchunk grow by chaining new Memchunks when it runs out of space.
+ * 
+ * Once enabled, an allocation that does not fit in the Memchunk is tried in
+ * the Memchunks chained after it through `next`. If none has room, a new
+ * Memchunk with the same flags is created and appended. The first one has
+ * `initial_size` bytes and each following one is `growth_factor` times
+ * larger, or just large enough for the request. Frees find the chain member
+ * that owns a block by address, and `memc_dbg` reports totals for the
+ * whole chain. Chain members are released with the head. A file-backed
+ * or shared Memchunk cannot grow.
+ * 
+ * @param Memchunk The head of the chain.
+ * @param initial_size The size of the first added Memchunk, or 0 to use the
+ *                     head's size.
+ * @param growth_factor How much larger each added Memchunk is than the
+ *                      previous one; at least 1.
+ * @param max_size The cap on the total size of the chain, or 0 for no cap.
+ * 
+ * @return 0 on success, -1 if the arguments are invalid or the Memchunk is
+ *         file-backed or shared.
+ * 
+ * Example usage:
+ * ```
+ * Memchunk* chunk = memc_init("Elastic", 1024 * 1024);
+ * memc_set_growth(chunk, 0, 2.0, 256 * 1024 * 1024);
+ * ```
+ */
+int memc_set_growth(Memchunk* Memchunk, size_t initial_size, double growth_factor, size_t max_size) {
+    if (!Memchunk || growth_factor < 1.0 || (Memchunk->flags & (MEMC_FILE | MEMC_SHARED))) return -1;
+
+    chunk_lock(Memchunk);
+    Memchunk->grow_size = initial_size ? initial_size : Memchunk->reserve_size;
+    Memchunk->grow_factor = growth_factor;
+    Memchunk->grow_limit = max_size;
+    chunk_unlock(Memchunk);
+    return 0;
+}
+
+/**
+ * @brief Turns on time-based purging of memory that stays free.
+ * 
+ * A free block of at least one page that stays free for `decay_ms`
+ * milliseconds has its whole pages returned to the OS, as `memc_trim` does.
+ * Decay is lazy and adds no thread. It runs, at most every quarter of
+ * `decay_ms`, when a large block is freed, on every 64th allocation that
+ * takes the lock, and from `memc_stats`; small frees never read the clock.
+ * A Memchunk that sees none of these calls never decays, so an idle program
+ * that wants its memory back calls `memc_trim` or `memc_stats` from a timer.
+ * Arenas are only purged by `memc_trim`. The setting applies to the whole
+ * growth chain.
+ * 
+ * @param Memchunk The Memchunk to configure.
+ * @param decay_ms How long memory stays free before it is purged, or 0 to
+ *                 turn decay off.
+ * 
+ * @return 0 on success, -1 if `Memchunk` is NULL.
+ * 
+ * Example usage:
+ * ```
+ * memc_set_decay(chunk, 10 * 1000);  // Give back memory idle for 10 seconds
+ * ```
+ */
+int memc_set_decay(Memchunk* Memchunk, unsigned decay_ms) {
+    if (!Memchunk) return -1;
+
+    for (; Memchunk; Memchunk = chain_next(Memchunk)) {
+        chunk_lock(Memchunk);
+        Memchunk->decay_ms = decay_ms;
+        Memchunk->decay_next = 0;
+        chunk_unlock(Memchunk);
+    }
+    return 0;
+}
+
+/** Bytes this thread still allocates before its next sample, and its random state; shared by all Memchunks. */
+static __thread size_t profile_countdown;
+static __thread unsigned long long profile_random;
+
+/**
+ * @brief Draws the number of bytes until the next sample from an exponential
+ * distribution with mean `rate`, so that every byte is equally likely to be
+ * sampled whatever the allocation pattern.
+ *
+ * ln(u) is computed from the binary exponent of u and a short series for
+ * the mantissa, which keeps libm out of the library.
+ */
+static size_t profile_interval(size_t rate) {
+    if (!profile_random) profile_random = fit_priority((size_t)&profile_random ^ clock_ms()) | 1;
+    unsigned long long x = profile_random;  // xorshift64*
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    profile_random = x;
+
+    // u = r / 2^53 with r in [1, 2^53], and ln(r) = e ln(2) + ln(m) for m = r / 2^e in [1, 2)
+    unsigned long long r = ((x * 0x2545F4914F6CDD1DULL) >> 11) + 1;
+    int e = 63 - __builtin_clzll(r);
+    double m = (double)r / (double)(1ULL << e);
+    double t = (m - 1) / (m + 1), t2 = t * t;
+    double ln_m = 2 * t * (1 + t2 * (1.0 / 3 + t2 * (1.0 / 5 + t2 * (1.0 / 7 + t2 / 9))));
+    double interval = ((53 - e) * 0.6931471805599453 - ln_m) * (double)rate;
+    if (interval < 1) return 1;
+    return interval < (double)(SIZE_MAX / 2) ? (size_t)interval : SIZE_MAX / 2;
+}
+
+/**
+ * @brief Returns the filter counter of a data pointer.
+ *
+ * Neighbouring blocks get different counters, and the filter is small
+ * enough to stay in the L1 cache of a thread that frees a lot.
+ */
+static unsigned char* profile_filter(Memprofile* profile, const void* ptr) {
+    return &profile->filter[((uintptr_t)ptr / CEIT_ALIGN) & (CEIT_PROFILE_FILTER - 1)];
+}
+
+/**
+ * @brief Finds or adds the site of a stack trace; the caller holds the profile lock.
+ *
+ * @return The index of the site, or CEIT_NIL if the tables could not grow.
+ */
+static size_t profile_site(Memprofile* profile, void** frames, int depth) {
+    size_t hash = 0;
+    for (int i = 0; i < depth; i++) hash = fit_priority(hash ^ (size_t)frames[i]);
+
+    if (profile->site_count * 2 >= profile->site_capacity) {
+        size_t capacity = profile->site_capacity ? profile->site_capacity * 2 : CEIT_PROFILE_TABLE_MIN;
+        ProfileSite* sites = realloc(profile->sites, capacity * sizeof(ProfileSite));
+        if (!sites) return CEIT_NIL;
+        profile->sites = sites;
+        size_t* index = malloc(capacity * sizeof(size_t));
+        if (!index) return CEIT_NIL;
+        memset(index, 0xff, capacity * sizeof(size_t));  // CEIT_NIL everywhere
+        for (size_t site = 0; site < profile->site_count; site++) {
+            size_t slot = sites[site].hash & (capacity - 1);
+            while (index[slot] != CEIT_NIL) slot = (slot + 1) & (capacity - 1);
+            index[slot] = site;
+        }
+        free(profile->site_index);
+        profile->site_index = index;
+        profile->site_capacity = capacity;
+    }
+
+    size_t mask = profile->site_capacity - 1;
+    size_t slot = hash & mask;
+    for (; profile->site_index[slot] != CEIT_NIL; slot = (slot + 1) & mask) {
+        ProfileSite* site = &profile->sites[profile->site_index[slot]];
+        if (site->hash == hash && site->depth == depth && memcmp(site->frames, frames, depth * sizeof(void*)) == 0) {
+            return profile->site_index[slot];
+        }
+    }
+
+    ProfileSite* site = &profile->sites[profile->site_count];
+    memset(site, 0, sizeof(ProfileSite));
+    site->hash = hash;
+    site->depth = depth;
+    memcpy(site->frames, frames, depth * sizeof(void*));
+    profile->site_index[slot] = profile->site_count;
+    return profile->site_count++;
+}
+
+/**
+ * @brief Adds a live sample to the address table; the caller holds the profile lock.
+ *
+ * @return 0 on success, -1 if the table could not grow.
+ */
+static int profile_insert(Memprofile* profile, const void* ptr, size_t size, size_t site) {
+    if (profile->sample_count * 2 >= profile->sample_capacity) {
+        size_t capacity = profile->sample_capacity ? profile->sample_capacity * 2 : CEIT_PROFILE_TABLE_MIN;
+        ProfileSample* samples = calloc(capacity, sizeof(ProfileSample));
+        if (!samples) return -1;
+        for (size_t i = 0; i < profile->sample_capacity; i++) {
+            if (!profile->samples[i].ptr) continue;
+            size_t slot = fit_priority((size_t)profile->samples[i].ptr) & (capacity - 1);
+            while (samples[slot].ptr) slot = (slot + 1) & (capacity - 1);
+            samples[slot] = profile->samples[i];
+        }
+        free(profile->samples);
+        profile->samples = samples;
+        profile->sample_capacity = capacity;
+    }
 
-/** Global pointer to the head of the Memchunk list. */
-Memchunk* global_memchunk_list = NULL;
+    size_t mask = profile->sample_capacity - 1;
+    size_t slot = fit_priority((size_t)ptr) & mask;
+    while (profile->samples[slot].ptr) slot = (slot + 1) & mask;
+    profile->samples[slot] = (ProfileSample){ptr, size, site};
+    profile->sample_count++;
+    return 0;
+}
 
 /**
- * @brief Initializes a new memory Memchunk with the given name and total size.
+ * @brief Records a sampled allocation with the stack trace that made it.
+ */
+static void profile_sample(Memprofile* profile, const void* ptr, size_t size) {
+    // Unwind outside the lock; the first frame is this function
+    void* frames[CEIT_PROFILE_DEPTH + 1];
+    int depth = backtrace(frames, CEIT_PROFILE_DEPTH + 1) - 1;
+    if (depth < 0) depth = 0;
+
+    pthread_mutex_lock(&profile->lock);
+    size_t site = profile_site(profile, frames + 1, depth);
+    if (site != CEIT_NIL && profile_insert(profile, ptr, size, site) == 0) {
+        ProfileSite* entry = &profile->sites[site];
+        entry->alloc_count++;
+        entry->alloc_bytes += size;
+        entry->live_count++;
+        entry->live_bytes += size;
+        unsigned char* counter = profile_filter(profile, ptr);
+        if (*counter != UCHAR_MAX) __atomic_store_n(counter, (unsigned char)(*counter + 1), __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&profile->lock);
+}
+
+/**
+ * @brief Counts `size` requested bytes against this thread's countdown and
+ * samples the allocation at `ptr` when the countdown runs out.
+ */
+static void profile_alloc(Memchunk* Memchunk, const void* ptr, size_t size) {
+    Memprofile* profile = __atomic_load_n(&Memchunk->profile, __ATOMIC_ACQUIRE);
+    if (!profile) return;
+    size_t rate = __atomic_load_n(&profile->rate, __ATOMIC_RELAXED);
+    if (!rate) return;
+
+    if (!profile_random) profile_countdown = profile_interval(rate);  // Start the thread at a random point
+    if (profile_countdown > size) {
+        profile_countdown -= size;
+        return;
+    }
+    profile_countdown = profile_interval(rate);
+    profile_sample(profile, ptr, size);
+}
+
+/**
+ * @brief Drops the live sample at `ptr`, if there is one.
+ *
+ * Most freed blocks were never sampled; their filter counter is zero and
+ * the lock is not taken.
+ */
+static void profile_forget(Memchunk* Memchunk, const void* ptr) {
+    Memprofile* profile = __atomic_load_n(&Memchunk->profile, __ATOMIC_ACQUIRE);
+    if (!profile) return;
+    unsigned char* counter = profile_filter(profile, ptr);
+    if (!__atomic_load_n(counter, __ATOMIC_RELAXED)) return;
+
+    pthread_mutex_lock(&profile->lock);
+    size_t mask = profile->sample_capacity - 1;
+    size_t slot = fit_priority((size_t)ptr) & mask;
+    for (; profile->samples[slot].ptr; slot = (slot + 1) & mask) {
+        if (profile->samples[slot].ptr != ptr) continue;
+
+        ProfileSite* site = &profile->sites[profile->samples[slot].site];
+        site->live_count--;
+        site->live_bytes -= profile->samples[slot].size;
+        profile->sample_count--;
+        if (*counter != UCHAR_MAX) __atomic_store_n(counter, (unsigned char)(*counter - 1), __ATOMIC_RELAXED);  // A full counter no longer knows its count
+
+        // Backward-shift deletion keeps every probe sequence unbroken
+        size_t hole = slot;
+        for (size_t next = (hole + 1) & mask; profile->samples[next].ptr; next = (next + 1) & mask) {
+            size_t home = fit_priority((size_t)profile->samples[next].ptr) & mask;
+            if (((next - home) & mask) >= ((next - hole) & mask)) {
+                profile->samples[hole] = profile->samples[next];
+                hole = next;
+            }
+        }
+        profile->samples[hole].ptr = NULL;
+        break;
+    }
+    pthread_mutex_unlock(&profile->lock);
+}
+
+/**
+ * @brief Drops every live sample, keeping the cumulative counts of the sites.
+ */
+static void profile_clear_live(Memprofile* profile) {
+    if (!profile) return;
+    pthread_mutex_lock(&profile->lock);
+    if (profile->samples) memset(profile->samples, 0, profile->sample_capacity * sizeof(ProfileSample));
+    profile->sample_count = 0;
+    for (size_t site = 0; site < profile->site_count; site++) {
+        profile->sites[site].live_count = 0;
+        profile->sites[site].live_bytes = 0;
+    }
+    memset(profile->filter, 0, sizeof(profile->filter));
+    pthread_mutex_unlock(&profile->lock);
+}
+
+/**
+ * @brief Frees a heap profile; NULL is ignored.
+ */
+static void profile_destroy(Memprofile* profile) {
+    if (!profile) return;
+    pthread_mutex_destroy(&profile->lock);
+    free(profile->samples);
+    free(profile->sites);
+    free(profile->site_index);
+    free(profile);
+}
+
+/**
+ * @brief Frees everything allocated from a Memchunk at once.
  * 
- * This function allocates memory for the Memchunk structure and initializes
- * the memory pool. Initially, all memory in the Memchunk is free.
+ * For an arena this only rewinds its top pointer, which is O(1). Any other
+ * Memchunk is turned back into a single free block. Named blocks are dropped
+ * from the name index in both cases. Every Memchunk of a growth chain is
+ * reset, and they all stay available for reuse.
  * 
- * @param name The name of the Memchunk to initialize.
- * @param total_size The total size of the memory Memchunk.
+ * WARNING: Every pointer previously returned by the Memchunk becomes invalid,
+ * and no other thread may use the Memchunk during the call. A thread that
+ * exits meanwhile is fine: its cache is flushed before the reset or, once
+ * the new id is in place, dropped.
  * 
- * @return A pointer to the initialized Memchunk structure, or NULL if memory 
- *         allocation fails.
+ * @param Memchunk The Memchunk to reset.
  * 
  * Example usage:
  * ```
- * Memchunk* chunk = memc_init("Chunk1", 1024);
- * if (chunk) {
- *     // Use the chunk
- * }
+ * memc_reset(frame);  // Start the next frame with an empty arena
  * ```
  */
-Memchunk* memc_init(const char* name, size_t total_size) {
-    Memchunk* new_Memchunk = (Memchunk*)malloc(sizeof(Memchunk));
-    if (new_Memchunk == NULL) return NULL;
+void memc_reset(Memchunk* Memchunk) {
+    if (Memchunk) profile_clear_live(Memchunk->profile);
+    for (; Memchunk; Memchunk = chain_next(Memchunk)) {
+        chunk_lock(Memchunk);
+        chunk_format(Memchunk);
+        if (Memchunk->flags & MEMC_SHARED) shared_header(Memchunk)->poisoned = 0;  // Nothing of the torn state is left
+        if (Memchunk->name_count) {
+            memset(Memchunk->name_index, 0, Memchunk->name_capacity * sizeof(Memname));
+            Memchunk->name_count = 0;
+        }
+        for (size_t tag = 0; tag < Memchunk->tag_count; tag++) {
+            Memchunk->tags[tag].live_bytes = 0;
+            Memchunk->tags[tag].live_blocks = 0;
+        }
 
-    // Ensure the Memchunk name is properly set and null-terminated
-    strncpy(new_Memchunk->name, name, sizeof(new_Memchunk->name));
-    new_Memchunk->name[sizeof(new_Memchunk->name) - 1] = '\0';  // Null-terminate the name string
+        // A new id makes every thread drop the cached blocks of the old contents
+        while (Memchunk->tcaches) tcache_fold(Memchunk->tcaches);
+        Memchunk->id = __atomic_fetch_add(&next_memchunk_id, 1, __ATOMIC_RELAXED);
+        chunk_unlock(Memchunk);
+    }
+}
 
-    new_Memchunk->total_size = total_size;
-    new_Memchunk->used_memory = 0;  // Initially no memory is used
-    new_Memchunk->free_memory = total_size;  // All memory is free at the start
+/**
+ * @brief Returns the free memory of a Memchunk to the OS.
+ * 
+ * Every free block has the whole pages inside it released with
+ * `madvise(MADV_DONTNEED)`; for an arena, the pages above its top are. The
+ * address range stays valid, and the pages read back as zero when they are
+ * allocated again. Blocks that are already purged are skipped. The bytes
+ * purged are added to the Memchunk's `purged_memory`. Blocks held in thread
+ * caches stay resident; call `memc_flush` first to include them.
+ * 
+ * @param Memchunk The Memchunk to trim, along with its growth chain.
+ * 
+ * @return The number of bytes returned to the OS.
+ * 
+ * Example usage:
+ * ```
+ * size_t released = memc_trim(chunk);
+ * ```
+ */
+size_t memc_trim(Memchunk* Memchunk) {
+    size_t purged = 0;
+    for (; Memchunk; Memchunk = chain_next(Memchunk)) {
+        if (chunk_lock(Memchunk) == 0) purged += chunk_purge(Memchunk, SIZE_MAX >> CEIT_FREE_STAMP_SHIFT);
+        chunk_unlock(Memchunk);
+    }
+    return purged;
+}
 
-    new_Memchunk->memory_pool = (Memory*)malloc(total_size + sizeof(Memory));
-    if (new_Memchunk->memory_pool == NULL) return NULL;
+/**
+ * @brief Zeroes the first `size` data bytes of a block just taken from a free
+ * block whose state was `state`.
+ *
+ * Data of a CEIT_FREE_ZERO block is dirty only where free-list links and
+ * footers were. Whole pages inside a purged block are zero too. Everything
+ * else is cleared with memset, which the C library vectorizes.
+ */
+static void block_zero(Memchunk* Memchunk, Memory* block, size_t size, size_t state) {
+    char* data = (char*)(block + 1);
+    if (state & CEIT_FREE_ZERO) {
+        memset(data, 0, sizeof(FreeLinks));
+        memset(data + block_size(block) - sizeof(size_t), 0, sizeof(size_t));
+        return;
+    }
 
-    new_Memchunk->memory_pool->size = total_size;
-    new_Memchunk->memory_pool->is_free = 1;  // Initially, the memory is free
-    new_Memchunk->memory_pool->next = NULL;
-    new_Memchunk->next = NULL;
+    if (state & CEIT_FREE_PURGED) {
+        char* from = (char*)CEIT_ROUND_UP((uintptr_t)data + sizeof(FreeLinks), Memchunk->commit_unit);
+        char* to = (char*)(((uintptr_t)data + block_size(block) - sizeof(size_t)) & ~(uintptr_t)(Memchunk->commit_unit - 1));
+        if (from < to) {
+            memset(data, 0, (size_t)((from < data + size ? from : data + size) - data));
+            if (to < data + size) memset(to, 0, (size_t)(data + size - to));
+            return;
+        }
+    }
+    memset(data, 0, size);
+}
 
-    return new_Memchunk;
+/**
+ * @brief Returns the upper bound, in ticks, of a latency histogram bucket.
+ */
+static unsigned long long latency_bucket_max(size_t bucket) {
+    const size_t sub = (size_t)1 << CEIT_LATENCY_SUB_LOG;
+    if (bucket < sub) return bucket;
+    int shift = (int)(bucket >> CEIT_LATENCY_SUB_LOG) - 1;
+    return ((unsigned long long)(sub + (bucket & (sub - 1))) << shift) + ((1ULL << shift) - 1);
+}
+
+#ifdef CEIT_LATENCY
+/**
+ * @brief Reads the CPU's cycle counter, or a nanosecond clock where there is none.
+ */
+static unsigned long long cycle_count(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    unsigned long long ticks;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long)now.tv_sec * 1000000000ULL + (unsigned long long)now.tv_nsec;
+#endif
+}
+
+/**
+ * @brief Returns the bucket of a latency histogram that holds `ticks`:
+ * the value itself below 16, then 16 linear buckets per power of two.
+ */
+static size_t latency_bucket(unsigned long long ticks) {
+    const size_t sub = (size_t)1 << CEIT_LATENCY_SUB_LOG;
+    if (ticks < sub) return (size_t)ticks;
+    int top = 63 - __builtin_clzll(ticks);
+    if (top > 47) return CEIT_LATENCY_BUCKETS - 1;
+    return ((size_t)(top - CEIT_LATENCY_SUB_LOG + 1) << CEIT_LATENCY_SUB_LOG) + (size_t)((ticks >> (top - CEIT_LATENCY_SUB_LOG)) & (sub - 1));
+}
+
+/**
+ * @brief Records the latency of an operation that started at `start`.
+ *
+ * The histograms are created on first use. Threads update them with
+ * relaxed atomics, so recording takes no lock.
+ */
+static void latency_record(Memchunk* Memchunk, unsigned op, unsigned long long start) {
+    unsigned long long ticks = cycle_count() - start;
+    if (!Memchunk) return;
+
+    Memlatency* latency = __atomic_load_n(&Memchunk->latency, __ATOMIC_ACQUIRE);
+    if (!latency) {
+        Memlatency* fresh = (Memlatency*)calloc(1, sizeof(Memlatency));
+        if (!fresh) return;
+        if (__atomic_compare_exchange_n(&Memchunk->latency, &latency, fresh, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) latency = fresh;
+        else free(fresh);  // Another thread created them first
+    }
+    __atomic_fetch_add(&latency->counts[op][latency_bucket(ticks)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&latency->total[op], 1, __ATOMIC_RELAXED);
+    unsigned long long max = __atomic_load_n(&latency->max[op], __ATOMIC_RELAXED);
+    while (ticks > max && !__atomic_compare_exchange_n(&latency->max[op], &max, ticks, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+/** Starts timing a public operation; compiled out without CEIT_LATENCY. */
+#define CEIT_LATENCY_START() unsigned long long latency_start = cycle_count()
+/** Records the operation timed since CEIT_LATENCY_START in the Memchunk's histograms. */
+#define CEIT_LATENCY_RECORD(Memchunk, op) latency_record(Memchunk, op, latency_start)
+#else
+#define CEIT_LATENCY_START() ((void)0)
+#define CEIT_LATENCY_RECORD(Memchunk, op) ((void)0)
+#endif
+
+/**
+ * @brief Counts an allocation of `size` bytes served by `reserved` bytes.
+ */
+static void stats_alloc(Memchunk* Memchunk, size_t size, size_t reserved) {
+    Memchunk->stats.alloc_count++;
+    Memchunk->stats.live_blocks++;
+    Memchunk->stats.requested_bytes += size;
+    Memchunk->stats.reserved_bytes += reserved;
+}
+
+/**
+ * @brief Returns the map of named arena allocations, which follows the map of starts.
+ */
+static unsigned long long* arena_named_map(const Memchunk* Memchunk) {
+    return Memchunk->arena_starts + (Memchunk->reserve_size / CEIT_ALIGN + 63) / 64;
+}
+
+/**
+ * @brief Records an arena allocation at offset `start` that moves the top to
+ * `end`; the caller holds the lock.
+ *
+ * The bits between the old and the new top may be left over from before a
+ * reset, so they are cleared as the top passes them. Bits below the top are
+ * thus always current, and memc_reset stays O(1).
+ */
+static void arena_mark(Memchunk* Memchunk, size_t start, size_t end, int named) {
+    unsigned long long* named_map = arena_named_map(Memchunk);
+    size_t unit = Memchunk->arena_top / CEIT_ALIGN, last = end / CEIT_ALIGN;
+    while (unit < last) {
+        if (unit % 64 == 0 && last - unit >= 64) {
+            Memchunk->arena_starts[unit / 64] = named_map[unit / 64] = 0;  // A whole word at once
+            unit += 64;
+        } else {
+            Memchunk->arena_starts[unit / 64] &= ~(1ULL << (unit % 64));
+            named_map[unit / 64] &= ~(1ULL << (unit % 64));
+            unit++;
+        }
+    }
+    Memchunk->arena_starts[start / CEIT_ALIGN / 64] |= 1ULL << (start / CEIT_ALIGN % 64);
+    if (named) named_map[start / CEIT_ALIGN / 64] |= 1ULL << (start / CEIT_ALIGN % 64);
+}
+
+/**
+ * @brief Returns where the arena allocation at offset `start` ends: at the
+ * next allocation's start, or at the top for the last one.
+ *
+ * The scan covers the allocation's own bits only, so it costs about as
+ * much as reading the allocation would.
+ */
+static size_t arena_block_end(const Memchunk* Memchunk, size_t start) {
+    size_t unit = start / CEIT_ALIGN + 1, top = Memchunk->arena_top / CEIT_ALIGN;
+    while (unit < top) {
+        unsigned long long bits = Memchunk->arena_starts[unit / 64] >> (unit % 64);
+        if (bits) {
+            unit += (size_t)__builtin_ctzll(bits);
+            return unit < top ? unit * CEIT_ALIGN : Memchunk->arena_top;
+        }
+        unit = (unit / 64 + 1) * 64;
+    }
+    return Memchunk->arena_top;
+}
+
+/**
+ * @brief Bumps an arena's top pointer; the caller holds the lock and checked the name.
+ *
+ * Arena allocations have no header. A named one is indexed under the address
+ * a header would have, so memory_find works the same as for other Memchunks.
+ */
+static void* arena_alloc(Memchunk* Memchunk, size_t size, size_t align, const char* block_name, int zero) {
+    char* base = (char*)(Memchunk->memory_pool + 1);
+    size_t start = CEIT_ROUND_UP((uintptr_t)base + Memchunk->arena_top, align) - (uintptr_t)base;
+    if (start > Memchunk->total_size || size > Memchunk->total_size - start) {
+        if (!(Memchunk->flags & MEMC_MMAP) || start + size > Memchunk->reserve_size) return NULL;
+        if (chunk_commit(Memchunk, start + size - Memchunk->total_size) != 0) return NULL;
+    }
+
+    // Pages from arena_clean on are still zero
+    if (zero && start < Memchunk->arena_clean) memset(base + start, 0, (start + size < Memchunk->arena_clean ? start + size : Memchunk->arena_clean) - start);
+
+    int named = block_name && block_name[0];
+    arena_mark(Memchunk, start, start + size, named);
+    stats_alloc(Memchunk, size, start + size - Memchunk->arena_top);  // Alignment padding counts as reserved
+    Memchunk->used_memory += start + size - Memchunk->arena_top;
+    Memchunk->free_memory = Memchunk->total_size - (start + size);
+    Memchunk->arena_top = start + size;
+    if (Memchunk->arena_clean < Memchunk->arena_top) Memchunk->arena_clean = Memchunk->arena_top;
+
+    if (named) {
+        unsigned tag = tag_intern(Memchunk, block_name);
+        nameindex_place(Memchunk->name_index, Memchunk->name_text, Memchunk->name_capacity, name_hash(block_name), (Memory*)(base + start) - 1, block_name, tag);
+        Memchunk->name_count++;
+        Memchunk->tags[tag].live_bytes += size;
+        Memchunk->tags[tag].live_blocks++;
+        Memchunk->tags[tag].alloc_count++;
+    }
+    return base + start;
+}
+
+/**
+ * @brief Takes a block of a MEMC_BUDDY Memchunk; the caller holds the lock and
+ * checked the name.
+ *
+ * The smallest non-empty order that fits is found with one bitmap scan, and
+ * its first block is halved down to the order the request needs.
+ */
+static void* buddy_alloc(Memchunk* Memchunk, size_t size, size_t align, const char* block_name, int zero) {
+    size_t needed = size > align ? size : align;  // A block is aligned to its size, up to a page
+    if (align > page_size() || needed > Memchunk->total_size) return NULL;
+    unsigned order = Memchunk->buddy_min_order;
+    while (((size_t)1 << order) < needed) order++;
+
+    unsigned long long orders = Memchunk->free_map & (~0ULL << order);
+    if (!orders) return NULL;
+    unsigned found = (unsigned)__builtin_ctzll(orders);
+    size_t offset = Memchunk->free_lists[found];
+    buddy_unlink(Memchunk, offset, found);
+    while (found > order) {
+        found--;
+        buddy_push(Memchunk, offset + ((size_t)1 << found), found);  // The upper half stays free
+    }
+
+    size_t slot = offset >> Memchunk->buddy_min_order;
+    Memchunk->buddy_orders[slot] = (unsigned char)order;
+    Memchunk->buddy_requests[slot] = (unsigned)(size / CEIT_ALIGN);
+    Memchunk->used_memory += (size_t)1 << order;
+    Memchunk->free_memory -= (size_t)1 << order;
+    Memchunk->requested_memory += size;
+    stats_alloc(Memchunk, size, (size_t)1 << order);
+
+    char* data = (char*)(Memchunk->memory_pool + 1) + offset;
+    if (zero) memset(data, 0, size);
+    if (block_name && block_name[0]) block_name_set(Memchunk, (Memory*)data - 1, block_name);
+    return data;
+}
+
+/**
+ * @brief Allocates a block of an already rounded size; the caller holds the lock.
+ */
+static void* chunk_alloc(Memchunk* Memchunk, size_t size, size_t align, const char* block_name, int zero) {
+    int named = block_name && block_name[0];
+    if (named && (nameindex_lookup(Memchunk, block_name) >= 0 || nameindex_reserve(Memchunk) != 0)) {
+        return NULL;  // Duplicate name, or no room to index it
+    }
+    if (Memchunk->flags & MEMC_ARENA) return arena_alloc(Memchunk, size, align, block_name, zero);
+    if (Memchunk->flags & MEMC_BUDDY) return buddy_alloc(Memchunk, size, align, block_name, zero);
+
+    // Every CEIT_DECAY_POLL allocations that reach the lock read the clock for decay
+    if (Memchunk->decay_ms && ++Memchunk->decay_polls >= CEIT_DECAY_POLL) decay_poll(Memchunk);
+
+    // Over-aligned requests need room for the worst-case padding block in front
+    size_t search = size;
+    if (align > CEIT_ALIGN) {
+        search = size + align + sizeof(Memory) + CEIT_MIN_PAYLOAD;
+        if (search > Memchunk->reserve_size) return NULL;
+    }
+
+    Memory* best_fit = freelist_find(Memchunk, search);
+    if (!best_fit && (Memchunk->flags & MEMC_MMAP) && chunk_commit(Memchunk, search + sizeof(Memory)) == 0) {
+        best_fit = freelist_find(Memchunk, search);  // The committed pages now end in a large enough free block
+    }
+    if (!best_fit) return NULL;  // No suitable memory block found
+    freelist_remove(Memchunk, best_fit);
+    size_t state = best_fit->name_hash;
+
+    // Split off the padding in front of the aligned position as a free block
+    uintptr_t data = (uintptr_t)(best_fit + 1);
+    uintptr_t aligned = CEIT_ROUND_UP(data, align);
+    if (aligned != data) {
+        while (aligned - data < sizeof(Memory) + CEIT_MIN_PAYLOAD) aligned += align;
+        Memory* aligned_block = (Memory*)aligned - 1;
+        aligned_block->size = block_size(best_fit) - (aligned - data);
+        aligned_block->name_hash = best_fit->name_hash;  // Both parts keep the block's purge state
+        block_set_size(best_fit, aligned - data - sizeof(Memory));
+        mark_free(Memchunk, best_fit);
+        freelist_insert(Memchunk, best_fit);
+        best_fit = aligned_block;
+    }
+
+    // Split the memory block if the remaining space can hold another block
+    if (block_size(best_fit) >= size + sizeof(Memory) + CEIT_MIN_PAYLOAD) {
+        Memory* new_block = (Memory*)((char*)(best_fit + 1) + size);
+        new_block->size = block_size(best_fit) - size - sizeof(Memory);
+        new_block->name_hash = best_fit->name_hash;
+        block_set_size(best_fit, size);
+        mark_free(Memchunk, new_block);
+        freelist_insert(Memchunk, new_block);
+    }
+
+    mark_used(Memchunk, best_fit);  // Mark the block as used
+    if (zero) block_zero(Memchunk, best_fit, size, state);
+    if (named) block_name_set(Memchunk, best_fit, block_name);
+
+    // Update Memchunk's used and free memory with the block's real size, which
+    // may exceed the request when the remainder was too small to split off
+    Memchunk->used_memory += block_size(best_fit);
+    Memchunk->free_memory -= block_size(best_fit);
+    stats_alloc(Memchunk, size, block_size(best_fit));
+
+    return (void*)(best_fit + 1);  // Return the memory block's data pointer
 }
 
 /**
  * @brief Allocates memory from the Memchunk's memory pool.
  * 
- * This function searches for the best-fit memory block in the pool that is large
- * enough to satisfy the request and allocates it. If the block is larger than 
- * necessary, it is split. The allocated memory block is marked as used, and 
- * the Memchunk's used/free memory statistics are updated.
+ * This function looks up a free block large enough to satisfy the request in
+ * the Memchunk's size-class free lists and allocates it. Only free blocks are
+ * visited, so the lookup does not depend on the number of allocated blocks.
+ * If the block is larger than necessary, it is split. The allocated memory
+ * block is marked as used, and the Memchunk's used/free memory statistics
+ * are updated. The returned pointer is aligned to CEIT_ALIGN, which satisfies
+ * `max_align_t`.
  * 
  * @param Memchunk The Memchunk from which memory is allocated.
  * @param size The size of the memory block to allocate.
- * @param block_name The name of the allocated memory block.
+ * @param block_name The name of the allocated memory block, or NULL for an
+ *                   anonymous block that can only be freed by pointer. Names
+ *                   are unique within a Memchunk; only the first 31 characters
+ *                   are kept.
  * 
- * @return A pointer to the allocated memory block, or NULL if allocation fails.
+ * @return A pointer to the allocated memory block, or NULL if allocation fails
+ *         or a live block in the Memchunk already has the same name.
  * 
  * Example usage:
  * ```
@@ -73,38 +2982,367 @@ Memchunk* memc_init(const char* name, size_t total_size) {
  * ```
  */
 void* memory_alloc(Memchunk* Memchunk, size_t size, const char* block_name) {
-    if (!Memchunk || size == 0) return NULL;
+    CEIT_LATENCY_START();
+    void* ptr = memory_alloc_aligned(Memchunk, size, CEIT_ALIGN, block_name);
+    CEIT_LATENCY_RECORD(Memchunk, MEMC_OP_ALLOC);
+    return ptr;
+}
+
+/**
+ * @brief Allocates a rounded request from a single Memchunk, taking its lock
+ * or using the thread's cache as the Memchunk's flags require.
+ */
+static void* chunk_alloc_one(Memchunk* Memchunk, size_t size, size_t align, const char* block_name, int zero) {
+    if (size > Memchunk->reserve_size) return NULL;
+
+    int named = block_name && block_name[0];
+    if (!(Memchunk->flags & MEMC_THREAD_SAFE)) return chunk_alloc(Memchunk, size, align, block_name, zero);
+
+    // Anonymous small blocks come from the thread's cache, refilled in batches
+    Tcache* cache = !named && !(Memchunk->flags & (MEMC_ARENA | MEMC_BUDDY | MEMC_SHARED)) && align == CEIT_ALIGN && size <= CEIT_TCACHE_MAX ? tcache_get(Memchunk) : NULL;
+    if (cache) {
+        unsigned* count = &cache->count[size / CEIT_ALIGN];
+        if (*count) {
+            void* ptr = cache->blocks[size / CEIT_ALIGN][--*count];
+            tcache_hold(block_of(ptr), 0);
+            tcache_count(&cache->allocs, 1);
+            tcache_count(&cache->alloc_bytes, size);
+            return zero ? memset(ptr, 0, size) : ptr;  // Cached blocks were in use, so they are dirty
+        }
 
-    Memory* current = Memchunk->memory_pool, *best_fit = NULL;
-    size_t best_fit_size = (size_t)-1;
-    while (current) {
-        if (current->is_free && current->size >= size && current->size < best_fit_size) {
-            best_fit = current;
-            best_fit_size = current->size;
+        pthread_mutex_lock(&Memchunk->lock);
+        void* ptr = chunk_alloc(Memchunk, size, align, NULL, zero);
+        while (ptr && *count < CEIT_TCACHE_BATCH - 1) {
+            void* extra = chunk_alloc(Memchunk, size, align, NULL, 0);
+            if (!extra || block_size(block_of(extra)) != size) {
+                if (extra) {
+                    // Given back at once: neither an allocation nor a free of the program's
+                    Memchunk->stats.requested_bytes -= size;
+                    Memchunk->stats.reserved_bytes -= block_size(block_of(extra));
+                    release_block(Memchunk, block_of(extra));
+                    Memchunk->stats.alloc_count--;
+                    Memchunk->stats.free_count--;
+                }
+                break;
+            }
+            tcache_hold(block_of(extra), 1);
+            tcache_count(&cache->allocs, (size_t)-1);  // Not an allocation of the program's
+            tcache_count(&cache->alloc_bytes, 0 - size);
+            cache->blocks[size / CEIT_ALIGN][(*count)++] = extra;
         }
-        current = current->next;
+        pthread_mutex_unlock(&Memchunk->lock);
+        return ptr;
     }
 
-    if (!best_fit) return NULL;  // No suitable memory block found
+    void* ptr = chunk_lock(Memchunk) == 0 ? chunk_alloc(Memchunk, size, align, block_name, zero) : NULL;  // A poisoned Memchunk allocates nothing
+    chunk_unlock(Memchunk);
+    return ptr;
+}
+
+/**
+ * @brief Appends a Memchunk large enough for the request to a growth chain.
+ *
+ * The caller holds the head's grow_lock and passes the current tail.
+ *
+ * @return The new Memchunk, or NULL if the cap is reached or memory runs out.
+ */
+static Memchunk* chain_grow(Memchunk* head, Memchunk* tail, size_t size, size_t align) {
+    size_t needed = size + (align > CEIT_ALIGN ? align + sizeof(Memory) + CEIT_MIN_PAYLOAD : 0);
+    if (head->flags & MEMC_BUDDY) {
+        // A buddy Memchunk is rounded down to a power of two, which must still hold the block
+        needed = size > align ? size : align;
+        needed = (size_t)1 << (size_class(needed - 1) + 1);
+    }
+    size_t new_size = head->grow_size > needed ? head->grow_size : needed;
+    if (head->grow_limit) {
+        if (head->chain_size >= head->grow_limit || needed > head->grow_limit - head->chain_size) return NULL;
+        if (new_size > head->grow_limit - head->chain_size) new_size = head->grow_limit - head->chain_size;
+    }
+
+    Memchunk* grown = chunk_create(head->name, new_size, head->flags);
+    if (!grown) return NULL;
+    if (grown->flags & MEMC_BUDDY) {
+        if (buddy_setup(grown, head->buddy_min_order) != 0) {
+            chunk_destroy(grown);
+            return NULL;
+        }
+        chunk_format(grown);
+    }
+    grown->decay_ms = head->decay_ms;
+    grown->profile = head->profile;
+
+    double next_size = (double)new_size * head->grow_factor;
+    head->grow_size = next_size < (double)(SIZE_MAX / 2) ? (size_t)next_size : SIZE_MAX / 2;
+    head->chain_size += grown->reserve_size;
+    __atomic_store_n(&tail->next, grown, __ATOMIC_RELEASE);
+    return grown;
+}
+
+/**
+ * @brief Allocates a rounded request from a growth chain, growing it if needed.
+ */
+static void* chain_alloc(Memchunk* head, size_t size, size_t align, const char* block_name, int zero) {
+    int named = block_name && block_name[0];
+    int thread_safe = (head->flags & MEMC_THREAD_SAFE) != 0;
+    void* ptr = NULL;
+
+    // Names are unique across the chain; grow_lock keeps two threads from racing on a new name
+    if (named) {
+        if (thread_safe) pthread_mutex_lock(&head->grow_lock);
+        if (memory_find(head, block_name)) goto done;
+    }
+
+    Memchunk* tail = head;
+    for (Memchunk* current = head; current; current = chain_next(current)) {
+        if ((ptr = chunk_alloc_one(current, size, align, block_name, zero))) goto done;
+        tail = current;
+    }
+
+    if (thread_safe && !named) pthread_mutex_lock(&head->grow_lock);
+    // Another thread may have grown the chain while we were looking
+    for (Memchunk* current = chain_next(tail); current && !ptr; current = chain_next(current)) {
+        ptr = chunk_alloc_one(current, size, align, block_name, zero);
+        tail = current;
+    }
+    if (!ptr) {
+        Memchunk* grown = chain_grow(head, tail, size, align);
+        if (grown) ptr = chunk_alloc_one(grown, size, align, block_name, zero);
+    }
+    if (thread_safe && !named) pthread_mutex_unlock(&head->grow_lock);
+
+done:
+    if (named && thread_safe) pthread_mutex_unlock(&head->grow_lock);
+    return ptr;
+}
+
+/**
+ * @brief Rounds a batch request like a single one, or returns 0 if it is invalid.
+ */
+static size_t batch_size(const Memchunk* Memchunk, size_t size) {
+    if (size == 0 || size > SIZE_MAX / 2) return 0;
+    size = CEIT_ROUND_UP(size, CEIT_ALIGN);
+    return size < CEIT_MIN_PAYLOAD && !(Memchunk->flags & (MEMC_ARENA | MEMC_BUDDY)) ? CEIT_MIN_PAYLOAD : size;
+}
+
+/**
+ * @brief Allocates a batch of anonymous blocks; the caller holds the lock.
+ *
+ * The blocks are carved back to back out of one free block that is large
+ * enough for all of them, so there is a single search and the statistics
+ * are updated once. If no free block is that large, the blocks are
+ * allocated one by one. Either all blocks are allocated or none.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+static int chunk_alloc_batch(Memchunk* Memchunk, size_t n, const size_t* sizes, void** out) {
+    size_t total = 0;
+    for (size_t i = 0; i < n; i++) {
+        size_t size = batch_size(Memchunk, sizes[i]);
+        if (size == 0) return -1;
+        size += i ? sizeof(Memory) : 0;  // Every block after the first needs a header
+        if (size > Memchunk->reserve_size || total > Memchunk->reserve_size - size) return -1;
+        total += size;
+    }
+
+    if (Memchunk->flags & MEMC_ARENA) {
+        size_t top = Memchunk->arena_top, used = Memchunk->used_memory, free_memory = Memchunk->free_memory;
+        Memstats stats = Memchunk->stats;
+        for (size_t i = 0; i < n; i++) {
+            if (!(out[i] = arena_alloc(Memchunk, batch_size(Memchunk, sizes[i]), CEIT_ALIGN, NULL, 0))) {
+                Memchunk->arena_top = top;  // Nothing else changed, so rewinding undoes the batch
+                Memchunk->used_memory = used;
+                Memchunk->free_memory = free_memory;
+                Memchunk->stats = stats;
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    Memory* block = Memchunk->flags & MEMC_BUDDY ? NULL : freelist_find(Memchunk, total);  // Buddy blocks cannot be carved
+    if (!block && (Memchunk->flags & MEMC_MMAP) && chunk_commit(Memchunk, total + sizeof(Memory)) == 0) {
+        block = freelist_find(Memchunk, total);
+    }
+    if (!block) {
+        for (size_t i = 0; i < n; i++) {
+            if ((out[i] = chunk_alloc(Memchunk, batch_size(Memchunk, sizes[i]), CEIT_ALIGN, NULL, 0))) continue;
+            while (i) release_block(Memchunk, block_of(out[--i]));
+            return -1;
+        }
+        return 0;
+    }
+
+    freelist_remove(Memchunk, block);
+    size_t state = block->name_hash, rest = block_size(block), used = 0;
+    block->size &= CEIT_BLOCK_PREV_FREE;  // Keep only the flag that the first block inherits
+    block->name_hash = 0;
+    for (size_t i = 0; i < n; i++) {
+        size_t size = batch_size(Memchunk, sizes[i]);
+        if (i == n - 1 && rest - size < sizeof(Memory) + CEIT_MIN_PAYLOAD) size = rest;  // Too small to split off
+        block->size |= size;
+        out[i] = block + 1;
+        used += size;
+        rest -= size;
 
-    // Split the memory block if the remaining space is large enough
-    if (best_fit->size > size + sizeof(Memory)) {
-        Memory* new_block = (Memory*)((char*)best_fit + sizeof(Memory) + size);
-        new_block->size = best_fit->size - size - sizeof(Memory);
-        new_block->is_free = 1;
-        new_block->next = best_fit->next;
-        best_fit->size = size;
-        best_fit->next = new_block;
+        if (i < n - 1 || rest) {
+            Memory* next = (Memory*)((char*)(block + 1) + size);
+            next->size = 0;
+            next->name_hash = 0;  // The bytes were free-list links or data, which must not pass for a cache mark
+            rest -= sizeof(Memory);
+            block = next;
+        }
+    }
+
+    // Whatever is left behind the last block goes back to the free lists
+    if (block_of(out[n - 1]) != block) {
+        block->size = rest;
+        block->name_hash = state;
+        mark_free(Memchunk, block);
+        freelist_insert(Memchunk, block);
+    } else {
+        mark_used(Memchunk, block);
     }
+    Memchunk->used_memory += used;
+    Memchunk->free_memory -= used;
+    for (size_t i = 0; i < n; i++) stats_alloc(Memchunk, batch_size(Memchunk, sizes[i]), block_size(block_of(out[i])));
+    return 0;
+}
+
+/**
+ * @brief Counts a failed allocation request on the head of a chain.
+ */
+static void stats_failed(Memchunk* Memchunk) {
+    chunk_lock(Memchunk);
+    Memchunk->stats.failed_count++;
+    chunk_unlock(Memchunk);
+}
+
+/**
+ * @brief Checks and rounds a request, then allocates it from the Memchunk or
+ * its growth chain, zeroing it if `zero` is set.
+ */
+static void* alloc_request(Memchunk* Memchunk, size_t size, size_t align, const char* block_name, int zero) {
+    if (!Memchunk || size == 0) return NULL;
+    if (align == 0 || (align & (align - 1)) != 0) return NULL;
+    if (align < CEIT_ALIGN) align = CEIT_ALIGN;
+    if (size > SIZE_MAX / 2) return NULL;
+    if ((Memchunk->flags & MEMC_SHARED) && block_name && block_name[0]) return NULL;  // Names would only exist in this process
+
+    // Round the request so that every header stays aligned and a freed block can hold its links
+    size_t requested = size;
+    size = CEIT_ROUND_UP(size, CEIT_ALIGN);
+    if (size < CEIT_MIN_PAYLOAD && !(Memchunk->flags & (MEMC_ARENA | MEMC_BUDDY))) size = CEIT_MIN_PAYLOAD;
+
+    void* ptr = Memchunk->grow_factor > 0 ? chain_alloc(Memchunk, size, align, block_name, zero) : chunk_alloc_one(Memchunk, size, align, block_name, zero);
+    if (!ptr) stats_failed(Memchunk);
+    else profile_alloc(Memchunk, ptr, requested);
+    return ptr;
+}
+
+/**
+ * @brief Allocates memory whose data pointer is a multiple of `align`.
+ * 
+ * Works like `memory_alloc`, but places the block so that its data starts on
+ * an `align`-byte boundary, e.g. 64 for a cache line or 4096 for a page. The
+ * padding in front of the block is split off and returned to the free lists
+ * as a block of its own, so only the space that alignment really needs is
+ * consumed.
+ * 
+ * @param Memchunk The Memchunk from which memory is allocated.
+ * @param size The size of the memory block to allocate.
+ * @param align The required alignment, a power of two. Values below
+ *              CEIT_ALIGN are raised to it.
+ * @param block_name The name of the allocated memory block, or NULL.
+ * 
+ * @return A pointer to the aligned memory block, or NULL if allocation fails,
+ *         `align` is not a power of two, or the name is already in use.
+ * 
+ * Example usage:
+ * ```
+ * float* samples = memory_alloc_aligned(chunk, 1024 * sizeof(float), 64, "Samples");
+ * ```
+ */
+void* memory_alloc_aligned(Memchunk* Memchunk, size_t size, size_t align, const char* block_name) {
+    return alloc_request(Memchunk, size, align, block_name, 0);
+}
+
+/**
+ * @brief Allocates zero-initialized memory for an array of `count` elements.
+ * 
+ * Works like `memory_alloc`, but the returned data is zero. The Memchunk
+ * knows which free memory is still zero, because it was never handed out
+ * since it was mapped (MEMC_MMAP) or was purged by `memc_trim` or decay. Such
+ * memory is only cleared where the free-list bookkeeping wrote to it, so
+ * untouched pages are not faulted in; other memory is cleared with `memset`.
+ * 
+ * @param Memchunk The Memchunk from which memory is allocated.
+ * @param count The number of elements.
+ * @param size The size of each element.
+ * @param block_name The name of the allocated memory block, or NULL.
+ * 
+ * @return A pointer to the zeroed memory block, or NULL if allocation fails,
+ *         `count * size` overflows or the name is already in use.
+ * 
+ * Example usage:
+ * ```
+ * int* counters = memory_calloc(chunk, 1024, sizeof(int), "Counters");
+ * ```
+ */
+void* memory_calloc(Memchunk* Memchunk, size_t count, size_t size, const char* block_name) {
+    if (size && count > SIZE_MAX / size) return NULL;
+    return alloc_request(Memchunk, count * size, CEIT_ALIGN, block_name, 1);
+}
 
-    best_fit->is_free = 0;  // Mark the block as used
-    strncpy(best_fit->name, block_name, sizeof(best_fit->name));
+/**
+ * @brief Allocates several anonymous blocks with a single search and lock.
+ * 
+ * When one free block is large enough for the whole batch, the blocks are
+ * carved out of it back to back, so they end up contiguous in memory and
+ * the used/free counters are updated once. Otherwise they are allocated one
+ * by one, still under a single lock for a MEMC_THREAD_SAFE Memchunk. Either
+ * all blocks are allocated or none is. The blocks are freed individually
+ * or with `memory_free_batch`.
+ * 
+ * @param Memchunk The Memchunk from which memory is allocated.
+ * @param n The number of blocks.
+ * @param sizes The size of each block; none may be 0.
+ * @param out Receives the data pointer of each block.
+ * 
+ * @return 0 on success, or -1 if the batch could not be allocated, in which
+ *         case nothing was.
+ * 
+ * Example usage:
+ * ```
+ * size_t sizes[3] = {sizeof(Node), sizeof(Node), 256};
+ * void* blocks[3];
+ * if (memory_alloc_batch(chunk, 3, sizes, blocks) == 0) {
+ *     // Use the blocks
+ * }
+ * ```
+ */
+int memory_alloc_batch(Memchunk* Memchunk, size_t n, const size_t* sizes, void** out) {
+    if (!Memchunk || !sizes || !out) return -1;
+    if (n == 0) return 0;
 
-    // Update Memchunk's used and free memory
-    Memchunk->used_memory += size;
-    Memchunk->free_memory -= size;
+    for (struct Memchunk* current = Memchunk; current; current = chain_next(current)) {
+        int status = chunk_lock(current) == 0 ? chunk_alloc_batch(current, n, sizes, out) : -1;
+        chunk_unlock(current);
+        if (status != 0) continue;
+        for (size_t i = 0; i < n; i++) profile_alloc(Memchunk, out[i], sizes[i]);
+        return 0;
+    }
+    if (!(Memchunk->grow_factor > 0)) {
+        stats_failed(Memchunk);
+        return -1;
+    }
 
-    return (void*)((char*)best_fit + sizeof(Memory));  // Return the memory block's data pointer
+    // No Memchunk of the chain can take the whole batch, so let it grow as needed
+    for (size_t i = 0; i < n; i++) {
+        if ((out[i] = memory_alloc(Memchunk, sizes[i], NULL))) continue;
+        memory_free_batch(Memchunk, out, i);
+        return -1;
+    }
+    return 0;
 }
 
 /**
@@ -172,12 +3410,34 @@ int memory_read(const void* mem_block, void* buffer, size_t size) {
     return 0;
 }
 
+/**
+ * @brief Frees the block with the given name: memory_free without the timing.
+ */
+static void chunk_free_name(Memchunk* Memchunk, const char* block_name) {
+    if (!Memchunk || !block_name || block_name[0] == '\0') return;
+    if (Memchunk->flags & MEMC_ARENA) return;  // Arenas are only reclaimed as a whole
+
+    for (; Memchunk; Memchunk = chain_next(Memchunk)) {
+        chunk_lock(Memchunk);
+        long slot = nameindex_lookup(Memchunk, block_name);
+        Memory* block = slot >= 0 ? Memchunk->name_index[slot].block : NULL;
+        if (block) release_block(Memchunk, block);
+        chunk_unlock(Memchunk);
+        if (block) {
+            profile_forget(Memchunk, block + 1);
+            return;
+        }
+    }
+}
+
 /**
  * @brief Frees the memory block with the given name.
  * 
  * This function frees the memory block with the specified name and updates 
  * the Memchunk's used and free memory statistics. If adjacent free memory 
- * blocks exist, they will be coalesced to form a larger free block.
+ * blocks exist, they will be coalesced to form a larger free block. Only the
+ * block's two physical neighbours are inspected, so coalescing is O(1). The
+ * block is found through the Memchunk's name index, also in O(1).
  * 
  * @param Memchunk The Memchunk to free the memory from.
  * @param block_name The name of the memory block to free.
@@ -188,28 +3448,426 @@ int memory_read(const void* mem_block, void* buffer, size_t size) {
  * ```
  */
 void memory_free(Memchunk* Memchunk, const char* block_name) {
-    if (!Memchunk || !block_name) return;
-
-    Memory* current = Memchunk->memory_pool;
-    while (current) {
-        if (!current->is_free && strncmp(current->name, block_name, sizeof(current->name)) == 0) {
-            current->is_free = 1;  // Mark the block as free
-            Memchunk->used_memory -= current->size;
-            Memchunk->free_memory += current->size;
-            break;
+    CEIT_LATENCY_START();
+    chunk_free_name(Memchunk, block_name);
+    CEIT_LATENCY_RECORD(Memchunk, MEMC_OP_FREE);
+}
+
+/**
+ * @brief Looks up a live memory block by name.
+ * 
+ * The lookup goes through the Memchunk's name index and takes O(1) on
+ * average, independent of the number of blocks.
+ * 
+ * @param Memchunk The Memchunk to search.
+ * @param block_name The name given to `memory_alloc`.
+ * 
+ * @return The block's data pointer, or NULL if no live block has that name.
+ * 
+ * Example usage:
+ * ```
+ * char* config = memory_find(chunk, "Config");
+ * ```
+ */
+void* memory_find(Memchunk* Memchunk, const char* block_name) {
+    if (!Memchunk || !block_name || block_name[0] == '\0') return NULL;
+
+    void* ptr = NULL;
+    for (; Memchunk && !ptr; Memchunk = chain_next(Memchunk)) {
+        chunk_lock(Memchunk);
+        long slot = nameindex_lookup(Memchunk, block_name);
+        if (slot >= 0) ptr = (void*)(Memchunk->name_index[slot].block + 1);
+        chunk_unlock(Memchunk);
+    }
+    return ptr;
+}
+
+/**
+ * @brief Frees a block by its data pointer: memory_free_ptr without the timing.
+ */
+static void chunk_free_ptr(Memchunk* Memchunk, void* ptr) {
+    if (!Memchunk || !ptr) return;
+    if (!chunk_owns(Memchunk, ptr) && !(Memchunk = chain_find_owner(chain_next(Memchunk), ptr))) return;
+    if (Memchunk->flags & MEMC_ARENA) return;  // Arenas are only reclaimed as a whole
+    profile_forget(Memchunk, ptr);
+    if (Memchunk->flags & MEMC_BUDDY) {
+        chunk_lock(Memchunk);
+        buddy_release(Memchunk, ptr);  // Ignores double frees itself
+        chunk_unlock(Memchunk);
+        return;
+    }
+
+    Memory* block = block_of(ptr);
+    if (!(Memchunk->flags & MEMC_THREAD_SAFE)) {
+        if (!(block->size & CEIT_BLOCK_FREE)) release_block(Memchunk, block);  // Ignore double frees
+        return;
+    }
+
+    // Anonymous small blocks go to the thread's cache, which is flushed in batches.
+    // Only the PREV_FREE bit of an allocated block can change under another thread.
+    // Double frees are caught before the push: a block in a cache still looks
+    // allocated but carries the cache mark, and a flushed block is free.
+    size_t word = __atomic_load_n(&block->size, __ATOMIC_RELAXED);
+    size_t size = word & ~(size_t)CEIT_BLOCK_FLAGS;
+    if ((word & CEIT_BLOCK_FREE) || tcache_held(block)) return;
+    Tcache* cache = !(word & CEIT_BLOCK_NAMED) && !(Memchunk->flags & MEMC_SHARED) && size <= CEIT_TCACHE_MAX ? tcache_get(Memchunk) : NULL;
+    if (cache) {
+        unsigned* count = &cache->count[size / CEIT_ALIGN];
+        if (*count == CEIT_TCACHE_DEPTH) {
+            pthread_mutex_lock(&Memchunk->lock);
+            while (*count > CEIT_TCACHE_DEPTH - CEIT_TCACHE_BATCH) tcache_release(cache, cache->blocks[size / CEIT_ALIGN][--*count]);
+            pthread_mutex_unlock(&Memchunk->lock);
+        }
+        tcache_hold(block, 1);
+        tcache_count(&cache->frees, 1);
+        cache->blocks[size / CEIT_ALIGN][(*count)++] = ptr;
+        return;
+    }
+
+    if (chunk_lock(Memchunk) == 0 && !(block->size & CEIT_BLOCK_FREE) && !tcache_held(block)) release_block(Memchunk, block);  // Ignore double frees
+    chunk_unlock(Memchunk);
+}
+
+/**
+ * @brief Frees the memory block at the given data pointer.
+ * 
+ * The block header sits at a fixed offset before the pointer returned by
+ * `memory_alloc`, so the block is found and freed in O(1) without looking at
+ * its name. Pointers outside the Memchunk and blocks that are already free
+ * are ignored.
+ * 
+ * @param Memchunk The Memchunk the block was allocated from.
+ * @param ptr The pointer returned by `memory_alloc`.
+ * 
+ * Example usage:
+ * ```
+ * void* p = memory_alloc(chunk, 64, NULL);
+ * memory_free_ptr(chunk, p);
+ * ```
+ */
+void memory_free_ptr(Memchunk* Memchunk, void* ptr) {
+    CEIT_LATENCY_START();
+    chunk_free_ptr(Memchunk, ptr);
+    CEIT_LATENCY_RECORD(Memchunk, MEMC_OP_FREE);
+}
+
+/**
+ * @brief Frees several blocks, taking each Memchunk's lock once.
+ * 
+ * The blocks go straight back to the free lists, bypassing the thread
+ * caches, so a batch allocated with `memory_alloc_batch` coalesces back into
+ * one free block. NULL entries, pointers outside the Memchunk and blocks that
+ * are already free are ignored.
+ * 
+ * @param Memchunk The Memchunk the blocks were allocated from.
+ * @param ptrs The pointers returned by `memory_alloc` or `memory_alloc_batch`.
+ * @param n The number of pointers.
+ * 
+ * Example usage:
+ * ```
+ * memory_free_batch(chunk, blocks, 3);
+ * ```
+ */
+void memory_free_batch(Memchunk* Memchunk, void** ptrs, size_t n) {
+    if (!Memchunk || !ptrs) return;
+
+    struct Memchunk* locked = NULL;
+    int poisoned = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (!ptrs[i]) continue;
+        struct Memchunk* owner = locked && chunk_owns(locked, ptrs[i]) ? locked : chain_find_owner(Memchunk, ptrs[i]);
+        if (!owner || (owner->flags & MEMC_ARENA)) continue;
+        profile_forget(owner, ptrs[i]);
+        if (owner != locked) {
+            if (locked) chunk_unlock(locked);
+            poisoned = chunk_lock(owner) != 0;
+            locked = owner;
+        }
+
+        Memory* block = block_of(ptrs[i]);
+        if (poisoned) continue;
+        if (owner->flags & MEMC_BUDDY) release_block(owner, block);
+        else if (!(block->size & CEIT_BLOCK_FREE) && !((owner->flags & MEMC_THREAD_SAFE) && tcache_held(block))) release_block(owner, block);  // Ignore double frees
+    }
+    if (locked) chunk_unlock(locked);
+}
+
+/**
+ * @brief Resizes an allocated block without moving it; the caller holds the lock.
+ *
+ * A shrinking block gives its tail back as a free block. A growing block
+ * absorbs its free physical successor, which for a MEMC_MMAP Memchunk may
+ * first be made by committing more pages, and splits off what it does not
+ * need.
+ *
+ * @return 1 if the block now has room for `size` bytes, 0 otherwise.
+ */
+static int block_resize(Memchunk* Memchunk, Memory* block, size_t size) {
+    size_t old_size = block_size(block);
+    if (size <= old_size) {
+        if (old_size - size >= sizeof(Memory) + CEIT_MIN_PAYLOAD) {
+            Memory* tail = (Memory*)((char*)(block + 1) + size);
+            tail->size = old_size - size - sizeof(Memory);
+            tail->name_hash = 0;
+            block_set_size(block, size);
+            Memchunk->used_memory -= old_size - size;
+            Memchunk->free_memory += old_size - size;
+            tail = coalesce(Memchunk, tail);
+            if (Memchunk->decay_ms && block_size(tail) >= Memchunk->commit_unit) chunk_decay(Memchunk, tail);
         }
-        current = current->next;
+        return 1;
     }
 
-    // Coalesce adjacent free memory blocks if possible
-    current = Memchunk->memory_pool;
-    while (current) {
-        if (current->is_free && current->next && current->next->is_free) {
-            current->size += sizeof(Memory) + current->next->size;
-            current->next = current->next->next;
+    Memory* next = block_next(Memchunk, block);
+    int next_free = next && (next->size & CEIT_BLOCK_FREE);
+    size_t room = next_free ? old_size + sizeof(Memory) + block_size(next) : old_size;
+    if (room < size && (Memchunk->flags & MEMC_MMAP) && (!next || (next_free && !block_next(Memchunk, next)))) {
+        // At the end of the committed part: commit enough pages to become or extend the successor
+        if (chunk_commit(Memchunk, size - room) == 0) {
+            next = block_next(Memchunk, block);
+            next_free = 1;
+            room = old_size + sizeof(Memory) + block_size(next);
         }
-        current = current->next;
     }
+    if (!next_free || room < size) return 0;
+
+    size_t merged = room;
+    size_t state = next->name_hash;
+    freelist_remove(Memchunk, next);
+    if (merged - size >= sizeof(Memory) + CEIT_MIN_PAYLOAD) {
+        Memory* tail = (Memory*)((char*)(block + 1) + size);
+        tail->size = merged - size - sizeof(Memory);
+        tail->name_hash = state;  // The tail ends where the successor did, so it keeps its purge state
+        block_set_size(block, size);
+        mark_free(Memchunk, tail);
+        freelist_insert(Memchunk, tail);
+    } else {
+        block_set_size(block, merged);
+        mark_used(Memchunk, block);  // Clear PREV_FREE on the block after the absorbed one
+    }
+    Memchunk->used_memory += block_size(block) - old_size;
+    Memchunk->free_memory -= block_size(block) - old_size;
+    return 1;
+}
+
+/**
+ * @brief Resizes a block of a MEMC_BUDDY Memchunk without moving it; the
+ * caller holds the lock.
+ *
+ * A growing block absorbs the upper halves above it while it is the lower
+ * half of each larger order and those halves are free. A shrinking block
+ * frees its upper halves while the lower one still fits.
+ *
+ * @return 1 if the block now has room for `size` bytes, 0 otherwise.
+ */
+static int buddy_resize(Memchunk* Memchunk, void* ptr, size_t size) {
+    size_t offset = (size_t)((char*)ptr - (char*)(Memchunk->memory_pool + 1));
+    size_t slot = offset >> Memchunk->buddy_min_order;
+    unsigned order = Memchunk->buddy_orders[slot] & ~CEIT_BUDDY_NAMED, target = order;
+
+    for (; ((size_t)1 << target) < size; target++) {
+        size_t upper = offset + ((size_t)1 << target);
+        size_t upper_slot = upper >> Memchunk->buddy_min_order;
+        if (target == Memchunk->buddy_max_order || (offset & ((size_t)1 << target)) ||
+            !buddy_is_free(Memchunk, upper_slot) || Memchunk->buddy_orders[upper_slot] != target) {
+            return 0;
+        }
+    }
+    for (unsigned k = order; k < target; k++) {
+        size_t upper = offset + ((size_t)1 << k);
+        buddy_unlink(Memchunk, upper, k);
+        Memchunk->buddy_orders[upper >> Memchunk->buddy_min_order] = 0;
+    }
+    while (target > Memchunk->buddy_min_order && ((size_t)1 << (target - 1)) >= size) {
+        target--;
+        buddy_push(Memchunk, offset + ((size_t)1 << target), target);
+    }
+
+    Memchunk->buddy_orders[slot] = (unsigned char)(target | (Memchunk->buddy_orders[slot] & CEIT_BUDDY_NAMED));
+    Memchunk->used_memory = Memchunk->used_memory - ((size_t)1 << order) + ((size_t)1 << target);
+    Memchunk->free_memory = Memchunk->free_memory + ((size_t)1 << order) - ((size_t)1 << target);
+    Memchunk->requested_memory = Memchunk->requested_memory - (size_t)Memchunk->buddy_requests[slot] * CEIT_ALIGN + size;
+    Memchunk->buddy_requests[slot] = (unsigned)(size / CEIT_ALIGN);
+    return 1;
+}
+
+/**
+ * @brief Resizes an arena allocation without moving it; the caller holds the lock.
+ *
+ * An anonymous allocation shrinks where it is, and the last one also grows
+ * by moving the top, which for a MEMC_MMAP arena may first commit more
+ * pages. A named allocation is never resized, as its tag counts the bytes
+ * it was given.
+ *
+ * @param old_size Receives the bytes the allocation spans.
+ *
+ * @return 1 if the allocation now has room for `size` bytes, 0 otherwise.
+ */
+static int arena_resize(Memchunk* Memchunk, void* ptr, size_t size, size_t* old_size) {
+    size_t start = (size_t)((char*)ptr - (char*)(Memchunk->memory_pool + 1));
+    size_t end = arena_block_end(Memchunk, start);
+    *old_size = end - start;
+    if ((arena_named_map(Memchunk)[start / CEIT_ALIGN / 64] >> (start / CEIT_ALIGN % 64)) & 1) return 0;
+    if (end != Memchunk->arena_top) return size <= *old_size;  // Blocked by the next allocation
+
+    if (size > Memchunk->total_size - start) {
+        if (!(Memchunk->flags & MEMC_MMAP) || size > Memchunk->reserve_size - start) return 0;
+        if (chunk_commit(Memchunk, start + size - Memchunk->total_size) != 0) return 0;
+    }
+    Memchunk->used_memory = Memchunk->used_memory - *old_size + size;
+    Memchunk->arena_top = start + size;
+    Memchunk->free_memory = Memchunk->total_size - Memchunk->arena_top;
+    if (Memchunk->arena_clean < Memchunk->arena_top) Memchunk->arena_clean = Memchunk->arena_top;
+    return 1;
+}
+
+/**
+ * @brief Resizes a block, moving it if needed: memory_realloc without the timing.
+ */
+static void* realloc_request(Memchunk* Memchunk, void* ptr, size_t size) {
+    if (!Memchunk) return NULL;
+    if (!ptr) return alloc_request(Memchunk, size, CEIT_ALIGN, NULL, 0);
+    if (size == 0) {
+        chunk_free_ptr(Memchunk, ptr);
+        return NULL;
+    }
+    if (size > SIZE_MAX / 2) return NULL;
+
+    struct Memchunk* head = Memchunk;
+    if (!chunk_owns(Memchunk, ptr) && !(Memchunk = chain_find_owner(chain_next(Memchunk), ptr))) return NULL;
+
+    Memory* block = block_of(ptr);
+    size_t rounded = CEIT_ROUND_UP(size, CEIT_ALIGN);
+    if (rounded < CEIT_MIN_PAYLOAD && !(Memchunk->flags & (MEMC_ARENA | MEMC_BUDDY))) rounded = CEIT_MIN_PAYLOAD;
+
+    size_t old_size;
+    char name[CEIT_NAME_LEN] = "";
+    if (chunk_lock(Memchunk) != 0) {
+        chunk_unlock(Memchunk);
+        return NULL;  // The block stays as it is
+    }
+    size_t used = Memchunk->used_memory;
+    if (Memchunk->flags & MEMC_ARENA) {
+        if (arena_resize(Memchunk, ptr, rounded, &old_size)) {
+            chunk_unlock(Memchunk);
+            return ptr;
+        }
+    } else if (Memchunk->flags & MEMC_BUDDY ? buddy_resize(Memchunk, ptr, rounded) : block_resize(Memchunk, block, rounded)) {
+        // The block's size changed by as much as the used memory did
+        long slot = Memchunk->used_memory != used ? block_name_slot(Memchunk, block) : -1;
+        if (slot >= 0) Memchunk->tags[Memchunk->name_index[slot].tag].live_bytes += Memchunk->used_memory - used;
+        chunk_unlock(Memchunk);
+        return ptr;
+    } else {
+        old_size = Memchunk->flags & MEMC_BUDDY ? (size_t)1 << (Memchunk->buddy_orders[block_offset(Memchunk, block) >> Memchunk->buddy_min_order] & ~CEIT_BUDDY_NAMED) : block_size(block);
+        strcpy(name, block_name_of(Memchunk, block));
+    }
+    chunk_unlock(Memchunk);
+
+    void* moved = alloc_request(head, size, CEIT_ALIGN, NULL, 0);
+    if (!moved) return NULL;
+    memcpy(moved, ptr, old_size < size ? old_size : size);
+
+    if (name[0]) {
+        // Hand the name over; the old block's index entry goes first, so the name stays unique
+        chunk_lock(Memchunk);
+        block_name_clear(Memchunk, block);
+        chunk_unlock(Memchunk);
+
+        struct Memchunk* owner = chunk_owns(head, moved) ? head : chain_find_owner(chain_next(head), moved);
+        chunk_lock(owner);
+        if (nameindex_reserve(owner) == 0) block_name_set(owner, block_of(moved), name);
+        chunk_unlock(owner);
+    }
+
+    chunk_free_ptr(Memchunk, ptr);
+    return moved;
+}
+
+/**
+ * @brief Changes the size of an allocated block, moving it only if needed.
+ * 
+ * The block is resized in place whenever possible: shrinking splits off its
+ * tail, and growing absorbs a free block right after it. Only when neither
+ * works is a new block allocated, the data copied and the old block freed.
+ * A named block keeps its name when it moves. Growing a buffer step by step
+ * thus mostly happens in place, without copying.
+ * 
+ * A block of a MEMC_BUDDY Memchunk grows in place by absorbing the free
+ * buddies above it, and shrinks by freeing its upper halves. In an arena,
+ * an anonymous block shrinks in place, and the last block also grows in
+ * place by moving the top. Otherwise an arena's block moves, and the arena
+ * keeps the old copy, and its name, until it is reset. A moved block is aligned to CEIT_ALIGN, even if it was
+ * allocated with `memory_alloc_aligned`.
+ * 
+ * @param Memchunk The Memchunk the block was allocated from.
+ * @param ptr The pointer returned by `memory_alloc`, or NULL to allocate a
+ *            new anonymous block.
+ * @param size The new size of the block, or 0 to free it.
+ * 
+ * @return The new data pointer, which may equal `ptr`, or NULL if there is
+ *         not enough memory; in that case the old block is left untouched.
+ * 
+ * Example usage:
+ * ```
+ * char* buffer = memory_alloc(chunk, 64, NULL);
+ * buffer = memory_realloc(chunk, buffer, 4096);
+ * ```
+ */
+void* memory_realloc(Memchunk* Memchunk, void* ptr, size_t size) {
+    CEIT_LATENCY_START();
+    void* moved = realloc_request(Memchunk, ptr, size);
+    CEIT_LATENCY_RECORD(Memchunk, MEMC_OP_REALLOC);
+    return moved;
+}
+
+/**
+ * @brief Returns the calling thread's cached blocks to the Memchunk.
+ * 
+ * In a MEMC_THREAD_SAFE Memchunk, blocks freed by a thread may wait in that
+ * thread's cache and still count as used. This hands them back so that they
+ * can be coalesced and the statistics are exact for this thread. Caches are
+ * also flushed automatically when a thread exits. Does nothing for other
+ * Memchunks.
+ * 
+ * @param Memchunk The Memchunk whose cached blocks to return.
+ * 
+ * Example usage:
+ * ```
+ * memc_flush(shared);
+ * memc_dbg(1, shared);
+ * ```
+ */
+void memc_flush(Memchunk* Memchunk) {
+    if (!Memchunk || !(Memchunk->flags & MEMC_THREAD_SAFE)) return;
+
+    for (; Memchunk; Memchunk = chain_next(Memchunk)) {
+        for (int i = 0; i < CEIT_TCACHE_CHUNKS; i++) {
+            if (thread_tcaches[i] && thread_tcaches[i]->chunk == Memchunk && thread_tcaches[i]->id == Memchunk->id) {
+                tcache_flush(thread_tcaches[i]);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Frees the memory block at the given data pointer without naming its Memchunk.
+ * 
+ * The owning Memchunk is found by address among the registered Memchunks,
+ * and the block is then freed as with `memory_free_ptr`.
+ * 
+ * @param ptr The pointer returned by `memory_alloc`.
+ * 
+ * Example usage:
+ * ```
+ * void* p = memory_alloc(chunk, 64, NULL);
+ * mem_free(p);
+ * ```
+ */
+void mem_free(void* ptr) {
+    if (!ptr) return;
+
+    memory_free_ptr(chunk_find_owner(ptr), ptr);
 }
 
 /**
@@ -233,23 +3891,417 @@ void memc_dealloc(Memchunk* Memchunk) {
     Memchunk->used_memory = 0;
     Memchunk->free_memory = Memchunk->total_size;
 
-    // Free all memory blocks in the Memchunk's memory pool
-    Memory* current_mem = Memchunk->memory_pool;
-    while (current_mem) {
-        Memory* next_mem = current_mem->next;
-        free(current_mem);
-        current_mem = next_mem;
+    // Unlink the Memchunk from the global list
+    pthread_rwlock_wrlock(&global_memchunk_lock);
+    for (struct Memchunk** link = &global_memchunk_list; *link; link = &(*link)->global_next) {
+        if (*link == Memchunk) {
+            *link = Memchunk->global_next;
+            break;
+        }
+    }
+    pthread_rwlock_unlock(&global_memchunk_lock);
+
+    // Free the memory pool and the Memchunk structure itself
+    chunk_destroy(Memchunk);
+}
+
+/**
+ * @brief Returns the size of the largest free block; the caller holds the lock.
+ *
+ * The free lists keep it up to date as blocks come and go, so it is read in
+ * O(1). Only once that block has left the lists is the highest non-empty
+ * size class walked to find the next largest, and a shared Memchunk, whose
+ * lists other processes change, walks it every time. A buddy Memchunk knows
+ * it from its top order, and a best-fit Memchunk finds it at the rightmost
+ * node of its tree.
+ */
+static size_t chunk_largest_free(Memchunk* Memchunk) {
+    if (Memchunk->flags & MEMC_ARENA) return Memchunk->total_size - Memchunk->arena_top;
+    if (Memchunk->flags & MEMC_BEST_FIT) {
+        size_t current = Memchunk->fit_root;
+        if (current == CEIT_NIL) return 0;
+        while (fit_node(Memchunk, current)->right != CEIT_NIL) current = fit_node(Memchunk, current)->right;
+        return block_size(block_at(Memchunk, current));
+    }
+    if (!Memchunk->free_map) return 0;
+
+    int cls = 63 - __builtin_clzll(Memchunk->free_map);
+    if (Memchunk->flags & MEMC_BUDDY) return (size_t)1 << cls;
+    if (!Memchunk->largest_stale && !(Memchunk->flags & MEMC_SHARED)) return Memchunk->largest_free;
+    size_t current = Memchunk->tlsf_lists ? Memchunk->tlsf_lists[cls * CEIT_TLSF_SL + 31 - __builtin_clz(Memchunk->tlsf_maps[cls])] : Memchunk->free_lists[cls];
+    size_t largest = 0;
+    for (; current != CEIT_NIL; current = block_links(block_at(Memchunk, current))->next_free) {
+        if (block_size(block_at(Memchunk, current)) > largest) largest = block_size(block_at(Memchunk, current));
+    }
+    Memchunk->largest_free = largest;
+    Memchunk->largest_stale = 0;
+    return largest;
+}
+
+/**
+ * @brief Reads the statistics of a Memchunk and its growth chain.
+ * 
+ * The counters are kept as blocks are allocated and freed, and so is the
+ * size of the largest free block, so nothing here walks the blocks: each
+ * chain member is locked once and its counters are added up. The top size
+ * class is only walked when the largest free block left the lists since the
+ * last read, or for a shared Memchunk. That makes it cheap enough to poll every second in production, where the
+ * full walk of `memc_dbg` would stall the Memchunk. The header overhead is
+ * 16 bytes per live or free block, and 0 for arenas and buddy Memchunks,
+ * whose blocks have no header. External fragmentation is the part of the
+ * free bytes that cannot serve a request as large as all of them: 0 when
+ * the free memory is one block, close to 1 when it is scattered.
+ * 
+ * Allocations and frees a thread cache served without the lock are counted
+ * too. Blocks waiting in thread caches are not live, but their bytes count
+ * as used until they are flushed, see `memc_flush`. Requested sizes are
+ * counted after rounding up to CEIT_ALIGN.
+ * 
+ * @param Memchunk The Memchunk to read.
+ * @param stats Receives the statistics.
+ * 
+ * @return 0 on success, -1 if an argument is NULL.
+ * 
+ * Example usage:
+ * ```
+ * Memstats stats;
+ * memc_stats(chunk, &stats);
+ * if (stats.fragmentation > 0.5) memc_trim(chunk);
+ * ```
+ */
+int memc_stats(Memchunk* Memchunk, Memstats* stats) {
+    if (!Memchunk || !stats) return -1;
+
+    memset(stats, 0, sizeof(*stats));
+    size_t free_bytes = 0;
+    for (struct Memchunk* member = Memchunk; member; member = chain_next(member)) {
+        if (chunk_lock(member) == 0) decay_poll(member);  // Lets a Memchunk that only reports its statistics decay
+        const Memstats* counters = &member->stats;
+        stats->alloc_count += counters->alloc_count;
+        stats->free_count += counters->free_count;
+        stats->failed_count += counters->failed_count;
+        stats->requested_bytes += counters->requested_bytes;
+        stats->reserved_bytes += counters->reserved_bytes;
+        stats->live_blocks += counters->live_blocks;
+        stats->free_blocks += counters->free_blocks;
+        for (Tcache* cache = member->tcaches; cache; cache = cache->next) {
+            size_t allocs = __atomic_load_n(&cache->allocs, __ATOMIC_RELAXED), frees = __atomic_load_n(&cache->frees, __ATOMIC_RELAXED);
+            size_t bytes = __atomic_load_n(&cache->alloc_bytes, __ATOMIC_RELAXED);
+            stats->alloc_count += allocs;
+            stats->requested_bytes += bytes;
+            stats->reserved_bytes += bytes;
+            stats->free_count += frees;
+            stats->live_blocks += allocs - frees;  // Cached blocks are not live
+        }
+        stats->used_memory += member->used_memory;
+        stats->free_memory += member->free_memory;
+
+        // free_memory also counts the headers after the first, which sit between blocks
+        size_t headers = member->flags & (MEMC_ARENA | MEMC_BUDDY) ? 0 : (counters->live_blocks + counters->free_blocks) * sizeof(Memory);
+        size_t inner = headers > sizeof(Memory) ? headers - sizeof(Memory) : 0;
+        size_t largest = chunk_largest_free(member);
+        stats->header_bytes += headers;
+        free_bytes += member->free_memory > inner + largest ? member->free_memory - inner : largest;
+        if (largest > stats->largest_free) stats->largest_free = largest;
+        chunk_unlock(member);
+    }
+    stats->fragmentation = free_bytes ? 1.0 - (double)stats->largest_free / (double)free_bytes : 0.0;
+    return 0;
+}
+
+/** qsort order of tags by name. */
+static int tag_compare_name(const void* a, const void* b) {
+    return strcmp(((const Memtag*)a)->name, ((const Memtag*)b)->name);
+}
+
+/** qsort order of tags by live bytes, largest first, then by name. */
+static int tag_compare_live(const void* a, const void* b) {
+    const Memtag* x = (const Memtag*)a;
+    const Memtag* y = (const Memtag*)b;
+    if (x->live_bytes != y->live_bytes) return x->live_bytes < y->live_bytes ? 1 : -1;
+    return strcmp(x->name, y->name);
+}
+
+/**
+ * @brief Reports the memory of a Memchunk by tag, largest first.
+ * 
+ * Every name given to `memory_alloc` is interned into a tag: the name
+ * without a trailing number and the separator before it, so "SJOY_1",
+ * "SJOY_2" and "SJOY-3" all count towards "SJOY", while "Config" is its own
+ * tag. Live bytes and blocks are kept per tag as named blocks are allocated,
+ * resized and freed, at O(1) cost, so the report does not walk the blocks
+ * and can run in production. Anonymous blocks are not tagged; the
+ * difference to `memc_stats` is what they use. The tags of a growth chain
+ * are merged, and `memc_reset` sets their live counts back to zero.
+ * 
+ * @param Memchunk The Memchunk to read.
+ * @param tags Receives up to `max` tags, by live bytes in decreasing order.
+ * @param max The number of entries in `tags`.
+ * 
+ * @return The number of entries written, which is less than `max` when
+ *         the Memchunk has fewer tags.
+ * 
+ * Example usage:
+ * ```
+ * Memtag top[10];
+ * size_t n = memc_tag_stats(chunk, top, 10);
+ * for (size_t i = 0; i < n; i++) {
+ *     printf("%-16s %zu bytes in %zu blocks\n", top[i].name, top[i].live_bytes, top[i].live_blocks);
+ * }
+ * ```
+ */
+size_t memc_tag_stats(Memchunk* Memchunk, Memtag* tags, size_t max) {
+    if (!Memchunk || !tags || max == 0) return 0;
+
+    Memtag* all = NULL;
+    size_t count = 0, members = 0;
+    for (struct Memchunk* member = Memchunk; member; member = chain_next(member), members++) {
+        chunk_lock(member);
+        Memtag* grown = member->tag_count ? (Memtag*)realloc(all, (count + member->tag_count) * sizeof(Memtag)) : all;
+        if (grown) {
+            all = grown;
+            memcpy(all + count, member->tags, member->tag_count * sizeof(Memtag));
+            count += member->tag_count;
+        }
+        chunk_unlock(member);
+    }
+
+    // Members of a chain intern tags on their own, so the same tag can appear once per member
+    if (members > 1 && count > 1) {
+        qsort(all, count, sizeof(Memtag), tag_compare_name);
+        size_t merged = 0;
+        for (size_t i = 1; i < count; i++) {
+            if (strcmp(all[merged].name, all[i].name) != 0) {
+                all[++merged] = all[i];
+                continue;
+            }
+            all[merged].live_bytes += all[i].live_bytes;
+            all[merged].live_blocks += all[i].live_blocks;
+            all[merged].alloc_count += all[i].alloc_count;
+        }
+        count = merged + 1;
+    }
+
+    if (count > 1) qsort(all, count, sizeof(Memtag), tag_compare_live);
+    if (count > max) count = max;
+    if (count) memcpy(tags, all, count * sizeof(Memtag));
+    free(all);
+    return count;
+}
+
+/**
+ * @brief Reads, and optionally resets, the latency histograms of a Memchunk.
+ * 
+ * When the library is built with `-DCEIT_LATENCY`, every `memory_alloc`,
+ * `memory_free`, `memory_free_ptr` and `memory_realloc` reads the CPU's
+ * cycle counter (`rdtsc`, or `cntvct_el0` on ARM64) before and after the
+ * call and counts the difference in a log-linear histogram of the Memchunk
+ * it was given. The histograms show the tail of the latency distribution,
+ * e.g. a free that had to coalesce or an allocation that committed pages,
+ * which averages hide. Recording uses relaxed atomics and takes no lock.
+ * Without the define, the timing code is not compiled at all.
+ * 
+ * Reading does not stop other threads: a snapshot taken while they work
+ * may miss or include their latest calls. With `reset`, each counter is
+ * cleared as it is read, so no call is counted twice or lost between two
+ * snapshots.
+ * 
+ * @param Memchunk The Memchunk to read.
+ * @param snapshot Receives the histograms.
+ * @param reset Non-zero to clear the histograms as they are read.
+ * 
+ * @return 0 on success, -1 if an argument is NULL or the library was built
+ *         without CEIT_LATENCY.
+ * 
+ * Example usage:
+ * ```
+ * Memlatency latency;
+ * if (memc_latency(chunk, &latency, 1) == 0) {
+ *     printf("alloc p99.9: %llu ticks\n", memlatency_percentile(&latency, MEMC_OP_ALLOC, 99.9));
+ * }
+ * ```
+ */
+int memc_latency(Memchunk* Memchunk, Memlatency* snapshot, int reset) {
+    if (!Memchunk || !snapshot) return -1;
+#ifdef CEIT_LATENCY
+    memset(snapshot, 0, sizeof(*snapshot));
+    Memlatency* latency = __atomic_load_n(&Memchunk->latency, __ATOMIC_ACQUIRE);
+    if (!latency) return 0;  // Nothing recorded yet
+
+    // Every field is an unsigned long long counter
+    unsigned long long* from = (unsigned long long*)latency;
+    unsigned long long* to = (unsigned long long*)snapshot;
+    for (size_t i = 0; i < sizeof(Memlatency) / sizeof(unsigned long long); i++) {
+        to[i] = reset ? __atomic_exchange_n(&from[i], 0, __ATOMIC_RELAXED) : __atomic_load_n(&from[i], __ATOMIC_RELAXED);
+    }
+    return 0;
+#else
+    (void)reset;
+    return -1;
+#endif
+}
+
+/**
+ * @brief Returns the latency below which a percentile of an operation's
+ * calls completed.
+ * 
+ * The result is the upper bound of the histogram bucket that holds the
+ * percentile, so it overstates the true value by less than 1/16, and never
+ * exceeds the slowest call recorded.
+ * 
+ * @param latency Histograms from `memc_latency`.
+ * @param op MEMC_OP_ALLOC, MEMC_OP_FREE or MEMC_OP_REALLOC.
+ * @param percentile The percentile, from 0 to 100, e.g. 99.9.
+ * 
+ * @return The latency in ticks, or 0 if no call was recorded.
+ * 
+ * Example usage:
+ * ```
+ * unsigned long long p50 = memlatency_percentile(&latency, MEMC_OP_FREE, 50);
+ * unsigned long long p999 = memlatency_percentile(&latency, MEMC_OP_FREE, 99.9);
+ * ```
+ */
+unsigned long long memlatency_percentile(const Memlatency* latency, unsigned op, double percentile) {
+    if (!latency || op >= CEIT_LATENCY_OPS) return 0;
+
+    unsigned long long total = 0;
+    for (size_t i = 0; i < CEIT_LATENCY_BUCKETS; i++) total += latency->counts[op][i];
+    if (total == 0) return 0;
+
+    // The rank of the percentile call, counting from 1
+    double exact = (percentile < 0 ? 0 : percentile > 100 ? 100 : percentile) / 100.0 * (double)total;
+    unsigned long long rank = (unsigned long long)exact;
+    if ((double)rank < exact || rank == 0) rank++;
+
+    unsigned long long seen = 0;
+    for (size_t i = 0; i < CEIT_LATENCY_BUCKETS; i++) {
+        seen += latency->counts[op][i];
+        if (seen < rank) continue;
+        unsigned long long bound = latency_bucket_max(i);
+        return latency->max[op] && latency->max[op] < bound ? latency->max[op] : bound;
+    }
+    return latency->max[op];
+}
+
+/**
+ * @brief Starts, retunes or stops the sampling heap profiler of a Memchunk.
+ * 
+ * While it runs, each thread counts the bytes it requests and samples one
+ * allocation whenever a randomly drawn number of bytes, `sample_bytes` on
+ * average, has gone by. A sample records the stack trace of the call with
+ * `backtrace()`, and stays live until its block is freed or the Memchunk is
+ * reset. Allocations between samples only subtract their size from a
+ * thread-local countdown, and frees only check a small counting filter. A
+ * stack trace costs about a microsecond, and at the default rate of
+ * CEIT_PROFILE_RATE one is taken per 512 KiB allocated, less than the time
+ * it takes to write that memory. A larger block is more likely to be
+ * sampled, which `memc_profile_dump` accounts for.
+ * 
+ * The profile covers the whole growth chain. Stopping with 0 keeps what was
+ * recorded; samples still live are forgotten when their blocks are freed.
+ * Call this before other threads use the Memchunk. Shared Memchunks cannot
+ * be profiled, since the samples would only describe one process.
+ * 
+ * @param Memchunk The Memchunk to profile.
+ * @param sample_bytes Mean number of bytes between two samples, e.g.
+ *                     CEIT_PROFILE_RATE, or 0 to stop sampling.
+ * 
+ * @return 0 on success, -1 if `Memchunk` is NULL or shared, or the profile
+ *         could not be allocated.
+ * 
+ * Example usage:
+ * ```
+ * memc_set_profile(chunk, CEIT_PROFILE_RATE);
+ * run_workload(chunk);
+ * memc_profile_dump(chunk, "heap.prof");
+ * ```
+ */
+int memc_set_profile(Memchunk* Memchunk, size_t sample_bytes) {
+    if (!Memchunk || (Memchunk->flags & MEMC_SHARED)) return -1;
+
+    Memprofile* profile = Memchunk->profile;
+    if (!profile) {
+        if (!sample_bytes) return 0;
+        if (!(profile = calloc(1, sizeof(Memprofile)))) return -1;
+        pthread_mutex_init(&profile->lock, NULL);
+
+        // The first backtrace() loads the unwinder, which allocates; get that over with here
+        void* frame;
+        backtrace(&frame, 1);
+        for (struct Memchunk* current = Memchunk; current; current = chain_next(current)) {
+            __atomic_store_n(&current->profile, profile, __ATOMIC_RELEASE);
+        }
+    }
+    __atomic_store_n(&profile->rate, sample_bytes, __ATOMIC_RELAXED);
+    return 0;
+}
+
+/**
+ * @brief Writes the heap profile of a Memchunk in the text format of
+ * gperftools' heap profiler (`heap_v2`), which `pprof` reads.
+ * 
+ * One file holds both views: for every stack trace, the sampled blocks
+ * still live and all sampled allocations so far, with their requested
+ * bytes, followed by the process's memory mappings for symbolization. pprof
+ * scales the samples back up by the sampling rate in the header, so
+ * `pprof -sample_index=inuse_space` shows estimated live bytes and
+ * `-sample_index=alloc_space` the cumulative ones.
+ * 
+ * @param Memchunk The profiled Memchunk.
+ * @param path The file to write.
+ * 
+ * @return 0 on success, -1 if an argument is NULL, the Memchunk was never
+ *         profiled, or the file could not be written.
+ * 
+ * Example usage:
+ * ```
+ * memc_profile_dump(chunk, "heap.prof");
+ * // $ pprof -sample_index=inuse_space ./app heap.prof
+ * ```
+ */
+int memc_profile_dump(Memchunk* Memchunk, const char* path) {
+    if (!Memchunk || !path || !Memchunk->profile) return -1;
+    FILE* out = fopen(path, "w");
+    if (!out) return -1;
+
+    Memprofile* profile = Memchunk->profile;
+    pthread_mutex_lock(&profile->lock);
+    size_t live_count = 0, live_bytes = 0, alloc_count = 0, alloc_bytes = 0;
+    for (size_t i = 0; i < profile->site_count; i++) {
+        live_count += profile->sites[i].live_count;
+        live_bytes += profile->sites[i].live_bytes;
+        alloc_count += profile->sites[i].alloc_count;
+        alloc_bytes += profile->sites[i].alloc_bytes;
     }
+    size_t rate = __atomic_load_n(&profile->rate, __ATOMIC_RELAXED);
+    fprintf(out, "heap profile: %zu: %zu [%zu: %zu] @ heap_v2/%zu\n", live_count, live_bytes, alloc_count, alloc_bytes, rate ? rate : (size_t)CEIT_PROFILE_RATE);
+    for (size_t i = 0; i < profile->site_count; i++) {
+        ProfileSite* site = &profile->sites[i];
+        fprintf(out, "%zu: %zu [%zu: %zu] @", site->live_count, site->live_bytes, site->alloc_count, site->alloc_bytes);
+        for (int frame = 0; frame < site->depth; frame++) fprintf(out, " 0x%llx", (unsigned long long)(uintptr_t)site->frames[frame]);
+        fputc('\n', out);
+    }
+    pthread_mutex_unlock(&profile->lock);
 
-    // Free the Memchunk structure itself
-    free(Memchunk);
+    // pprof maps the addresses back to binaries and symbols with these
+    fputs("\nMAPPED_LIBRARIES:\n", out);
+    FILE* maps = fopen("/proc/self/maps", "r");
+    if (maps) {
+        char buffer[4096];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), maps)) > 0) fwrite(buffer, 1, n, out);
+        fclose(maps);
+    }
+    int failed = ferror(out);
+    return fclose(out) == 0 && !failed ? 0 : -1;
 }
 
 /**
  * @brief Debug function to display the status of multiple Memchunks.
  * 
  * This function prints details of each Memchunk, including its total size, used 
- * memory, free memory, and the memory blocks inside it.
+ * memory, free memory, and the memory blocks inside it. For a Memchunk that
+ * grew a chain, the totals cover the whole chain and each member is listed.
  * 
  * @param num_Memchunks The number of Memchunks to display.
  * 
@@ -264,13 +4316,68 @@ void memc_dbg(int num_Memchunks, ...) {
     for (int i = 0; i < num_Memchunks; i++) {
         Memchunk* curr_Memchunk = va_arg(args, Memchunk*);
         if (curr_Memchunk) {
+            // Totals cover the whole growth chain
+            size_t total_size = 0, used_memory = 0, free_memory = 0, chained = 0;
+            for (Memchunk* member = curr_Memchunk; member; member = chain_next(member)) {
+                chunk_lock(member);
+                total_size += member->total_size;
+                used_memory += member->used_memory;
+                free_memory += member->free_memory;
+                chunk_unlock(member);
+                chained++;
+            }
             printf("Memchunk: %s, Total Size: %zu, Used Memory: %zu, Free Memory: %zu, Next: %p\n", 
-                   curr_Memchunk->name, curr_Memchunk->total_size, curr_Memchunk->used_memory, 
-                   curr_Memchunk->free_memory, (void*)curr_Memchunk->next);
-            Memory* curr_mem = curr_Memchunk->memory_pool;
-            while (curr_mem) {
-                printf("  Memory Block: %s, Size: %zu, Is Free: %d\n", curr_mem->name, curr_mem->size, curr_mem->is_free);
-                curr_mem = curr_mem->next;
+                   curr_Memchunk->name, total_size, used_memory, free_memory, (void*)curr_Memchunk->next);
+            Memstats stats;
+            memc_stats(curr_Memchunk, &stats);
+            printf("  Allocations: %zu, Frees: %zu, Failed: %zu, Free Blocks: %zu, Largest Free: %zu, Fragmentation: %.1f%%\n",
+                   stats.alloc_count, stats.free_count, stats.failed_count, stats.free_blocks, stats.largest_free, 100.0 * stats.fragmentation);
+
+            for (Memchunk* member = curr_Memchunk; member; member = chain_next(member)) {
+                chunk_lock(member);
+                if (chained > 1) {
+                    printf("  Chained Memchunk: %p, Size: %zu, Used Memory: %zu, Free Memory: %zu\n",
+                           (void*)member, member->total_size, member->used_memory, member->free_memory);
+                }
+                if (member->purged_memory || member->decay_ms) {
+                    printf("  Purged Memory: %zu, Decay: %u ms\n", member->purged_memory, member->decay_ms);
+                }
+                if (member->flags & MEMC_MMAP) {
+                    static const char* const huge_pages[] = {"none", "transparent (MADV_HUGEPAGE)", "explicit (MAP_HUGETLB)"};
+                    printf("  Reserved: %zu, Committed: %zu, Huge Pages: %s\n", member->reserve_size, member->total_size,
+                           huge_pages[member->huge_pages]);
+                }
+                if (member->flags & MEMC_SHARED) {
+                    printf("  Shared Object: %s, Attached Processes: %zu\n", shared_header(member)->path, shared_header(member)->attached);
+                }
+                if (member->flags & MEMC_FILE) {
+                    printf("  File Size: %zu, Named Blocks: %zu\n", file_header(member)->file_size, member->name_count);
+                }
+                if (member->flags & MEMC_ARENA) {
+                    printf("  Arena Top: %zu, Named Blocks: %zu\n", member->arena_top, member->name_count);
+                }
+                if (member->flags & MEMC_BUDDY) {
+                    // Internal fragmentation: the part of the used blocks that requests rounded up to a power of two
+                    size_t wasted = member->used_memory - member->requested_memory;
+                    printf("  Buddy Orders: %u-%u, Requested: %zu, Internal Fragmentation: %zu (%.1f%%)\n", member->buddy_min_order,
+                           member->buddy_max_order, member->requested_memory, wasted,
+                           member->used_memory ? 100.0 * (double)wasted / (double)member->used_memory : 0.0);
+                    char* base = (char*)(member->memory_pool + 1);
+                    size_t size;
+                    for (size_t offset = 0; offset < member->total_size; offset += size) {
+                        size_t slot = offset >> member->buddy_min_order;
+                        size = (size_t)1 << (member->buddy_orders[slot] & ~CEIT_BUDDY_NAMED);
+                        printf("  Memory Block: %s, Size: %zu, Is Free: %d\n", block_name_of(member, (Memory*)(base + offset) - 1),
+                               size, buddy_is_free(member, slot));
+                    }
+                }
+                Memory* curr_mem = member->flags & (MEMC_ARENA | MEMC_BUDDY) ? NULL : member->memory_pool;
+                while (curr_mem) {
+                    printf("  Memory Block: %s, Size: %zu, Is Free: %d\n", block_name_of(member, curr_mem),
+                           block_size(curr_mem), (curr_mem->size & CEIT_BLOCK_FREE) != 0);
+                    curr_mem = block_next(member, curr_mem);
+                }
+                chunk_unlock(member);
             }
         } else {
             printf("Memchunk is NULL\n");
@@ -282,7 +4389,8 @@ void memc_dbg(int num_Memchunks, ...) {
 /**
  * @brief Debug function to display details of memory blocks.
  * 
- * This function prints details of the specified memory blocks.
+ * This function prints details of the specified memory blocks, given as the
+ * pointers returned by `memory_alloc`.
  * 
  * @param num_mem The number of memory blocks to display.
  * 
@@ -295,9 +4403,25 @@ void mem_dbg(int num_mem, ...) {
     va_list args;
     va_start(args, num_mem);
     for (int i = 0; i < num_mem; i++) {
-        Memory* curr_mem = va_arg(args, Memory*);
-        if (curr_mem) {
-            printf("Memory Block: %s, Size: %zu, Is Free: %d\n", curr_mem->name, curr_mem->size, curr_mem->is_free);
+        void* ptr = va_arg(args, void*);
+        if (ptr) {
+            Memory* curr_mem = block_of(ptr);
+            Memchunk* owner = chunk_find_owner(ptr);
+            if (owner && (owner->flags & MEMC_ARENA)) {
+                printf("Memory Block: arena allocation at offset %zu of %s\n", (size_t)((char*)ptr - (char*)(owner->memory_pool + 1)), owner->name);
+                continue;
+            }
+            if (owner && (owner->flags & MEMC_BUDDY)) {
+                chunk_lock(owner);
+                size_t slot = block_offset(owner, curr_mem) >> owner->buddy_min_order;
+                printf("Memory Block: %s, Size: %zu, Is Free: %d, Requested: %zu\n", block_name_of(owner, curr_mem),
+                       (size_t)1 << (owner->buddy_orders[slot] & ~CEIT_BUDDY_NAMED), buddy_is_free(owner, slot),
+                       buddy_is_free(owner, slot) ? 0 : (size_t)owner->buddy_requests[slot] * CEIT_ALIGN);
+                chunk_unlock(owner);
+                continue;
+            }
+            printf("Memory Block: %s, Size: %zu, Is Free: %d\n", owner ? block_name_of(owner, curr_mem) : "",
+                   block_size(curr_mem), (curr_mem->size & CEIT_BLOCK_FREE) != 0);
         } else {
             printf("Memory Block is NULL\n");
         }
@@ -312,20 +4436,13 @@ void mem_dbg(int num_mem, ...) {
  * in each Memchunk. Afterward, it deallocates the Memchunk itself and resets the global list.
  */
 void mem_clr() {
+    pthread_rwlock_wrlock(&global_memchunk_lock);
     Memchunk* current_chunk = global_memchunk_list;
 
     while (current_chunk) {
-        // Free all memory blocks in the current Memchunk's memory pool
-        Memory* current_mem = current_chunk->memory_pool;
-        while (current_mem) {
-            Memory* next_mem = current_mem->next;
-            free(current_mem);  // Free the current memory block
-            current_mem = next_mem;
-        }
-
-        // After all memory blocks are freed, free the Memchunk structure itself
-        Memchunk* next_chunk = current_chunk->next;
-        free(current_chunk);  // Free the Memchunk structure
+        // Free the memory pool and the Memchunk structure itself
+        Memchunk* next_chunk = current_chunk->global_next;
+        chunk_destroy(current_chunk);
 
         // Move to the next Memchunk in the list
         current_chunk = next_chunk;
@@ -333,4 +4450,5 @@ void mem_clr() {
 
     // Reset the global list after cleanup
     global_memchunk_list = NULL;
+    pthread_rwlock_unlock(&global_memchunk_lock);
 }
\ No newline at end of file
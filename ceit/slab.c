@@ -0,0 +1,143 @@
+#include "ceit.h"
+#include <stdint.h>
+
+/** Slot index that marks the end of a Memslab's free list. */
+#define MEMSLAB_NIL 0xffffffffu
+
+/** Offset of the first slot from the start of a Memslab's block; keeps the head on its own cache line. */
+#define MEMSLAB_SLOTS_OFFSET 64
+
+_Static_assert(sizeof(Memslab) <= MEMSLAB_SLOTS_OFFSET, "Memslab must fit in front of its slots");
+
+/**
+ * @brief Returns the slot with the given index.
+ */
+static char* slot_at(const Memslab* slab, uint32_t index) {
+    return slab->slots + (size_t)index * slab->slot_size;
+}
+
+/**
+ * @brief Creates a pool of equally sized slots carved from a Memchunk.
+ * 
+ * The pool takes a single block from the Memchunk and splits it into `count`
+ * slots of `obj_size` bytes with no per-object header. Free slots form a
+ * lock-free stack, so `memslab_alloc` and `memslab_free` may be called from
+ * several threads at once without taking any lock.
+ * 
+ * @param chunk The Memchunk to carve the pool from.
+ * @param obj_size The size of each object in bytes.
+ * @param count The number of objects the pool holds.
+ * 
+ * @return A pointer to the new Memslab, or NULL if the Memchunk has no room
+ *         or the arguments are invalid.
+ * 
+ * Example usage:
+ * ```
+ * Memslab* nodes = memslab_create(chunk, sizeof(Node), 4096);
+ * ```
+ */
+Memslab* memslab_create(Memchunk* chunk, size_t obj_size, size_t count) {
+    if (!chunk || obj_size == 0 || count == 0 || count >= MEMSLAB_NIL) return NULL;
+
+    // Slots hold a 32-bit free-list link while free; round them for natural alignment
+    size_t slot_size = obj_size < sizeof(uint32_t) ? sizeof(uint32_t) : obj_size;
+    size_t align = slot_size >= CEIT_ALIGN ? CEIT_ALIGN : slot_size >= 8 ? 8 : sizeof(uint32_t);
+    slot_size = (slot_size + align - 1) & ~(align - 1);
+    if (count > (SIZE_MAX - MEMSLAB_SLOTS_OFFSET) / slot_size) return NULL;
+
+    Memslab* slab = (Memslab*)memory_alloc_aligned(chunk, MEMSLAB_SLOTS_OFFSET + count * slot_size, MEMSLAB_SLOTS_OFFSET, NULL);
+    if (!slab) return NULL;
+
+    slab->chunk = chunk;
+    slab->slots = (char*)slab + MEMSLAB_SLOTS_OFFSET;
+    slab->slot_size = slot_size;
+    slab->count = count;
+
+    // Chain every slot into the free list in address order
+    for (size_t i = 0; i < count; i++) {
+        *(uint32_t*)slot_at(slab, (uint32_t)i) = i + 1 < count ? (uint32_t)(i + 1) : MEMSLAB_NIL;
+    }
+    slab->head = 0;  // Tag 0, first slot
+    return slab;
+}
+
+/**
+ * @brief Takes an object slot from the pool.
+ * 
+ * Lock-free: the head of the free list is swapped with a compare-and-swap on
+ * a (tag, index) pair. The tag changes on every update, so a head that was
+ * popped and pushed back in between (the ABA problem) is still detected.
+ * 
+ * @param slab The Memslab to allocate from.
+ * 
+ * @return A pointer to an uninitialized slot, or NULL if the pool is empty.
+ * 
+ * Example usage:
+ * ```
+ * Node* node = memslab_alloc(nodes);
+ * ```
+ */
+void* memslab_alloc(Memslab* slab) {
+    if (!slab) return NULL;
+
+    unsigned long long old_head = __atomic_load_n(&slab->head, __ATOMIC_ACQUIRE);
+    for (;;) {
+        uint32_t index = (uint32_t)old_head;
+        if (index == MEMSLAB_NIL) return NULL;
+
+        // The slot may be popped and reused concurrently; the tag check below catches that
+        uint32_t next = __atomic_load_n((uint32_t*)slot_at(slab, index), __ATOMIC_RELAXED);
+        unsigned long long new_head = ((old_head >> 32) + 1) << 32 | next;
+        if (__atomic_compare_exchange_n(&slab->head, &old_head, new_head, 1, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+            return slot_at(slab, index);
+        }
+    }
+}
+
+/**
+ * @brief Returns an object slot to the pool.
+ * 
+ * Lock-free, like `memslab_alloc`. Pointers that do not point at a slot of
+ * this pool are ignored.
+ * 
+ * @param slab The Memslab the object was allocated from.
+ * @param ptr The pointer returned by `memslab_alloc`.
+ * 
+ * Example usage:
+ * ```
+ * memslab_free(nodes, node);
+ * ```
+ */
+void memslab_free(Memslab* slab, void* ptr) {
+    if (!slab || !ptr) return;
+
+    size_t offset = (size_t)((char*)ptr - slab->slots);
+    if ((char*)ptr < slab->slots || offset >= slab->count * slab->slot_size || offset % slab->slot_size != 0) return;
+    uint32_t index = (uint32_t)(offset / slab->slot_size);
+
+    unsigned long long old_head = __atomic_load_n(&slab->head, __ATOMIC_RELAXED);
+    for (;;) {
+        __atomic_store_n((uint32_t*)ptr, (uint32_t)old_head, __ATOMIC_RELAXED);
+        unsigned long long new_head = ((old_head >> 32) + 1) << 32 | index;
+        if (__atomic_compare_exchange_n(&slab->head, &old_head, new_head, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Releases the pool's block back to its Memchunk.
+ * 
+ * WARNING: No thread may use the pool or any of its objects afterwards.
+ * 
+ * @param slab The Memslab to destroy.
+ * 
+ * Example usage:
+ * ```
+ * memslab_destroy(nodes);
+ * ```
+ */
+void memslab_destroy(Memslab* slab) {
+    if (!slab) return;
+    memory_free_ptr(slab->chunk, slab);
+}
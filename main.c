@@ -7,7 +7,7 @@ int main() {
     Memchunk *chunk = memc_init("joyc",1024*1024);
     memc_dbg(1,chunk); //debug the memory chunk
     //ask for memory from the chunk
-    Memory *mem = memory_alloc(chunk, 10,"SJOY_1");
+    void *mem = memory_alloc(chunk, 10,"SJOY_1");
     mem_dbg(1,mem); //debug the memory block
     //write data to the memory block if size is 0 it automatcially increases size as per needed else it will use the size provided and if the data doesnt fit , itt trims it 
     if (memory_write(mem,"HI0099",0) == 0) {
@@ -22,5 +22,7 @@ int main() {
     } else {
         printf("Read failed\n");
     }
+    //free the block straight from its pointer, no name lookup needed
+    memory_free_ptr(chunk, mem);
     mem_clr();
 }
@@ -0,0 +1,68 @@
+// Aligned allocation: default 16-byte alignment and memory_alloc_aligned up to page alignment.
+#include "test.h"
+
+static void test_default_alignment(void) {
+    Memchunk* chunk = memc_init("align_default", 1 << 16);
+    for (size_t size = 1; size < 200; size += 3) {
+        void* ptr = memory_alloc(chunk, size, NULL);
+        CHECK(ptr && (uintptr_t)ptr % CEIT_ALIGN == 0);
+    }
+    memc_dealloc(chunk);
+}
+
+static void test_aligned(void) {
+    static const size_t aligns[] = {1, 16, 32, 64, 128, 4096, 65536};
+    Memchunk* chunk = memc_init("align", 4 << 20);
+    void* blocks[200];
+    int count = 0;
+    srand(3);
+    for (int round = 0; round < 200; round++) {
+        size_t align = aligns[rand() % 7];
+        size_t size = 1 + rand() % 3000;
+        void* ptr = memory_alloc_aligned(chunk, size, align, NULL);
+        CHECK(ptr != NULL);
+        CHECK((uintptr_t)ptr % (align < CEIT_ALIGN ? CEIT_ALIGN : align) == 0);
+        fill_pattern(ptr, size, round);
+        blocks[count++] = ptr;
+        if (rand() % 3 == 0) memory_free_ptr(chunk, blocks[--count]);
+    }
+    check_heap(chunk);
+    // The padding went back to the free lists, so it can be reused
+    size_t used = chunk->used_memory;
+    CHECK(used < 200 * (3000 + 16) + 65536);
+    for (int i = 0; i < count; i++) memory_free_ptr(chunk, blocks[i]);
+    check_heap(chunk);
+    CHECK(chunk->used_memory == 0);
+    memc_dealloc(chunk);
+}
+
+static void test_padding_returned(void) {
+    Memchunk* chunk = memc_init("align_padding", 1 << 16);
+    memory_alloc(chunk, 16, NULL);
+    void* page = memory_alloc_aligned(chunk, 64, 4096, "PAGE");
+    CHECK(page && (uintptr_t)page % 4096 == 0);
+    CHECK(memory_find(chunk, "PAGE") == page);
+    CHECK(chunk->used_memory == 32 + 64);  // The padding in front is a free block, not used memory
+    void* small = memory_alloc(chunk, 100, NULL);
+    CHECK((char*)small < (char*)page);  // Served from the padding
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+static void test_invalid(void) {
+    Memchunk* chunk = memc_init("align_invalid", 1 << 16);
+    CHECK(memory_alloc_aligned(chunk, 64, 48, NULL) == NULL);  // Not a power of two
+    CHECK(memory_alloc_aligned(chunk, 64, 1 << 20, NULL) == NULL);  // Cannot fit
+    CHECK(memory_alloc_aligned(chunk, 0, 64, NULL) == NULL);
+    CHECK(chunk->used_memory == 0);
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    test_default_alignment();
+    test_aligned();
+    test_padding_returned();
+    test_invalid();
+    return TEST_RESULT();
+}
@@ -0,0 +1,92 @@
+// Bump-pointer arenas: contiguous allocation, O(1) reset, names, and realloc in place at the top.
+#include "test.h"
+
+static void test_bump_and_reset(void) {
+    Memchunk* chunk = memc_init_arena("arena", 1 << 16);
+    char* a = memory_alloc(chunk, 10, NULL);
+    char* b = memory_alloc(chunk, 100, "B");
+    char* c = memory_alloc_aligned(chunk, 8, 64, NULL);
+    CHECK(b == a + 16);  // No header: the next allocation follows the rounded size
+    CHECK((uintptr_t)c % 64 == 0 && c >= b + 112);
+    CHECK(memory_find(chunk, "B") == b);
+    memory_free_ptr(chunk, a);  // Ignored: arenas are only reclaimed as a whole
+    CHECK(chunk->arena_top == (size_t)(c + 16 - a));
+    CHECK(memory_alloc(chunk, 1 << 17, NULL) == NULL);
+
+    memc_reset(chunk);
+    CHECK(chunk->arena_top == 0 && chunk->used_memory == 0);
+    CHECK(memory_find(chunk, "B") == NULL);
+    CHECK(memory_alloc(chunk, 10, NULL) == a);
+    mem_clr();  // The arena is registered like any other Memchunk
+}
+
+static void test_realloc_top(void) {
+    Memchunk* chunk = memc_init_arena("arena_realloc", 1 << 16);
+    char* a = memory_alloc(chunk, 64, NULL);
+    fill_pattern(a, 64, 1);
+    // The last block grows and shrinks by moving the top
+    CHECK(memory_realloc(chunk, a, 1000) == a);
+    CHECK(chunk->arena_top == 1008 && chunk->used_memory == 1008);
+    CHECK(has_pattern(a, 64, 1));
+    CHECK(memory_realloc(chunk, a, 100) == a);
+    CHECK(chunk->arena_top == 112);
+    CHECK(memory_realloc(chunk, a, 1 << 17) == NULL);  // Does not fit: the block is left alone
+    CHECK(chunk->arena_top == 112);
+
+    // A block below the top shrinks in place, and moves to grow
+    char* b = memory_alloc(chunk, 32, NULL);
+    CHECK(memory_realloc(chunk, a, 48) == a);
+    CHECK(chunk->arena_top == 144);
+    char* moved = memory_realloc(chunk, a, 200);
+    CHECK(moved == b + 32);
+    CHECK(has_pattern(moved, 48, 1));
+    memc_dealloc(chunk);
+}
+
+static void test_realloc_after_reset(void) {
+    // Starts recorded before a reset must not cut a new block short
+    Memchunk* chunk = memc_init_arena("arena_reset", 1 << 16);
+    for (int i = 0; i < 100; i++) memory_alloc(chunk, 16, NULL);
+    memc_reset(chunk);
+    char* a = memory_alloc(chunk, 512, NULL);
+    char* b = memory_alloc(chunk, 16, NULL);
+    fill_pattern(a, 512, 2);
+    char* moved = memory_realloc(chunk, a, 1024);
+    CHECK(moved == b + 16);
+    CHECK(has_pattern(moved, 512, 2));  // All 512 bytes were copied
+    CHECK(memory_realloc(chunk, b, 16) == b);
+    memc_dealloc(chunk);
+}
+
+static void test_named_realloc(void) {
+    Memchunk* chunk = memc_init_arena("arena_named", 1 << 16);
+    char* a = memory_alloc(chunk, 64, "A");
+    fill_pattern(a, 64, 3);
+    char* moved = memory_realloc(chunk, a, 128);
+    CHECK(moved != a && has_pattern(moved, 64, 3));  // Named blocks move, and the old copy keeps the name
+    CHECK(memory_find(chunk, "A") == a);
+    Memtag tag;
+    CHECK(memc_tag_stats(chunk, &tag, 1) == 1 && tag.live_bytes == 64);
+    memc_dealloc(chunk);
+}
+
+static void test_mmap_commit(void) {
+    Memchunk* chunk = memc_init_flags("arena_mmap", 64 << 20, MEMC_ARENA | MEMC_MMAP);
+    char* a = memory_alloc(chunk, 100, NULL);
+    size_t committed = chunk->total_size;
+    CHECK(committed < chunk->reserve_size);
+    // Growing the last block commits more of the reservation in place
+    CHECK(memory_realloc(chunk, a, committed + 4096) == a);
+    CHECK(chunk->total_size > committed);
+    memset(a, 1, committed + 4096);
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    test_bump_and_reset();
+    test_realloc_top();
+    test_realloc_after_reset();
+    test_named_realloc();
+    test_mmap_commit();
+    return TEST_RESULT();
+}
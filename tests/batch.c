@@ -0,0 +1,108 @@
+// Batch allocation and free: contiguous carving, all-or-nothing, and coalescing back into one block.
+#include "test.h"
+
+#define N 500
+
+static void test_contiguous(void) {
+    Memchunk* chunk = memc_init("batch", 1 << 20);
+    size_t sizes[N];
+    void* out[N];
+    for (int i = 0; i < N; i++) sizes[i] = 1 + i % 200;
+    CHECK(memory_alloc_batch(chunk, N, sizes, out) == 0);
+    for (int i = 0; i < N; i++) {
+        CHECK((uintptr_t)out[i] % CEIT_ALIGN == 0);
+        fill_pattern(out[i], sizes[i], i);
+        if (i) CHECK((char*)out[i] == (char*)out[i - 1] + (((Memory*)out[i - 1] - 1)->size & ~(size_t)CEIT_BLOCK_FLAGS) + sizeof(Memory));
+    }
+    for (int i = 0; i < N; i++) CHECK(has_pattern(out[i], sizes[i], i));
+    check_heap(chunk);
+    Memstats stats;
+    memc_stats(chunk, &stats);
+    CHECK(stats.alloc_count == N && stats.live_blocks == N);
+
+    // Freed together, the batch merges back into a single free block
+    memory_free_batch(chunk, out, N);
+    CHECK(chunk->used_memory == 0);
+    CHECK(chunk->memory_pool->size == (chunk->total_size | CEIT_BLOCK_FREE));
+    memory_free_batch(chunk, out, N);  // Double frees are ignored
+    CHECK(chunk->used_memory == 0);
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+static void test_all_or_nothing(void) {
+    Memchunk* chunk = memc_init("batch_fail", 16 * 1024);
+    size_t sizes[3] = {4000, 4000, 40000};
+    void* out[3];
+    CHECK(memory_alloc_batch(chunk, 3, sizes, out) == -1);
+    CHECK(chunk->used_memory == 0);
+    sizes[2] = 0;
+    CHECK(memory_alloc_batch(chunk, 3, sizes, out) == -1);
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+static void test_fragmented(void) {
+    // No single free block holds the batch, so its blocks come from several
+    Memchunk* chunk = memc_init("batch_fragmented", 64 * 1024);
+    void* blocks[40];
+    for (int i = 0; i < 40; i++) blocks[i] = memory_alloc(chunk, 1000, NULL);
+    for (int i = 0; i < 40; i += 2) memory_free_ptr(chunk, blocks[i]);
+    size_t sizes[20];
+    void* out[20];
+    for (int i = 0; i < 20; i++) sizes[i] = 900;
+    memory_alloc(chunk, chunk->free_memory - 20 * 1008 - 64, NULL);  // Fill the tail
+    CHECK(memory_alloc_batch(chunk, 20, sizes, out) == 0);
+    check_heap(chunk);
+    memory_free_batch(chunk, out, 20);
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+static void test_stale_headers(void) {
+    // Headers carved out of old data or free-list links start clean, so every block frees
+    static const unsigned flags[] = {0, MEMC_THREAD_SAFE};
+    for (size_t f = 0; f < sizeof(flags) / sizeof(flags[0]); f++) {
+        Memchunk* chunk = memc_init_flags("batch_stale", 1 << 20, flags[f]);
+        void* old = memory_alloc(chunk, 64 * 1024, NULL);
+        memset(old, 0xff, 64 * 1024);
+        memory_free_ptr(chunk, old);
+        size_t sizes[100];
+        void* out[100];
+        for (int i = 0; i < 100; i++) sizes[i] = 48;
+        CHECK(memory_alloc_batch(chunk, 100, sizes, out) == 0);
+        for (int i = 0; i < 100; i++) CHECK(((Memory*)out[i] - 1)->name_hash == 0);
+        memory_free_batch(chunk, out, 100);
+        CHECK(chunk->used_memory == 0);
+        check_heap(chunk);
+        memc_dealloc(chunk);
+    }
+}
+
+static void test_thread_safe_and_arena(void) {
+    static const unsigned flags[] = {MEMC_THREAD_SAFE, MEMC_ARENA, MEMC_TLSF, MEMC_BEST_FIT};
+    for (size_t f = 0; f < sizeof(flags) / sizeof(flags[0]); f++) {
+        Memchunk* chunk = memc_init_flags("batch_flags", 1 << 20, flags[f]);
+        size_t sizes[N];
+        void* out[N];
+        for (int i = 0; i < N; i++) sizes[i] = 16 + i % 64;
+        CHECK(memory_alloc_batch(chunk, N, sizes, out) == 0);
+        for (int i = 0; i < N; i++) fill_pattern(out[i], sizes[i], i);
+        for (int i = 0; i < N; i++) CHECK(has_pattern(out[i], sizes[i], i));
+        memory_free_batch(chunk, out, N);
+        if (!(flags[f] & MEMC_ARENA)) {
+            CHECK(chunk->used_memory == 0);
+            check_heap(chunk);
+        }
+        memc_dealloc(chunk);
+    }
+}
+
+int main(void) {
+    test_contiguous();
+    test_all_or_nothing();
+    test_fragmented();
+    test_stale_headers();
+    test_thread_safe_and_arena();
+    return TEST_RESULT();
+}
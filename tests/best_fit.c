@@ -0,0 +1,85 @@
+// Best-fit engine: every placement matches an exhaustive best-fit scan of the heap, under random traffic.
+#include "test.h"
+
+#define BLOCKS 2000
+#define MIN_PAYLOAD 32
+
+/** Returns the data of the smallest free block of at least `size` bytes, the lowest one among equals, by walking the heap. */
+static void* scan_best_fit(const Memchunk* chunk, size_t size) {
+    const char* end = (const char*)(chunk->memory_pool + 1) + chunk->total_size;
+    const Memory* best = NULL;
+    for (const Memory* block = chunk->memory_pool; (const char*)block < end;) {
+        size_t block_size = block->size & ~(size_t)CEIT_BLOCK_FLAGS;
+        if ((block->size & CEIT_BLOCK_FREE) && block_size >= size && (!best || block_size < (best->size & ~(size_t)CEIT_BLOCK_FLAGS))) {
+            best = block;
+        }
+        block = (const Memory*)((const char*)(block + 1) + block_size);
+    }
+    return best ? (void*)(best + 1) : NULL;
+}
+
+/** Rounds a request up the way memory_alloc does. */
+static size_t rounded(size_t size) {
+    size = (size + CEIT_ALIGN - 1) & ~(size_t)(CEIT_ALIGN - 1);
+    return size < MIN_PAYLOAD ? MIN_PAYLOAD : size;
+}
+
+static void test_placement(void) {
+    // Holes of 256, 128, 512 and 128 bytes, in that order
+    Memchunk* chunk = memc_init_flags("fit", 1 << 16, MEMC_BEST_FIT);
+    size_t sizes[] = {256, 128, 512, 128};
+    void* holes[4];
+    for (int i = 0; i < 4; i++) {
+        holes[i] = memory_alloc(chunk, sizes[i], NULL);
+        memory_alloc(chunk, 16, NULL);
+    }
+    while (memory_alloc(chunk, 1024, NULL)) {}
+    while (memory_alloc(chunk, 16, NULL)) {}
+    for (int i = 0; i < 4; i++) memory_free_ptr(chunk, holes[i]);
+
+    CHECK(memory_alloc(chunk, 100, NULL) == holes[1]);  // The first of the two smallest holes that fit
+    CHECK(memory_alloc(chunk, 128, NULL) == holes[3]);
+    CHECK(memory_alloc(chunk, 200, NULL) == holes[0]);
+    CHECK(memory_alloc(chunk, 600, NULL) == NULL);
+    CHECK(memory_alloc(chunk, 300, NULL) == holes[2]);
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+static void test_random_traffic(void) {
+    Memchunk* chunk = memc_init_flags("fit_random", 8 << 20, MEMC_BEST_FIT);
+    static void* blocks[BLOCKS];
+    static size_t sizes[BLOCKS];
+    size_t mismatches = 0;
+    srand(19);
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < BLOCKS; i++) {
+            if (blocks[i]) {
+                CHECK(has_pattern(blocks[i], sizes[i], i));
+                memory_free_ptr(chunk, blocks[i]);
+                blocks[i] = NULL;
+            }
+            if (rand() % 2) {
+                sizes[i] = rand() % 4 ? 1 + rand() % 512 : 1 + rand() % 16384;
+                void* expected = scan_best_fit(chunk, rounded(sizes[i]));
+                blocks[i] = memory_alloc(chunk, sizes[i], NULL);
+                CHECK(blocks[i] != NULL);
+                if (blocks[i] != expected) mismatches++;
+                if (blocks[i]) fill_pattern(blocks[i], sizes[i], i);
+            }
+        }
+        check_heap(chunk);
+    }
+    CHECK(mismatches == 0);
+    for (int i = 0; i < BLOCKS; i++) memory_free_ptr(chunk, blocks[i]);
+    check_heap(chunk);
+    CHECK(chunk->memory_pool->size == (chunk->total_size | CEIT_BLOCK_FREE));
+    CHECK(chunk->fit_root == 0);  // The whole pool is one free block again, the only tree node
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    test_placement();
+    test_random_traffic();
+    return TEST_RESULT();
+}
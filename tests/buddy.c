@@ -0,0 +1,131 @@
+// Buddy engine: power-of-two orders and alignment, buddy merging, the fragmentation report, and named blocks.
+#include "test.h"
+
+#define NAMED 2000
+
+static void test_orders(void) {
+    Memchunk* chunk = memc_init_buddy("buddy_orders", 1 << 20, 6);
+    CHECK(chunk->buddy_min_order == 6);
+    CHECK(chunk->buddy_max_order == 20);
+
+    void* page = memory_alloc(chunk, 4096, NULL);
+    CHECK(page != NULL && (uintptr_t)page % 4096 == 0);
+    CHECK(chunk->used_memory == 4096 && chunk->requested_memory == 4096);
+
+    // Other sizes round up to a power of two, never below the smallest order
+    void* odd = memory_alloc(chunk, 100, NULL);
+    CHECK(odd != NULL && (uintptr_t)odd % 128 == 0);
+    void* tiny = memory_alloc(chunk, 1, NULL);
+    CHECK(tiny != NULL && (uintptr_t)tiny % 64 == 0);
+    CHECK(chunk->used_memory == 4096 + 128 + 64);
+    CHECK(chunk->requested_memory < chunk->used_memory);
+
+    CHECK(memory_alloc(chunk, (1 << 20) + 1, NULL) == NULL);
+    memory_free_ptr(chunk, page);
+    memory_free_ptr(chunk, odd);
+    memory_free_ptr(chunk, tiny);
+    CHECK(chunk->used_memory == 0 && chunk->requested_memory == 0);
+    memc_dealloc(chunk);
+}
+
+static void test_merge(void) {
+    // Split the pool into its smallest blocks, free them in a scattered order and get the whole pool back
+    Memchunk* chunk = memc_init_buddy("buddy_merge", 1 << 16, 6);
+    static void* blocks[1024];
+    for (int i = 0; i < 1024; i++) {
+        blocks[i] = memory_alloc(chunk, 64, NULL);
+        CHECK(blocks[i] != NULL);
+    }
+    CHECK(memory_alloc(chunk, 64, NULL) == NULL);
+    for (int i = 0; i < 1024; i++) {
+        int j = (i * 389) % 1024;  // 389 is coprime with 1024, so every block is freed once
+        memory_free_ptr(chunk, blocks[j]);
+    }
+    CHECK(chunk->used_memory == 0);
+    void* whole = memory_alloc(chunk, 1 << 16, NULL);
+    CHECK(whole == blocks[0]);
+    memory_free_ptr(chunk, whole);
+    memc_dealloc(chunk);
+}
+
+static void test_random_traffic(void) {
+    Memchunk* chunk = memc_init_buddy("buddy_random", 4 << 20, 6);
+    static void* blocks[1000];
+    static size_t sizes[1000];
+    srand(18);
+    for (int round = 0; round < 20; round++) {
+        for (int i = 0; i < 1000; i++) {
+            if (blocks[i]) {
+                CHECK(has_pattern(blocks[i], sizes[i], i));
+                memory_free_ptr(chunk, blocks[i]);
+                blocks[i] = NULL;
+            }
+            if (rand() % 2) {
+                sizes[i] = 1 + rand() % 4096;
+                blocks[i] = memory_alloc(chunk, sizes[i], NULL);
+                CHECK(blocks[i] != NULL);
+                if (blocks[i]) fill_pattern(blocks[i], sizes[i], i);
+            }
+        }
+    }
+    for (int i = 0; i < 1000; i++) memory_free_ptr(chunk, blocks[i]);
+    CHECK(chunk->used_memory == 0 && chunk->requested_memory == 0);
+    CHECK(memory_alloc(chunk, 4 << 20, NULL) != NULL);
+    memc_dealloc(chunk);
+}
+
+static void test_fragmentation_report(void) {
+    Memchunk* chunk = memc_init_buddy("buddy_dbg", 1 << 16, 6);
+    memory_alloc(chunk, 96, "odd");  // 128-byte block: 32 bytes of internal fragmentation
+    char* output = dbg_output(chunk);
+    CHECK(strstr(output, "Buddy Orders: 6-16, Requested: 96, Internal Fragmentation: 32 (25.0%)") != NULL);
+    CHECK(strstr(output, "Memory Block: odd, Size: 128, Is Free: 0") != NULL);
+    free(output);
+    memc_dealloc(chunk);
+}
+
+static void test_names(void) {
+    Memchunk* chunk = memc_init_buddy("buddy_names", 1 << 20, 6);
+    static void* blocks[NAMED];
+    char name[32];
+    for (int i = 0; i < NAMED; i++) {
+        snprintf(name, sizeof(name), "item_%d", i);
+        blocks[i] = memory_alloc(chunk, 64 + i % 200, name);
+        CHECK(blocks[i] != NULL);
+    }
+    CHECK(chunk->name_count == NAMED);
+    CHECK(chunk->buddy_names != NULL);
+    for (int i = 0; i < NAMED; i++) {
+        snprintf(name, sizeof(name), "item_%d", i);
+        CHECK(memory_find(chunk, name) == blocks[i]);
+    }
+
+    // Every other block goes by pointer, the rest by name, and the index keeps up either way
+    for (int i = 0; i < NAMED; i += 2) memory_free_ptr(chunk, blocks[i]);
+    CHECK(chunk->name_count == NAMED / 2);
+    for (int i = 0; i < NAMED; i++) {
+        snprintf(name, sizeof(name), "item_%d", i);
+        CHECK(memory_find(chunk, name) == (i % 2 ? blocks[i] : NULL));
+    }
+    for (int i = 1; i < NAMED; i += 2) {
+        snprintf(name, sizeof(name), "item_%d", i);
+        memory_free(chunk, name);
+    }
+    CHECK(chunk->name_count == 0 && chunk->used_memory == 0);
+
+    // A reused slot is anonymous until it is named again
+    void* anonymous = memory_alloc(chunk, 64, NULL);
+    CHECK(anonymous == blocks[0]);
+    CHECK(memory_find(chunk, "item_0") == NULL);
+    memory_free_ptr(chunk, anonymous);
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    test_orders();
+    test_merge();
+    test_random_traffic();
+    test_fragmentation_report();
+    test_names();
+    return TEST_RESULT();
+}
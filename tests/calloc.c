@@ -0,0 +1,69 @@
+// memory_calloc: zeroed data on every path, overflow checks, and no faults for memory known to be zero.
+#include "test.h"
+
+static size_t rss_kb(void) {
+    size_t pages = 0, resident = 0;
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (!file) return 0;
+    if (fscanf(file, "%zu %zu", &pages, &resident) != 2) resident = 0;
+    fclose(file);
+    return resident * 4;
+}
+
+static int is_zero(const unsigned char* ptr, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        if (ptr[i]) return 0;
+    }
+    return 1;
+}
+
+static void test_dirty_reuse(void) {
+    static const unsigned flags[] = {0, MEMC_THREAD_SAFE, MEMC_TLSF, MEMC_BEST_FIT, MEMC_MMAP, MEMC_ARENA};
+    for (size_t f = 0; f < sizeof(flags) / sizeof(flags[0]); f++) {
+        Memchunk* chunk = memc_init_flags("calloc", 1 << 20, flags[f]);
+        for (int round = 0; round < 50; round++) {
+            size_t size = 1 + (size_t)round * 97;
+            unsigned char* dirty = memory_alloc(chunk, size, NULL);
+            memset(dirty, 0xff, size);
+            memory_free_ptr(chunk, dirty);
+            if (flags[f] & MEMC_ARENA) memc_reset(chunk);
+            unsigned char* zeroed = memory_calloc(chunk, size, 1, NULL);
+            CHECK(zeroed != NULL && is_zero(zeroed, size));
+            memory_free_ptr(chunk, zeroed);
+        }
+        memc_dealloc(chunk);
+    }
+}
+
+static void test_overflow(void) {
+    Memchunk* chunk = memc_init("calloc_overflow", 1 << 16);
+    CHECK(memory_calloc(chunk, SIZE_MAX / 2, 3, NULL) == NULL);
+    CHECK(memory_calloc(chunk, 0, 16, NULL) == NULL);
+    CHECK(memory_calloc(chunk, 16, 16, "Z") != NULL);
+    CHECK(memory_calloc(chunk, 16, 16, "Z") == NULL);  // Name in use
+    Memstats stats;
+    memc_stats(chunk, &stats);
+    CHECK(stats.alloc_count == 1);
+    memc_dealloc(chunk);
+}
+
+static void test_untouched_pages(void) {
+    Memchunk* chunk = memc_init_flags("calloc_fresh", 256 << 20, MEMC_MMAP);
+    size_t before = rss_kb();
+    unsigned char* big = memory_calloc(chunk, 1, 128 << 20, NULL);
+    CHECK(big != NULL);
+    CHECK(rss_kb() - before < 8 << 10);  // Fresh pages are zero already, and stay unfaulted
+    CHECK(big[0] == 0 && big[(128 << 20) - 1] == 0);
+    memset(big, 1, 128 << 20);
+    memory_free_ptr(chunk, big);
+    unsigned char* again = memory_calloc(chunk, 1, 64 << 20, NULL);  // Dirty now, so it is cleared
+    CHECK(again && is_zero(again, 64 << 20));
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    test_dirty_reuse();
+    test_overflow();
+    test_untouched_pages();
+    return TEST_RESULT();
+}
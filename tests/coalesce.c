@@ -0,0 +1,87 @@
+// Boundary-tag coalescing: a freed block merges with its free physical neighbours in O(1).
+#include "test.h"
+
+/** Size of the block behind a payload pointer, flags stripped. */
+static size_t block_size(const void* ptr) {
+    return ((const Memory*)ptr - 1)->size & ~(size_t)CEIT_BLOCK_FLAGS;
+}
+
+static void test_neighbours(void) {
+    Memchunk* chunk = memc_init("coalesce", 1 << 16);
+    void* a = memory_alloc(chunk, 96, NULL);
+    void* b = memory_alloc(chunk, 96, NULL);
+    void* c = memory_alloc(chunk, 96, NULL);
+    void* d = memory_alloc(chunk, 96, NULL);
+    void* e = memory_alloc(chunk, 96, NULL);
+    size_t unit = block_size(a) + sizeof(Memory);
+
+    memory_free_ptr(chunk, b);  // No free neighbours
+    CHECK(block_size(b) == 96);
+    check_heap(chunk);
+    memory_free_ptr(chunk, c);  // Merges into b
+    CHECK(block_size(b) == 2 * unit - sizeof(Memory));
+    CHECK(((Memory*)d - 1)->size & CEIT_BLOCK_PREV_FREE);
+    check_heap(chunk);
+    memory_free_ptr(chunk, a);  // b merges into a
+    CHECK(block_size(a) == 3 * unit - sizeof(Memory));
+    check_heap(chunk);
+    memory_free_ptr(chunk, e);  // Merges with the free tail
+    CHECK(block_size(e) > 96);
+    check_heap(chunk);
+    memory_free_ptr(chunk, d);  // Both neighbours free: the whole pool is one block again
+    CHECK(chunk->memory_pool->size == (chunk->total_size | CEIT_BLOCK_FREE));
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+static void test_free_by_name(void) {
+    Memchunk* chunk = memc_init("coalesce_named", 1 << 16);
+    for (int i = 0; i < 50; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "N_%d", i);
+        CHECK(memory_alloc(chunk, 40 + i, name) != NULL);
+    }
+    for (int i = 0; i < 50; i += 2) {
+        char name[16];
+        snprintf(name, sizeof(name), "N_%d", i);
+        memory_free(chunk, name);
+    }
+    check_heap(chunk);
+    for (int i = 1; i < 50; i += 2) {
+        char name[16];
+        snprintf(name, sizeof(name), "N_%d", i);
+        memory_free(chunk, name);
+    }
+    check_heap(chunk);
+    CHECK(chunk->used_memory == 0);
+    CHECK(chunk->memory_pool->size == (chunk->total_size | CEIT_BLOCK_FREE));
+    memc_dealloc(chunk);
+}
+
+static void test_random_order(void) {
+    enum { N = 20000 };
+    Memchunk* chunk = memc_init("coalesce_random", 4 << 20);
+    static void* blocks[N];
+    for (int i = 0; i < N; i++) blocks[i] = memory_alloc(chunk, 16 + (i % 7) * 16, NULL);
+    srand(2);
+    for (int i = N - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        void* t = blocks[i];
+        blocks[i] = blocks[j];
+        blocks[j] = t;
+    }
+    for (int i = 0; i < N; i++) {
+        memory_free_ptr(chunk, blocks[i]);
+        if (i % 5000 == 0) check_heap(chunk);
+    }
+    check_heap(chunk);
+    CHECK(chunk->memory_pool->size == (chunk->total_size | CEIT_BLOCK_FREE));
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    test_neighbours();
+    test_free_by_name();
+    test_random_order();
+    return TEST_RESULT();
+}
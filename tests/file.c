@@ -0,0 +1,121 @@
+// File-backed Memchunks: data, offsets and names survive a reopen, memc_sync marks what a reopen sees, and bad files are refused.
+#include "test.h"
+
+#define ITEMS 500
+
+static char path[64];
+
+static void test_reopen(void) {
+    unlink(path);
+    Memchunk* chunk = memc_open_file(path, 1 << 20);
+    CHECK(chunk != NULL);
+    if (!chunk) return;
+
+    // A named root holds the offsets of anonymous blocks, the way an index would
+    size_t* root = (size_t*)memory_alloc(chunk, ITEMS * sizeof(size_t), "root");
+    for (int i = 0; i < ITEMS; i++) {
+        void* item = memory_alloc(chunk, 16 + i % 300, NULL);
+        fill_pattern(item, 16 + i % 300, i);
+        root[i] = memc_offset(chunk, item);
+    }
+    void* config = memory_alloc(chunk, 100, "config");
+    fill_pattern(config, 100, 1000);
+    void* dropped = memory_alloc(chunk, 100, "dropped");
+    memory_free_ptr(chunk, dropped);
+    size_t used = chunk->used_memory;
+    check_heap(chunk);
+    memc_dealloc(chunk);
+
+    // total_size is ignored for an existing file
+    chunk = memc_open_file(path, 4096);
+    CHECK(chunk != NULL);
+    if (!chunk) return;
+    CHECK(chunk->total_size >= 1 << 20);
+    check_heap(chunk);
+    root = (size_t*)memory_find(chunk, "root");
+    CHECK(root != NULL);
+    for (int i = 0; root && i < ITEMS; i++) CHECK(has_pattern(memc_pointer(chunk, root[i]), 16 + i % 300, i));
+    config = memory_find(chunk, "config");
+    CHECK(config != NULL && has_pattern(config, 100, 1000));
+    CHECK(memory_find(chunk, "dropped") == NULL);
+    CHECK(chunk->used_memory == used);  // The saved names' block is free again
+
+    // The reopened pool keeps working: free some items, allocate more, and reopen once more
+    for (int i = 0; i < ITEMS; i += 2) memory_free_ptr(chunk, memc_pointer(chunk, root[i]));
+    void* added = memory_alloc(chunk, 2000, "added");
+    CHECK(added != NULL);
+    if (added) fill_pattern(added, 2000, 2000);
+    memory_free(chunk, "config");
+    check_heap(chunk);
+    memc_dealloc(chunk);
+
+    chunk = memc_open_file(path, 0);
+    CHECK(chunk != NULL);
+    if (!chunk) return;
+    check_heap(chunk);
+    root = (size_t*)memory_find(chunk, "root");
+    for (int i = 1; root && i < ITEMS; i += 2) CHECK(has_pattern(memc_pointer(chunk, root[i]), 16 + i % 300, i));
+    added = memory_find(chunk, "added");
+    CHECK(added != NULL && has_pattern(added, 2000, 2000));
+    CHECK(memory_find(chunk, "config") == NULL);
+    memc_dealloc(chunk);
+}
+
+static void test_sync(void) {
+    // A reopen sees the names of the last sync; the file is read back by a second mapping
+    unlink(path);
+    Memchunk* chunk = memc_open_file(path, 1 << 16);
+    void* first = memory_alloc(chunk, 64, "first");
+    fill_pattern(first, 64, 1);
+    CHECK(memc_sync(chunk) == 0);
+    void* second = memory_alloc(chunk, 64, "second");  // Named after the sync, so a reopen sees it anonymous
+    fill_pattern(second, 64, 2);
+
+    Memchunk* copy = memc_open_file(path, 0);
+    CHECK(copy != NULL);
+    if (copy) {
+        void* seen = memory_find(copy, "first");
+        CHECK(seen != NULL && has_pattern(seen, 64, 1));
+        CHECK(memc_offset(copy, seen) == memc_offset(chunk, first));
+        CHECK(memory_find(copy, "second") == NULL);
+        CHECK(copy->name_count == 1);
+        CHECK(has_pattern(memc_pointer(copy, memc_offset(chunk, second)), 64, 2));
+        memc_dealloc(copy);
+    }
+
+    CHECK(memc_sync(chunk) == 0);  // The names block of the last sync is reused, not leaked
+    size_t used = chunk->used_memory;
+    CHECK(memc_sync(chunk) == 0);
+    CHECK(chunk->used_memory == used);
+    memc_dealloc(chunk);
+}
+
+static void test_refused(void) {
+    Memchunk* plain = memc_init("plain", 1 << 16);
+    CHECK(memc_sync(plain) == -1);
+    memc_dealloc(plain);
+
+    // A file that does not hold a Memchunk is not opened, and is left alone
+    unlink(path);
+    FILE* file = fopen(path, "w");
+    char junk[8192];
+    memset(junk, 'x', sizeof(junk));
+    fwrite(junk, 1, sizeof(junk), file);
+    fclose(file);
+    CHECK(memc_open_file(path, 1 << 16) == NULL);
+    file = fopen(path, "r");
+    CHECK(fgetc(file) == 'x');
+    fclose(file);
+
+    CHECK(memc_open_file("/nonexistent/dir/chunk", 1 << 16) == NULL);
+    unlink(path);
+}
+
+int main(void) {
+    snprintf(path, sizeof(path), "/tmp/ceit_file_test_%d", (int)getpid());
+    test_reopen();
+    test_sync();
+    test_refused();
+    unlink(path);
+    return TEST_RESULT();
+}
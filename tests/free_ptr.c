@@ -0,0 +1,76 @@
+// Freeing by pointer: memory_free_ptr and mem_free, which finds the Memchunk by address.
+#include "test.h"
+
+static void test_free_ptr(void) {
+    Memchunk* chunk = memc_init("free_ptr", 1 << 16);
+    void* a = memory_alloc(chunk, 64, "A");
+    void* b = memory_alloc(chunk, 64, NULL);
+    memory_free_ptr(chunk, a);
+    CHECK(memory_find(chunk, "A") == NULL);  // A named block leaves the name index
+    CHECK(chunk->used_memory == 64);
+    memory_free_ptr(chunk, a);  // Double free: ignored
+    CHECK(chunk->used_memory == 64);
+    check_heap(chunk);
+
+    char outside[64];
+    memory_free_ptr(chunk, outside);  // Not in the Memchunk: ignored
+    memory_free_ptr(chunk, NULL);
+    CHECK(chunk->used_memory == 64);
+    memory_free_ptr(chunk, b);
+    CHECK(chunk->used_memory == 0);
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+static void test_mem_free(void) {
+    Memchunk* first = memc_init("mem_free_1", 1 << 16);
+    Memchunk* second = memc_init("mem_free_2", 1 << 16);
+    void* a = memory_alloc(first, 100, NULL);
+    void* b = memory_alloc(second, 200, "B");
+    mem_free(b);
+    CHECK(second->used_memory == 0);
+    CHECK(first->used_memory == 112);
+    mem_free(a);
+    CHECK(first->used_memory == 0);
+    mem_free(NULL);
+    int on_stack;
+    mem_free(&on_stack);  // Owned by no Memchunk: ignored
+    check_heap(first);
+    check_heap(second);
+    memc_dealloc(first);
+    memc_dealloc(second);
+}
+
+static void test_wrong_chunk(void) {
+    Memchunk* first = memc_init("wrong_1", 1 << 16);
+    Memchunk* second = memc_init("wrong_2", 1 << 16);
+    void* a = memory_alloc(first, 100, NULL);
+    memory_free_ptr(second, a);  // Not in `second`: ignored, `first` keeps it
+    CHECK(first->used_memory == 112);
+    CHECK(second->used_memory == 0);
+    memory_free_ptr(first, a);
+    CHECK(first->used_memory == 0);
+    memc_dealloc(first);
+    memc_dealloc(second);
+}
+
+static void test_double_free_after_merge(void) {
+    Memchunk* chunk = memc_init("merged", 1 << 16);
+    void* blocks[8];
+    for (int i = 0; i < 8; i++) blocks[i] = memory_alloc(chunk, 64, NULL);
+    // Each block merges into the free one before it, leaving its header inside that block
+    for (int i = 0; i < 8; i++) memory_free_ptr(chunk, blocks[i]);
+    for (int i = 7; i >= 0; i--) memory_free_ptr(chunk, blocks[i]);
+    CHECK(chunk->used_memory == 0);
+    CHECK(chunk->memory_pool->size == (chunk->total_size | CEIT_BLOCK_FREE));
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    test_free_ptr();
+    test_mem_free();
+    test_wrong_chunk();
+    test_double_free_after_merge();
+    return TEST_RESULT();
+}
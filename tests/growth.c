@@ -0,0 +1,82 @@
+// Growth chains: allocations spill into chained Memchunks, frees find their owner, and the cap holds.
+#include "test.h"
+
+static size_t chain_length(const Memchunk* chunk) {
+    size_t length = 0;
+    for (; chunk; chunk = chunk->next) length++;
+    return length;
+}
+
+static void test_grow(void) {
+    Memchunk* chunk = memc_init("grow", 4096);
+    CHECK(memc_set_growth(chunk, 8192, 2.0, 0) == 0);
+    void* blocks[1000];
+    for (int i = 0; i < 1000; i++) {
+        blocks[i] = memory_alloc(chunk, 100, NULL);
+        CHECK(blocks[i] != NULL);
+        fill_pattern(blocks[i], 100, i);
+    }
+    CHECK(chain_length(chunk) > 3);
+    CHECK(chunk->next->total_size == 8192);
+    CHECK(chunk->next->next->total_size == 16384);  // Each member doubles
+    CHECK(memory_alloc(chunk, 1 << 20, NULL) != NULL);  // Larger than the next size: a member just large enough
+
+    for (int i = 0; i < 1000; i++) {
+        CHECK(has_pattern(blocks[i], 100, i));
+        if (i % 2) memory_free_ptr(chunk, blocks[i]);  // Routed to the owning member
+        else mem_free(blocks[i]);
+    }
+    check_heap(chunk);
+
+    Memstats stats;
+    CHECK(memc_stats(chunk, &stats) == 0);
+    CHECK(stats.alloc_count == 1001 && stats.free_count == 1000 && stats.live_blocks == 1);
+    memc_dealloc(chunk);  // Releases the members too
+}
+
+static void test_names_across_chain(void) {
+    Memchunk* chunk = memc_init("grow_names", 4096);
+    memc_set_growth(chunk, 0, 1.0, 0);
+    char name[CEIT_NAME_LEN];
+    for (int i = 0; i < 200; i++) {
+        snprintf(name, sizeof(name), "N_%d", i);
+        CHECK(memory_alloc(chunk, 64, name) != NULL);
+    }
+    CHECK(chain_length(chunk) > 1);
+    CHECK(memory_alloc(chunk, 64, "N_0") == NULL);  // Names are unique across the chain
+    CHECK(memory_find(chunk, "N_199") != NULL);
+    for (int i = 0; i < 200; i++) {
+        snprintf(name, sizeof(name), "N_%d", i);
+        memory_free(chunk, name);
+    }
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+static void test_cap(void) {
+    Memchunk* chunk = memc_init("grow_cap", 4096);
+    CHECK(memc_set_growth(chunk, 4096, 1.0, 16384) == 0);
+    int count = 0;
+    while (memory_alloc(chunk, 1000, NULL)) count++;
+    CHECK(chain_length(chunk) == 4);  // 16 KiB in all, the head included
+    CHECK(count >= 12 && count <= 16);
+
+    CHECK(memc_set_growth(chunk, 4096, 0.5, 0) == -1);
+    CHECK(memc_set_growth(NULL, 4096, 2.0, 0) == -1);
+    memc_dealloc(chunk);
+}
+
+static void test_no_growth(void) {
+    Memchunk* chunk = memc_init("no_growth", 4096);
+    CHECK(memory_alloc(chunk, 8192, NULL) == NULL);
+    CHECK(chunk->next == NULL);
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    test_grow();
+    test_names_across_chain();
+    test_cap();
+    test_no_growth();
+    return TEST_RESULT();
+}
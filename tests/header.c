@@ -0,0 +1,54 @@
+// Compact 16-byte block header: layout of consecutive blocks, flags and names kept out of the header.
+#include "test.h"
+
+static void test_layout(void) {
+    CHECK(sizeof(Memory) == 16);
+    Memchunk* chunk = memc_init("header", 1 << 16);
+    char* previous = memory_alloc(chunk, 1, NULL);
+    CHECK((char*)previous == (char*)(chunk->memory_pool + 1));
+    size_t previous_size = 1;
+    for (size_t size = 2; size < 300; size += 7) {
+        char* block = memory_alloc(chunk, size, NULL);
+        size_t rounded = (previous_size + CEIT_ALIGN - 1) / CEIT_ALIGN * CEIT_ALIGN;
+        if (rounded < 32) rounded = 32;  // Room for a free block's links and footer
+        CHECK(block == previous + rounded + sizeof(Memory));  // Blocks are back to back
+        CHECK((((Memory*)block - 1)->size & CEIT_BLOCK_FLAGS) == 0);
+        previous = block;
+        previous_size = size;
+    }
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+static void test_named_header(void) {
+    Memchunk* chunk = memc_init("header_named", 1 << 16);
+    char* named = memory_alloc(chunk, 32, "SJOY_1");
+    char* anonymous = memory_alloc(chunk, 32, NULL);
+    Memory* header = (Memory*)named - 1;
+    CHECK(header->size & CEIT_BLOCK_NAMED);
+    CHECK(!(((Memory*)anonymous - 1)->size & CEIT_BLOCK_NAMED));
+    CHECK(anonymous == named + 32 + sizeof(Memory));  // A name adds nothing to the block
+    memory_write(named, "0123456789abcdef0123456789abcdef", 32); // The whole payload belongs to the caller
+    CHECK(memory_find(chunk, "SJOY_1") == named);
+    memory_free(chunk, "SJOY_1");
+    CHECK(header->size & CEIT_BLOCK_FREE);
+    CHECK(!(header->size & CEIT_BLOCK_NAMED));
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+static void test_small_overhead(void) {
+    // 32-byte blocks cost 48 bytes each, where the old 112-byte header made them cost 144
+    Memchunk* chunk = memc_init("header_small", 48 * 1024);
+    int count = 0;
+    while (memory_alloc(chunk, 32, NULL)) count++;
+    CHECK(count == 1024);
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    test_layout();
+    test_named_header();
+    test_small_overhead();
+    return TEST_RESULT();
+}
@@ -0,0 +1,49 @@
+// Huge-page Memchunks: 2 MB aligned regions committed in 2 MB steps, with the mode shown by memc_dbg.
+#include "test.h"
+
+#define HUGE_PAGE (2 * 1024 * 1024)
+
+static void test_huge_pages(void) {
+    Memchunk* chunk = memc_init_flags("huge", 64 << 20, MEMC_HUGE_PAGES);
+    CHECK(chunk != NULL);
+    if (!chunk) return;
+    CHECK(chunk->flags & MEMC_MMAP);  // Implied
+    CHECK(chunk->commit_unit == HUGE_PAGE);
+    CHECK((chunk->total_size + sizeof(Memory)) % HUGE_PAGE == 0);
+    if (chunk->huge_pages) CHECK((uintptr_t)chunk->memory_pool % HUGE_PAGE == 0);
+
+    char* output = dbg_output(chunk);
+    const char* expected = chunk->huge_pages == MEMC_HUGE_EXPLICIT ? "Huge Pages: explicit" :
+                           chunk->huge_pages == MEMC_HUGE_TRANSPARENT ? "Huge Pages: transparent" : "Huge Pages: none";
+    CHECK(strstr(output, expected) != NULL);
+    free(output);
+
+    // Allocations past the first huge page commit another whole one
+    void* blocks[8];
+    for (int i = 0; i < 8; i++) {
+        blocks[i] = memory_alloc(chunk, 1 << 20, NULL);
+        CHECK(blocks[i] != NULL);
+        if (blocks[i]) memset(blocks[i], i, 1 << 20);
+    }
+    CHECK((chunk->total_size + sizeof(Memory)) % HUGE_PAGE == 0);
+    CHECK(chunk->total_size >= 8 << 20);
+    check_heap(chunk);
+    for (int i = 0; i < 8; i++) memory_free_ptr(chunk, blocks[i]);
+    CHECK(chunk->used_memory == 0);
+    memc_dealloc(chunk);
+}
+
+static void test_plain_mmap_reports_none(void) {
+    Memchunk* chunk = memc_init_flags("no_huge", 4 << 20, MEMC_MMAP);
+    CHECK(chunk->huge_pages == 0);
+    char* output = dbg_output(chunk);
+    CHECK(strstr(output, "Huge Pages: none") != NULL);
+    free(output);
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    test_huge_pages();
+    test_plain_mmap_reports_none();
+    return TEST_RESULT();
+}
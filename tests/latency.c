@@ -0,0 +1,105 @@
+// Latency histograms: every timed call is counted once, percentiles are ordered and within a bucket, and reads can reset.
+// cflags: -DCEIT_LATENCY
+#include "test.h"
+#include <pthread.h>
+
+#define THREADS 4
+#define PAIRS 10000
+
+/** Sums the buckets of one operation's histogram. */
+static unsigned long long bucket_sum(const Memlatency* latency, unsigned op) {
+    unsigned long long sum = 0;
+    for (size_t i = 0; i < CEIT_LATENCY_BUCKETS; i++) sum += latency->counts[op][i];
+    return sum;
+}
+
+static void test_counts(void) {
+    Memchunk* chunk = memc_init("latency", 1 << 20);
+    static Memlatency latency;
+    CHECK(memc_latency(chunk, &latency, 0) == 0);
+    CHECK(latency.total[MEMC_OP_ALLOC] == 0 && memlatency_percentile(&latency, MEMC_OP_ALLOC, 50) == 0);
+
+    void* blocks[1000];
+    char name[32];
+    for (int i = 0; i < 1000; i++) {
+        snprintf(name, sizeof(name), "block_%d", i);
+        blocks[i] = memory_alloc(chunk, 16 + i, i < 10 ? name : NULL);
+    }
+    for (int i = 10; i < 60; i++) blocks[i] = memory_realloc(chunk, blocks[i], 2000);
+    for (int i = 0; i < 10; i++) {
+        snprintf(name, sizeof(name), "block_%d", i);
+        memory_free(chunk, name);
+    }
+    for (int i = 10; i < 1000; i++) memory_free_ptr(chunk, blocks[i]);
+
+    CHECK(memc_latency(chunk, &latency, 0) == 0);
+    CHECK(latency.total[MEMC_OP_ALLOC] == 1000);
+    CHECK(latency.total[MEMC_OP_FREE] == 1000);
+    CHECK(latency.total[MEMC_OP_REALLOC] == 50);
+    for (unsigned op = 0; op < CEIT_LATENCY_OPS; op++) {
+        CHECK(bucket_sum(&latency, op) == latency.total[op]);
+        unsigned long long p50 = memlatency_percentile(&latency, op, 50), p99 = memlatency_percentile(&latency, op, 99);
+        CHECK(p50 > 0 && p50 <= p99 && p99 <= memlatency_percentile(&latency, op, 99.99));
+        CHECK(memlatency_percentile(&latency, op, 100) == latency.max[op]);
+    }
+
+    // A resetting read returns the counts and leaves empty histograms
+    CHECK(memc_latency(chunk, &latency, 1) == 0);
+    CHECK(latency.total[MEMC_OP_ALLOC] == 1000);
+    CHECK(memc_latency(chunk, &latency, 0) == 0);
+    CHECK(latency.total[MEMC_OP_ALLOC] == 0 && latency.max[MEMC_OP_ALLOC] == 0 && bucket_sum(&latency, MEMC_OP_ALLOC) == 0);
+
+    CHECK(memc_latency(NULL, &latency, 0) == -1);
+    CHECK(memc_latency(chunk, NULL, 0) == -1);
+    memc_dealloc(chunk);
+}
+
+static void test_percentiles(void) {
+    // 90 calls of 5 ticks, then 10 of 1000 ticks; buckets are exact below 16 and within 1/16 above
+    static Memlatency latency;
+    memset(&latency, 0, sizeof(latency));
+    latency.counts[MEMC_OP_ALLOC][5] = 90;
+    size_t bucket = ((size_t)(9 - CEIT_LATENCY_SUB_LOG + 1) << CEIT_LATENCY_SUB_LOG) + ((1000 >> (9 - CEIT_LATENCY_SUB_LOG)) & 15);
+    latency.counts[MEMC_OP_ALLOC][bucket] = 10;
+    latency.total[MEMC_OP_ALLOC] = 100;
+
+    CHECK(memlatency_percentile(&latency, MEMC_OP_ALLOC, 0) == 5);
+    CHECK(memlatency_percentile(&latency, MEMC_OP_ALLOC, 50) == 5);
+    CHECK(memlatency_percentile(&latency, MEMC_OP_ALLOC, 90) == 5);
+    unsigned long long p91 = memlatency_percentile(&latency, MEMC_OP_ALLOC, 91);
+    CHECK(p91 >= 1000 && p91 <= 1000 + 1000 / 16);
+
+    // The recorded maximum caps the bucket bound
+    latency.max[MEMC_OP_ALLOC] = 1000;
+    CHECK(memlatency_percentile(&latency, MEMC_OP_ALLOC, 91) == 1000);
+    CHECK(memlatency_percentile(&latency, MEMC_OP_ALLOC, 100) == 1000);
+    CHECK(memlatency_percentile(&latency, MEMC_OP_FREE, 50) == 0);
+    CHECK(memlatency_percentile(&latency, CEIT_LATENCY_OPS, 50) == 0);
+}
+
+static void* worker(void* arg) {
+    Memchunk* chunk = (Memchunk*)arg;
+    for (int i = 0; i < PAIRS; i++) memory_free_ptr(chunk, memory_alloc(chunk, 32 + (i % 8) * 16, NULL));
+    return NULL;
+}
+
+static void test_threads(void) {
+    // Threads record without a lock, and no call is lost
+    Memchunk* chunk = memc_init_flags("latency_threads", 4 << 20, MEMC_THREAD_SAFE);
+    pthread_t threads[THREADS];
+    for (int t = 0; t < THREADS; t++) pthread_create(&threads[t], NULL, worker, chunk);
+    for (int t = 0; t < THREADS; t++) pthread_join(threads[t], NULL);
+    static Memlatency latency;
+    memc_latency(chunk, &latency, 0);
+    CHECK(latency.total[MEMC_OP_ALLOC] == THREADS * PAIRS);
+    CHECK(latency.total[MEMC_OP_FREE] == THREADS * PAIRS);
+    CHECK(bucket_sum(&latency, MEMC_OP_ALLOC) == THREADS * PAIRS);
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    test_counts();
+    test_percentiles();
+    test_threads();
+    return TEST_RESULT();
+}
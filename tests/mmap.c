@@ -0,0 +1,69 @@
+// mmap-backed Memchunks: a large reservation, pages committed as allocations reach them, and frees across commits.
+#include "test.h"
+
+static size_t rss_kb(void) {
+    size_t pages = 0, resident = 0;
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (!file) return 0;
+    if (fscanf(file, "%zu %zu", &pages, &resident) != 2) resident = 0;
+    fclose(file);
+    return resident * 4;
+}
+
+static void test_reserve(void) {
+    size_t before = rss_kb();
+    Memchunk* chunk = memc_init_flags("reserve", (size_t)8 << 30, MEMC_MMAP);
+    CHECK(chunk != NULL);
+    if (!chunk) return;
+    CHECK(chunk->reserve_size >= ((size_t)8 << 30) - 4096);
+    CHECK(chunk->total_size < chunk->reserve_size);  // Only a first step is committed
+    CHECK(rss_kb() - before < 4096);
+    CHECK(chunk->free_memory == chunk->total_size);
+
+    // Allocations past the committed part commit more of the reservation
+    size_t committed = chunk->total_size;
+    void* blocks[64];
+    for (int i = 0; i < 64; i++) {
+        blocks[i] = memory_alloc(chunk, 1 << 20, NULL);
+        CHECK(blocks[i] != NULL);
+        if (blocks[i]) fill_pattern(blocks[i], 1 << 20, i);
+    }
+    CHECK(chunk->total_size > committed);
+    CHECK(chunk->total_size < ((size_t)1 << 30));  // Commits follow use
+    check_heap(chunk);
+    for (int i = 0; i < 64; i++) {
+        CHECK(has_pattern(blocks[i], 1 << 20, i));
+        memory_free_ptr(chunk, blocks[i]);
+    }
+    check_heap(chunk);
+    CHECK(chunk->used_memory == 0);
+    CHECK(chunk->memory_pool->size == (chunk->total_size | CEIT_BLOCK_FREE));
+    memc_dealloc(chunk);
+}
+
+static void test_exhaust_reservation(void) {
+    Memchunk* chunk = memc_init_flags("reserve_small", 1 << 20, MEMC_MMAP);
+    int count = 0;
+    while (memory_alloc(chunk, 4000, NULL)) count++;
+    CHECK(chunk->total_size == chunk->reserve_size);
+    CHECK(count > 200 && count <= 262);
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+static void test_one_large_block(void) {
+    Memchunk* chunk = memc_init_flags("reserve_large", 256 << 20, MEMC_MMAP);
+    char* big = memory_alloc(chunk, 200 << 20, NULL);  // Much larger than the first commit
+    CHECK(big != NULL);
+    if (big) big[(200 << 20) - 1] = 1;
+    check_heap(chunk);
+    memory_free_ptr(chunk, big);
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    test_reserve();
+    test_exhaust_reservation();
+    test_one_large_block();
+    return TEST_RESULT();
+}
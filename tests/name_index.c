@@ -0,0 +1,71 @@
+// Name index: O(1) memory_find and memory_free by name, duplicate names, index growth and deletion.
+#include "test.h"
+
+#define NAMES 20000
+
+static void name_of(char* buffer, size_t size, int i) {
+    snprintf(buffer, size, "block_%d", i);
+}
+
+static void test_many_names(void) {
+    Memchunk* chunk = memc_init("names", 8 << 20);
+    static void* blocks[NAMES];
+    char name[CEIT_NAME_LEN];
+    for (int i = 0; i < NAMES; i++) {
+        name_of(name, sizeof(name), i);
+        blocks[i] = memory_alloc(chunk, 16 + i % 64, name);
+        CHECK(blocks[i] != NULL);
+    }
+    for (int i = 0; i < NAMES; i++) {
+        name_of(name, sizeof(name), i);
+        CHECK(memory_find(chunk, name) == blocks[i]);
+    }
+    // Free every other name, then look everything up again across the deleted slots
+    for (int i = 0; i < NAMES; i += 2) {
+        name_of(name, sizeof(name), i);
+        memory_free(chunk, name);
+    }
+    for (int i = 0; i < NAMES; i++) {
+        name_of(name, sizeof(name), i);
+        CHECK(memory_find(chunk, name) == (i % 2 ? blocks[i] : NULL));
+    }
+    // Names can be reused once freed
+    for (int i = 0; i < NAMES; i += 2) {
+        name_of(name, sizeof(name), i);
+        blocks[i] = memory_alloc(chunk, 32, name);
+        CHECK(blocks[i] != NULL && memory_find(chunk, name) == blocks[i]);
+    }
+    check_heap(chunk);
+    CHECK(memory_find(chunk, "missing") == NULL);
+    memory_free(chunk, "missing");  // Unknown names are ignored
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+static void test_duplicates(void) {
+    Memchunk* chunk = memc_init("duplicates", 1 << 16);
+    void* first = memory_alloc(chunk, 64, "SAME");
+    CHECK(first != NULL);
+    CHECK(memory_alloc(chunk, 64, "SAME") == NULL);  // A live block already has the name
+    CHECK(chunk->used_memory == 64);
+    memory_free(chunk, "SAME");
+    CHECK(memory_alloc(chunk, 64, "SAME") != NULL);
+    memc_dealloc(chunk);
+}
+
+static void test_long_names(void) {
+    Memchunk* chunk = memc_init("long_names", 1 << 16);
+    const char* long_a = "0123456789012345678901234567890_A";
+    const char* long_b = "0123456789012345678901234567890_B";
+    CHECK(memory_alloc(chunk, 16, long_a) != NULL);
+    CHECK(memory_alloc(chunk, 16, long_b) == NULL);  // Same first 31 characters
+    CHECK(memory_find(chunk, "0123456789012345678901234567890") != NULL);
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    test_many_names();
+    test_duplicates();
+    test_long_names();
+    return TEST_RESULT();
+}
@@ -0,0 +1,108 @@
+// Heap profiler: sampled allocations are tracked by site until freed, the sampling rate holds on average, and the dump is in heap_v2 form.
+#include "test.h"
+
+/** Totals of a heap_v2 dump: its header and the site lines after it. */
+typedef struct {
+    size_t live_count, live_bytes, alloc_count, alloc_bytes, rate;
+    size_t sites;
+    size_t site_live[8], site_alloc[8], site_live_bytes[8];
+    int frames, mapped;
+} Dump;
+
+static int read_dump(const char* path, Dump* dump) {
+    memset(dump, 0, sizeof(*dump));
+    FILE* file = fopen(path, "r");
+    if (!file) return -1;
+    char line[4096];
+    int ok = fgets(line, sizeof(line), file) &&
+             sscanf(line, "heap profile: %zu: %zu [%zu: %zu] @ heap_v2/%zu", &dump->live_count, &dump->live_bytes,
+                    &dump->alloc_count, &dump->alloc_bytes, &dump->rate) == 5;
+    while (ok && fgets(line, sizeof(line), file) && line[0] != '\n') {
+        size_t live, live_bytes, alloc, alloc_bytes;
+        if (sscanf(line, "%zu: %zu [%zu: %zu] @", &live, &live_bytes, &alloc, &alloc_bytes) != 4) ok = 0;
+        if (dump->sites < 8) {
+            dump->site_live[dump->sites] = live;
+            dump->site_live_bytes[dump->sites] = live_bytes;
+            dump->site_alloc[dump->sites] = alloc;
+        }
+        dump->sites++;
+        if (strstr(line, "@ 0x")) dump->frames++;
+    }
+    while (ok && fgets(line, sizeof(line), file)) {
+        if (strcmp(line, "MAPPED_LIBRARIES:\n") == 0) dump->mapped = 1;
+    }
+    fclose(file);
+    return ok ? 0 : -1;
+}
+
+static __attribute__((noinline)) void* site_a(Memchunk* chunk) {
+    return memory_alloc(chunk, 64, NULL);
+}
+
+static __attribute__((noinline)) void* site_b(Memchunk* chunk) {
+    return memory_alloc(chunk, 128, NULL);
+}
+
+static char path[64];
+
+static void test_every_allocation(void) {
+    // At a rate of one byte, every allocation is sampled
+    Memchunk* chunk = memc_init("profile", 1 << 20);
+    CHECK(memc_profile_dump(chunk, path) == -1);  // Never profiled
+    CHECK(memc_set_profile(chunk, 1) == 0);
+    void* a[100];
+    void* b[50];
+    for (int i = 0; i < 100; i++) a[i] = site_a(chunk);
+    for (int i = 0; i < 50; i++) b[i] = site_b(chunk);
+    for (int i = 0; i < 20; i++) memory_free_ptr(chunk, a[i]);
+    memory_free_batch(chunk, a + 20, 10);
+    for (int i = 0; i < 10; i++) memory_alloc(chunk, 256, NULL);  // A third site, kept live
+
+    Dump dump;
+    CHECK(memc_profile_dump(chunk, path) == 0);
+    CHECK(read_dump(path, &dump) == 0);
+    CHECK(dump.rate == 1);
+    CHECK(dump.alloc_count == 160 && dump.alloc_bytes == 100 * 64 + 50 * 128 + 10 * 256);
+    CHECK(dump.live_count == 130 && dump.live_bytes == 70 * 64 + 50 * 128 + 10 * 256);
+    CHECK(dump.sites == 3 && dump.frames == 3);  // site_a, site_b and the loop in this function
+    CHECK(dump.site_live[0] == 70 && dump.site_alloc[0] == 100 && dump.site_live_bytes[0] == 70 * 64);
+    CHECK(dump.site_live[1] == 50 && dump.site_alloc[1] == 50);
+    CHECK(dump.mapped);
+
+    // Stopping keeps what was recorded, and frees still retire live samples
+    CHECK(memc_set_profile(chunk, 0) == 0);
+    for (int i = 0; i < 50; i++) memory_free_ptr(chunk, b[i]);
+    site_a(chunk);
+    CHECK(memc_profile_dump(chunk, path) == 0);
+    CHECK(read_dump(path, &dump) == 0);
+    CHECK(dump.alloc_count == 160 && dump.live_count == 80);
+    CHECK(dump.rate == CEIT_PROFILE_RATE);  // Stopped: the header still gives pprof a rate to scale by
+    memc_dealloc(chunk);
+}
+
+static void test_sampling_rate(void) {
+    // 5 MB in 256-byte blocks at one sample per 4 KiB on average: about 1250 samples
+    Memchunk* chunk = memc_init("profile_rate", 8 << 20);
+    CHECK(memc_set_profile(chunk, 4096) == 0);
+    for (int i = 0; i < 20000; i++) memory_alloc(chunk, 256, NULL);
+    Dump dump;
+    CHECK(memc_profile_dump(chunk, path) == 0);
+    CHECK(read_dump(path, &dump) == 0);
+    CHECK(dump.alloc_count > 1100 && dump.alloc_count < 1400);
+    CHECK(dump.live_count == dump.alloc_count && dump.live_bytes == dump.alloc_count * 256);
+
+    // Freeing everything leaves no live sample
+    memc_reset(chunk);
+    CHECK(memc_profile_dump(chunk, path) == 0);
+    CHECK(read_dump(path, &dump) == 0);
+    CHECK(dump.live_count == 0 && dump.live_bytes == 0);
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    snprintf(path, sizeof(path), "/tmp/ceit_profile_test_%d", (int)getpid());
+    test_every_allocation();
+    test_sampling_rate();
+    unlink(path);
+    return TEST_RESULT();
+}
@@ -0,0 +1,100 @@
+// memory_realloc: in-place growth into a free successor, in-place shrinking, moves, names and failures.
+#include "test.h"
+
+static void test_in_place(void) {
+    Memchunk* chunk = memc_init("realloc", 1 << 16);
+    char* a = memory_alloc(chunk, 64, NULL);
+    char* b = memory_alloc(chunk, 64, NULL);
+    memory_alloc(chunk, 64, NULL);
+    fill_pattern(a, 64, 1);
+
+    memory_free_ptr(chunk, b);
+    CHECK(memory_realloc(chunk, a, 128) == a);  // Absorbs the free successor
+    CHECK(has_pattern(a, 64, 1));
+    CHECK(chunk->used_memory == 128 + 64 + 16);  // Too little was left of b to split off
+    check_heap(chunk);
+
+    CHECK(memory_realloc(chunk, a, 32) == a);  // Splits off the tail
+    CHECK(chunk->used_memory == 32 + 64);
+    CHECK(has_pattern(a, 32, 1));
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+static void test_move(void) {
+    Memchunk* chunk = memc_init("realloc_move", 1 << 16);
+    char* a = memory_alloc(chunk, 100, "A");
+    memory_alloc(chunk, 16, NULL);  // Blocks growth in place
+    fill_pattern(a, 100, 2);
+    char* moved = memory_realloc(chunk, a, 4000);
+    CHECK(moved != NULL && moved != a);
+    CHECK(has_pattern(moved, 100, 2));
+    CHECK(memory_find(chunk, "A") == moved);  // The name moves along
+    CHECK(chunk->used_memory == 32 + 4000);
+    check_heap(chunk);
+
+    CHECK(memory_realloc(chunk, moved, 1 << 20) == NULL);  // No room: the block is left alone
+    CHECK(has_pattern(moved, 100, 2));
+    CHECK(memory_find(chunk, "A") == moved);
+    memc_dealloc(chunk);
+}
+
+static void test_edge_cases(void) {
+    Memchunk* chunk = memc_init("realloc_edges", 1 << 16);
+    char* a = memory_realloc(chunk, NULL, 50);  // Allocates
+    CHECK(a != NULL && chunk->used_memory == 64);
+    CHECK(memory_realloc(chunk, a, 0) == NULL);  // Frees
+    CHECK(chunk->used_memory == 0);
+    CHECK(memory_realloc(NULL, a, 10) == NULL);
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+static void test_growing_vector(void) {
+    static const unsigned flags[] = {0, MEMC_TLSF, MEMC_BEST_FIT, MEMC_THREAD_SAFE, MEMC_MMAP};
+    for (size_t f = 0; f < sizeof(flags) / sizeof(flags[0]); f++) {
+        Memchunk* chunk = memc_init_flags("vector", 1 << 20, flags[f]);
+        char* vector = NULL;
+        size_t capacity = 0, moves = 0;
+        for (size_t length = 1; length <= 100000; length++) {
+            if (length > capacity) {
+                capacity = capacity ? capacity * 2 : 16;
+                char* grown = memory_realloc(chunk, vector, capacity);
+                CHECK(grown != NULL);
+                moves += vector && grown != vector;
+                vector = grown;
+            }
+            vector[length - 1] = (char)length;
+        }
+        size_t wrong = 0;
+        for (size_t i = 0; i < 100000; i++) wrong += vector[i] != (char)(i + 1);
+        CHECK(wrong == 0);
+        // Alone in the chunk, the vector grows in place, except past the blocks a thread cache refill took
+        CHECK(flags[f] == MEMC_THREAD_SAFE ? moves < 10 : moves == 0);
+        memory_free_ptr(chunk, vector);
+        memc_flush(chunk);
+        check_heap(chunk);
+        memc_dealloc(chunk);
+    }
+}
+
+static void test_buddy(void) {
+    Memchunk* chunk = memc_init_buddy("realloc_buddy", 1 << 20, 6);
+    char* a = memory_alloc(chunk, 64, NULL);
+    fill_pattern(a, 64, 3);
+    CHECK(memory_realloc(chunk, a, 256) == a);  // Absorbs its free buddies
+    CHECK(has_pattern(a, 64, 3));
+    CHECK(chunk->used_memory == 256);
+    CHECK(memory_realloc(chunk, a, 64) == a);
+    CHECK(chunk->used_memory == 64);
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    test_in_place();
+    test_move();
+    test_edge_cases();
+    test_growing_vector();
+    test_buddy();
+    return TEST_RESULT();
+}
@@ -0,0 +1,26 @@
+#!/bin/sh
+# Builds each test the way build.sh builds the demo, runs it and reports the result.
+# Usage: tests/run.sh [test ...]    e.g. CC=gcc CFLAGS="-fsanitize=address,undefined" tests/run.sh realloc
+# A test can ask for extra flags with a "// cflags: ..." line.
+cd "$(dirname "$0")/.." || exit 1
+CC=${CC:-cc}
+mkdir -p tests/bin
+
+if [ $# -eq 0 ]; then
+    set -- $(ls tests/*.c | sed 's|tests/||; s|\.c$||')
+fi
+
+failed=0
+for name in "$@"; do
+    extra=$(sed -n 's|^// cflags: ||p' "tests/$name.c")
+    if ! $CC -g -O1 $CFLAGS $extra "tests/$name.c" $(find ./ceit -type f -name "*.c") -o "tests/bin/$name" -I ./ceit -pthread; then
+        echo "FAIL $name (build)"
+        failed=1
+    elif "./tests/bin/$name"; then
+        echo "PASS $name"
+    else
+        echo "FAIL $name"
+        failed=1
+    fi
+done
+exit $failed
@@ -0,0 +1,155 @@
+// Shared Memchunks: blocks handed between processes by offset, concurrent traffic from several processes, and poisoning when a process dies holding the lock.
+#include "test.h"
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define HANDOFF 100
+#define WORKERS 3
+
+static char name[64];
+
+static void test_handoff(void) {
+    Memchunk* chunk = memc_init_shared(name, 1 << 20);
+    CHECK(chunk != NULL);
+    if (!chunk) return;
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+
+    pid_t child = fork();
+    if (child == 0) {
+        // The child attaches on its own and allocates; only offsets cross the pipe
+        Memchunk* view = memc_init_shared(name, 0);
+        for (int i = 0; view && i < HANDOFF; i++) {
+            void* block = memory_alloc(view, 64 + i, NULL);
+            fill_pattern(block, 64 + i, i);
+            size_t offset = memc_offset(view, block);
+            if (write(fds[1], &offset, sizeof(offset)) != sizeof(offset)) _exit(1);
+        }
+        memc_dealloc(view);
+        _exit(view ? 0 : 1);
+    }
+    close(fds[1]);
+    size_t offset;
+    int received = 0;
+    while (read(fds[0], &offset, sizeof(offset)) == sizeof(offset)) {
+        void* block = memc_pointer(chunk, offset);
+        CHECK(block != NULL && has_pattern(block, 64 + received, received));
+        memory_free_ptr(chunk, block);  // Freed by the process that did not allocate it
+        received++;
+    }
+    close(fds[0]);
+    int status;
+    waitpid(child, &status, 0);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    CHECK(received == HANDOFF);
+
+    Memstats stats;
+    memc_stats(chunk, &stats);
+    CHECK(stats.alloc_count == HANDOFF && stats.free_count == HANDOFF);
+    CHECK(stats.live_blocks == 0 && stats.used_memory == 0);
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+static void test_concurrent(void) {
+    Memchunk* chunk = memc_init_shared(name, 8 << 20);
+    CHECK(chunk != NULL);
+    if (!chunk) return;
+
+    pid_t children[WORKERS];
+    for (int w = 0; w < WORKERS; w++) {
+        if ((children[w] = fork()) == 0) {
+            Memchunk* view = memc_init_shared(name, 0);
+            if (!view) _exit(1);
+            static void* blocks[200];
+            int failures = 0;
+            unsigned seed = (unsigned)w + 1;
+            for (int op = 0; op < 20000; op++) {
+                int i = rand_r(&seed) % 200;
+                if (blocks[i]) {
+                    failures += !has_pattern(blocks[i], 16 + i, w * 1000 + i);
+                    memory_free_ptr(view, blocks[i]);
+                    blocks[i] = NULL;
+                } else if ((blocks[i] = memory_alloc(view, 16 + i, NULL))) {
+                    fill_pattern(blocks[i], 16 + i, w * 1000 + i);
+                }
+            }
+            for (int i = 0; i < 200; i++) memory_free_ptr(view, blocks[i]);
+            memc_dealloc(view);
+            _exit(failures ? 2 : 0);
+        }
+    }
+    for (int w = 0; w < WORKERS; w++) {
+        int status;
+        waitpid(children[w], &status, 0);
+        CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+
+    Memstats stats;
+    memc_stats(chunk, &stats);
+    CHECK(stats.live_blocks == 0 && stats.used_memory == 0);
+    CHECK(stats.alloc_count == stats.free_count);
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+static void test_poisoned(void) {
+    Memchunk* chunk = memc_init_shared(name, 1 << 20);
+    CHECK(chunk != NULL);
+    if (!chunk) return;
+    static void* blocks[5000];
+    for (int i = 0; i < 5000; i++) blocks[i] = memory_alloc(chunk, 16, NULL);
+    fill_pattern(blocks[0], 16, 7);
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+
+    // memc_dbg holds the lock while it lists the blocks; with nobody reading, the child stalls inside it
+    pid_t child = fork();
+    if (child == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        memc_dbg(1, chunk);
+        _exit(0);
+    }
+    int pending = 0;
+    for (int waited = 0; waited < 5000 && pending < 65536; waited++) {
+        usleep(1000);
+        ioctl(fds[0], FIONREAD, &pending);
+    }
+    CHECK(pending >= 65536);
+    kill(child, SIGKILL);
+    waitpid(child, NULL, 0);
+    close(fds[0]);
+    close(fds[1]);
+
+    // The dead child's state cannot be trusted: nothing is allocated or freed, but the data is still there
+    CHECK(memory_alloc(chunk, 16, NULL) == NULL);
+    size_t sizes[2] = {16, 16};
+    void* batch[2];
+    CHECK(memory_alloc_batch(chunk, 2, sizes, batch) == -1);
+    CHECK(memory_realloc(chunk, blocks[1], 64) == NULL);
+    memory_free_ptr(chunk, blocks[1]);
+    memory_free_batch(chunk, blocks + 2, 10);
+    Memstats stats;
+    memc_stats(chunk, &stats);
+    CHECK(stats.live_blocks == 5000);
+    CHECK(has_pattern(blocks[0], 16, 7));
+
+    // A reset formats the pool anew and lifts the poison
+    memc_reset(chunk);
+    void* fresh = memory_alloc(chunk, 16, NULL);
+    CHECK(fresh != NULL);
+    memory_free_ptr(chunk, fresh);
+    check_heap(chunk);
+    memc_dealloc(chunk);
+    shm_unlink(name);  // The dead child never detached, so the object outlives the last memc_dealloc
+}
+
+int main(void) {
+    snprintf(name, sizeof(name), "/ceit_shared_test_%d", (int)getpid());
+    test_handoff();
+    test_concurrent();
+    test_poisoned();
+    return TEST_RESULT();
+}
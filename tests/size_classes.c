@@ -0,0 +1,101 @@
+// Segregated size-class free lists: placement, reuse, the class bitmap and the counters.
+#include "test.h"
+
+#define BLOCKS 4000
+
+/** Checks that bit i of free_map is set exactly when free list i is non-empty. */
+static void check_free_map(const Memchunk* chunk) {
+    for (int i = 0; i < CEIT_SIZE_CLASSES; i++) {
+        CHECK(((chunk->free_map >> i) & 1) == (chunk->free_lists[i] != (size_t)-1));
+    }
+}
+
+static void test_random_traffic(void) {
+    Memchunk* chunk = memc_init("classes", 8 << 20);
+    CHECK(chunk != NULL);
+    void* blocks[BLOCKS] = {0};
+    size_t sizes[BLOCKS] = {0};
+    srand(1);
+    for (int round = 0; round < 20; round++) {
+        for (int i = 0; i < BLOCKS; i++) {
+            if (blocks[i] && rand() % 2) {
+                CHECK(has_pattern(blocks[i], sizes[i], (unsigned)i));
+                memory_free_ptr(chunk, blocks[i]);
+                blocks[i] = NULL;
+            } else if (!blocks[i]) {
+                sizes[i] = rand() % 8 ? 1 + rand() % 256 : 1 + rand() % 8192;
+                blocks[i] = memory_alloc(chunk, sizes[i], NULL);
+                CHECK(blocks[i] != NULL);
+                if (blocks[i]) fill_pattern(blocks[i], sizes[i], (unsigned)i);
+            }
+        }
+        check_heap(chunk);
+        check_free_map(chunk);
+    }
+    for (int i = 0; i < BLOCKS; i++) {
+        if (blocks[i]) CHECK(has_pattern(blocks[i], sizes[i], (unsigned)i));
+        memory_free_ptr(chunk, blocks[i]);
+    }
+    check_heap(chunk);
+    CHECK(chunk->used_memory == 0);
+    CHECK(chunk->memory_pool->size == (chunk->total_size | CEIT_BLOCK_FREE));  // Merged back into one block
+    memc_dealloc(chunk);
+}
+
+static void test_exact_class_reuse(void) {
+    Memchunk* chunk = memc_init("reuse", 1 << 20);
+    void* before = memory_alloc(chunk, 200, NULL);
+    void* hole = memory_alloc(chunk, 200, NULL);
+    void* after = memory_alloc(chunk, 200, NULL);
+    memory_free_ptr(chunk, hole);
+    // The freed block sits in the request's own class, ahead of the large tail block
+    CHECK(memory_alloc(chunk, 200, NULL) == hole);
+    CHECK(before && after);
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+static void test_split_from_larger_class(void) {
+    Memchunk* chunk = memc_init("split", 1 << 20);
+    void* small = memory_alloc(chunk, 24, NULL);
+    CHECK(small != NULL);
+    CHECK(chunk->used_memory == 32);  // Rounded up to the smallest payload that can hold free-list links
+    CHECK(chunk->free_map != 0);
+    check_free_map(chunk);
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+static void test_exhaustion(void) {
+    Memchunk* chunk = memc_init("full", 64 * 1024);
+    void* blocks[4096];
+    int count = 0;
+    while (count < 4096 && (blocks[count] = memory_alloc(chunk, 100, NULL))) count++;
+    CHECK(count > 100 && count < 4096);
+    CHECK(memory_alloc(chunk, 100, NULL) == NULL);
+    memory_free_ptr(chunk, blocks[count / 2]);
+    CHECK(memory_alloc(chunk, 100, NULL) == blocks[count / 2]);
+    CHECK(memory_alloc(chunk, 0, NULL) == NULL);
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+static void test_dbg_still_works(void) {
+    Memchunk* chunk = memc_init("dbg", 1 << 16);
+    memory_alloc(chunk, 100, "Named");
+    memory_alloc(chunk, 300, NULL);
+    fflush(stdout);
+    FILE* saved = freopen("/dev/null", "w", stdout);
+    memc_dbg(1, chunk);
+    CHECK(saved != NULL);
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    test_random_traffic();
+    test_exact_class_reuse();
+    test_split_from_larger_class();
+    test_exhaustion();
+    test_dbg_still_works();
+    return TEST_RESULT();
+}
@@ -0,0 +1,87 @@
+// Lock-free slab pools: every slot handed out once, slot layout, foreign pointers, and many threads at once.
+#include "test.h"
+#include <pthread.h>
+
+#define THREADS 8
+#define SLOTS 1024
+
+static void test_slots(void) {
+    Memchunk* chunk = memc_init("slab", 1 << 20);
+    Memslab* slab = memslab_create(chunk, 24, 100);
+    CHECK(slab != NULL);
+    char* slots[100];
+    for (int i = 0; i < 100; i++) {
+        slots[i] = memslab_alloc(slab);
+        CHECK(slots[i] != NULL);
+        CHECK((uintptr_t)slots[i] % 8 == 0);
+        memset(slots[i], i, 24);
+        for (int j = 0; j < i; j++) CHECK(slots[j] != slots[i]);
+    }
+    CHECK(memslab_alloc(slab) == NULL);  // Empty
+    for (int i = 0; i < 100; i++) {
+        for (int k = 0; k < 24; k++) CHECK(slots[i][k] == (char)i);  // No slot overlaps another
+    }
+
+    char outside[32];
+    memslab_free(slab, outside);     // Not a slot: ignored
+    memslab_free(slab, slots[0] + 1); // Not the start of a slot: ignored
+    CHECK(memslab_alloc(slab) == NULL);
+    memslab_free(slab, slots[42]);
+    CHECK(memslab_alloc(slab) == slots[42]);
+
+    for (int i = 0; i < 100; i++) memslab_free(slab, slots[i]);
+    memslab_destroy(slab);
+    CHECK(chunk->used_memory == 0);
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+static void test_invalid(void) {
+    Memchunk* chunk = memc_init("slab_invalid", 4096);
+    CHECK(memslab_create(chunk, 0, 10) == NULL);
+    CHECK(memslab_create(chunk, 16, 0) == NULL);
+    CHECK(memslab_create(chunk, 64, 1000) == NULL);  // No room
+    CHECK(memslab_create(NULL, 16, 10) == NULL);
+    CHECK(chunk->used_memory == 0);
+    memc_dealloc(chunk);
+}
+
+static Memslab* shared_slab;
+static int owners[SLOTS];
+
+static void* worker(void* arg) {
+    int id = (int)(size_t)arg;
+    for (int round = 0; round < 20000; round++) {
+        int* slot = memslab_alloc(shared_slab);
+        if (!slot) continue;
+        size_t index = ((char*)slot - shared_slab->slots) / shared_slab->slot_size;
+        // Nobody else may own the slot while this thread holds it
+        if (__atomic_exchange_n(&owners[index], id, __ATOMIC_ACQ_REL) != 0) __atomic_add_fetch(&test_failures, 1, __ATOMIC_RELAXED);
+        *slot = id;
+        if (*slot != id) __atomic_add_fetch(&test_failures, 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&owners[index], 0, __ATOMIC_RELEASE);
+        memslab_free(shared_slab, slot);
+    }
+    return NULL;
+}
+
+static void test_threads(void) {
+    Memchunk* chunk = memc_init_flags("slab_threads", 1 << 20, MEMC_THREAD_SAFE);
+    shared_slab = memslab_create(chunk, sizeof(int), SLOTS);
+    pthread_t threads[THREADS];
+    for (size_t i = 0; i < THREADS; i++) pthread_create(&threads[i], NULL, worker, (void*)(i + 1));
+    for (int i = 0; i < THREADS; i++) pthread_join(threads[i], NULL);
+    // Every slot is back on the free list, exactly once
+    int count = 0;
+    while (memslab_alloc(shared_slab)) count++;
+    CHECK(count == SLOTS);
+    memslab_destroy(shared_slab);
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    test_slots();
+    test_invalid();
+    test_threads();
+    return TEST_RESULT();
+}
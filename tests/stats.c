@@ -0,0 +1,136 @@
+// Statistics: the counters of plain and thread-safe chunks agree, whether or not a thread cache served the calls.
+#include "test.h"
+#include <pthread.h>
+
+#define THREADS 4
+#define PAIRS 10000
+
+/** Runs the same mixed workload on a chunk: alloc/free pairs of several sizes, then 100 blocks of which half stay live. */
+static void workload(Memchunk* chunk) {
+    for (int i = 0; i < 1000; i++) memory_free_ptr(chunk, memory_alloc(chunk, 16 + (i % 4) * 100, NULL));
+    static void* kept[100];
+    for (int i = 0; i < 100; i++) kept[i] = memory_alloc(chunk, 48, NULL);
+    for (int i = 0; i < 100; i += 2) memory_free_ptr(chunk, kept[i]);
+}
+
+static void test_plain_and_thread_safe(void) {
+    Memchunk* plain = memc_init("stats_plain", 1 << 20);
+    Memchunk* safe = memc_init_flags("stats_safe", 1 << 20, MEMC_THREAD_SAFE);
+    workload(plain);
+    workload(safe);
+
+    Memstats a, b;
+    memc_stats(plain, &a);
+    memc_stats(safe, &b);
+    CHECK(a.alloc_count == 1100 && a.free_count == 1050 && a.live_blocks == 50);
+    CHECK(b.alloc_count == a.alloc_count);
+    CHECK(b.free_count == a.free_count);
+    CHECK(b.live_blocks == a.live_blocks);
+    CHECK(b.requested_bytes == a.requested_bytes);
+    CHECK(b.reserved_bytes == a.reserved_bytes);
+
+    // Cached blocks are not live but still take memory until flushed; a flush changes no count
+    CHECK(b.used_memory > a.used_memory);
+    memc_flush(safe);
+    memc_stats(safe, &b);
+    CHECK(b.alloc_count == a.alloc_count && b.free_count == a.free_count && b.live_blocks == a.live_blocks);
+    CHECK(b.used_memory == a.used_memory);
+    check_heap(safe);
+
+    memc_dealloc(plain);
+    memc_dealloc(safe);
+}
+
+static void* worker(void* arg) {
+    Memchunk* chunk = (Memchunk*)arg;
+    for (int i = 0; i < PAIRS; i++) memory_free_ptr(chunk, memory_alloc(chunk, 32 + (i % 8) * 16, NULL));
+    for (int i = 0; i < 10; i++) memory_alloc(chunk, 64, NULL);  // Left live when the thread exits
+    return NULL;
+}
+
+static void test_threads(void) {
+    Memchunk* chunk = memc_init_flags("stats_threads", 4 << 20, MEMC_THREAD_SAFE);
+    pthread_t threads[THREADS];
+    for (int t = 0; t < THREADS; t++) pthread_create(&threads[t], NULL, worker, chunk);
+    for (int t = 0; t < THREADS; t++) pthread_join(threads[t], NULL);
+
+    // The exiting threads flushed their caches and handed their counts over
+    Memstats stats;
+    memc_stats(chunk, &stats);
+    CHECK(stats.alloc_count == THREADS * (PAIRS + 10));
+    CHECK(stats.free_count == THREADS * PAIRS);
+    CHECK(stats.live_blocks == THREADS * 10);
+    CHECK(stats.reserved_bytes >= stats.requested_bytes);
+    CHECK(chunk->tcaches == NULL);
+    check_heap(chunk);
+
+    // A live thread's counts are read from its cache as it goes
+    worker(chunk);
+    memc_stats(chunk, &stats);
+    CHECK(stats.alloc_count == (THREADS + 1) * (PAIRS + 10));
+    CHECK(stats.live_blocks == (THREADS + 1) * 10);
+    memc_dealloc(chunk);
+}
+
+/** Size of the largest free block, found by walking every block. */
+static size_t walk_largest_free(const Memchunk* chunk) {
+    const char* end = (const char*)(chunk->memory_pool + 1) + chunk->total_size;
+    size_t largest = 0;
+    for (const Memory* block = chunk->memory_pool; (const char*)block < end;) {
+        size_t size = block->size & ~(size_t)CEIT_BLOCK_FLAGS;
+        if ((block->size & CEIT_BLOCK_FREE) && size > largest) largest = size;
+        block = (const Memory*)((const char*)(block + 1) + size);
+    }
+    return largest;
+}
+
+static void test_largest_free(void) {
+    // The largest free block is kept as blocks come and go, and agrees with a walk of the heap
+    static const unsigned flags[] = {0, MEMC_TLSF};
+    for (size_t f = 0; f < sizeof(flags) / sizeof(flags[0]); f++) {
+        Memchunk* chunk = memc_init_flags("stats_largest", 1 << 20, flags[f]);
+        void* blocks[256] = {0};
+        unsigned seed = 7;
+        Memstats stats;
+        for (int round = 0; round < 20000; round++) {
+            int i = rand_r(&seed) % 256;
+            if (blocks[i]) {
+                memory_free_ptr(chunk, blocks[i]);
+                blocks[i] = NULL;
+            } else {
+                blocks[i] = memory_alloc(chunk, 16 + rand_r(&seed) % 4000, NULL);
+            }
+            if (round % 97 == 0) {
+                memc_stats(chunk, &stats);
+                CHECK(stats.largest_free == walk_largest_free(chunk));
+            }
+        }
+        memc_stats(chunk, &stats);
+        CHECK(stats.largest_free == walk_largest_free(chunk));
+        memc_dealloc(chunk);
+    }
+}
+
+static void test_reset(void) {
+    Memchunk* chunk = memc_init_flags("stats_reset", 1 << 20, MEMC_THREAD_SAFE);
+    for (int i = 0; i < 100; i++) memory_free_ptr(chunk, memory_alloc(chunk, 32, NULL));
+    memc_reset(chunk);
+    Memstats stats;
+    memc_stats(chunk, &stats);
+    CHECK(stats.alloc_count == 100 && stats.free_count == 100 && stats.live_blocks == 0);
+    CHECK(chunk->tcaches == NULL);
+
+    // The dropped cache starts over, and counts again
+    for (int i = 0; i < 100; i++) memory_free_ptr(chunk, memory_alloc(chunk, 32, NULL));
+    memc_stats(chunk, &stats);
+    CHECK(stats.alloc_count == 200 && stats.free_count == 200 && stats.live_blocks == 0);
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    test_plain_and_thread_safe();
+    test_threads();
+    test_largest_free();
+    test_reset();
+    return TEST_RESULT();
+}
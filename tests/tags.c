@@ -0,0 +1,131 @@
+// Tags: names fold into tags, live bytes and counts follow allocation, free and realloc, and memc_tag_stats ranks them across a chain.
+#include "test.h"
+
+/** Returns the entry for `name` in a memc_tag_stats result, or NULL. */
+static const Memtag* find_tag(const Memtag* tags, size_t count, const char* name) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(tags[i].name, name) == 0) return &tags[i];
+    }
+    return NULL;
+}
+
+static void test_tag_names(void) {
+    Memchunk* chunk = memc_init("tag_names", 1 << 16);
+    const char* names[] = {"SJOY_1", "SJOY_22", "net-buf-3", "net-buf-4", "cache.7", "cache:8", "404", "x9", "_5", "plain"};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) memory_alloc(chunk, 32, names[i]);
+
+    Memtag tags[16];
+    size_t count = memc_tag_stats(chunk, tags, 16);
+    CHECK(count == 7);
+    CHECK(find_tag(tags, count, "SJOY") && find_tag(tags, count, "SJOY")->live_blocks == 2);
+    CHECK(find_tag(tags, count, "net-buf") && find_tag(tags, count, "net-buf")->live_blocks == 2);
+    CHECK(find_tag(tags, count, "cache") && find_tag(tags, count, "cache")->live_blocks == 2);
+    CHECK(find_tag(tags, count, "404") != NULL);   // All digits: the whole name
+    CHECK(find_tag(tags, count, "x") != NULL);     // No separator to drop
+    CHECK(find_tag(tags, count, "_") != NULL);     // The separator is all that is left, so it stays
+    CHECK(find_tag(tags, count, "plain") != NULL);
+    memc_dealloc(chunk);
+}
+
+static void test_accounting(void) {
+    Memchunk* chunk = memc_init("tag_accounting", 1 << 20);
+    char name[32];
+    void* blocks[10];
+    for (int i = 0; i < 10; i++) {
+        snprintf(name, sizeof(name), "mesh_%d", i);
+        blocks[i] = memory_alloc(chunk, 256, name);
+    }
+    for (int i = 0; i < 100; i++) memory_alloc(chunk, 64, NULL);  // Anonymous blocks have no tag
+    memory_alloc(chunk, 100, "audio_0");  // Rounded up to 112 bytes
+
+    Memtag tags[4];
+    size_t count = memc_tag_stats(chunk, tags, 4);
+    CHECK(count == 2);
+    CHECK(strcmp(tags[0].name, "mesh") == 0 && tags[0].live_bytes == 2560 && tags[0].live_blocks == 10 && tags[0].alloc_count == 10);
+    CHECK(strcmp(tags[1].name, "audio") == 0 && tags[1].live_bytes == 112 && tags[1].live_blocks == 1);
+
+    // Frees by pointer and by name take the bytes off; the count of allocations stays
+    memory_free_ptr(chunk, blocks[0]);
+    memory_free(chunk, "mesh_1");
+    count = memc_tag_stats(chunk, tags, 4);
+    CHECK(tags[0].live_bytes == 2048 && tags[0].live_blocks == 8 && tags[0].alloc_count == 10);
+
+    // A grown block keeps its tag and counts its new size; if it moved, that counts as another allocation
+    blocks[2] = memory_realloc(chunk, blocks[2], 512);
+    count = memc_tag_stats(chunk, tags, 4);
+    const Memtag* mesh = find_tag(tags, count, "mesh");
+    CHECK(mesh && mesh->live_blocks == 8);
+    CHECK(mesh && mesh->live_bytes >= 2048 + 256 && mesh->live_bytes < 2048 + 256 + 48);  // A block too small to split counts whole
+    CHECK(mesh && (mesh->alloc_count == 10 || mesh->alloc_count == 11));
+    CHECK(memory_find(chunk, "mesh_2") == blocks[2]);
+
+    // Freed tags stay listed, with nothing live, after the live ones
+    memory_free(chunk, "audio_0");
+    count = memc_tag_stats(chunk, tags, 4);
+    CHECK(count == 2 && strcmp(tags[1].name, "audio") == 0 && tags[1].live_bytes == 0 && tags[1].alloc_count == 1);
+
+    // A reset drops every live block and keeps the history
+    memc_reset(chunk);
+    count = memc_tag_stats(chunk, tags, 4);
+    CHECK(count == 2 && tags[0].live_bytes == 0 && tags[1].live_bytes == 0);
+    CHECK(find_tag(tags, count, "mesh")->alloc_count >= 10);
+    memc_dealloc(chunk);
+}
+
+static void test_ranking(void) {
+    // Tags come largest first, ties by name, and `max` keeps the top of the list
+    Memchunk* chunk = memc_init("tag_ranking", 1 << 20);
+    memory_alloc(chunk, 1024, "small");
+    memory_alloc(chunk, 4096, "large");
+    memory_alloc(chunk, 2048, "middle_a");
+    memory_alloc(chunk, 2048, "middle_b");
+    Memtag tags[4];
+    CHECK(memc_tag_stats(chunk, tags, 4) == 4);
+    CHECK(strcmp(tags[0].name, "large") == 0);
+    CHECK(strcmp(tags[1].name, "middle_a") == 0);
+    CHECK(strcmp(tags[2].name, "middle_b") == 0);
+    CHECK(strcmp(tags[3].name, "small") == 0);
+    CHECK(memc_tag_stats(chunk, tags, 2) == 2 && strcmp(tags[1].name, "middle_a") == 0);
+    CHECK(memc_tag_stats(chunk, tags, 0) == 0);
+    CHECK(memc_tag_stats(NULL, tags, 4) == 0);
+    memc_dealloc(chunk);
+}
+
+static void test_chain(void) {
+    // The members of a growth chain keep their own tags, and the report merges them
+    Memchunk* chunk = memc_init("tag_chain", 1 << 16);
+    CHECK(memc_set_growth(chunk, 1 << 16, 1.0, 0) == 0);
+    char name[32];
+    for (int i = 0; i < 100; i++) {
+        snprintf(name, sizeof(name), "tile_%d", i);
+        CHECK(memory_alloc(chunk, 4096, name) != NULL);
+    }
+    CHECK(chunk->next != NULL);
+    Memtag tags[4];
+    CHECK(memc_tag_stats(chunk, tags, 4) == 1);
+    CHECK(tags[0].live_blocks == 100 && tags[0].live_bytes == 100 * 4096 && tags[0].alloc_count == 100);
+    memc_dealloc(chunk);
+}
+
+static void test_buddy(void) {
+    // Buddy blocks count their power-of-two size
+    Memchunk* chunk = memc_init_buddy("tag_buddy", 1 << 20, 6);
+    memory_alloc(chunk, 100, "buf_1");
+    memory_alloc(chunk, 1000, "buf_2");
+    Memtag tags[2];
+    CHECK(memc_tag_stats(chunk, tags, 2) == 1);
+    CHECK(tags[0].live_bytes == 128 + 1024 && tags[0].live_blocks == 2);
+    memory_free(chunk, "buf_2");
+    memc_tag_stats(chunk, tags, 2);
+    CHECK(tags[0].live_bytes == 128 && tags[0].live_blocks == 1);
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    test_tag_names();
+    test_accounting();
+    test_ranking();
+    test_chain();
+    test_buddy();
+    return TEST_RESULT();
+}
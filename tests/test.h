@@ -0,0 +1,88 @@
+#ifndef CEIT_TEST_H
+#define CEIT_TEST_H
+
+#include "ceit.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+/** Number of failed checks so far. */
+static int test_failures;
+
+/** Reports a failed check with its location and keeps going. */
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        test_failures++; \
+    } \
+} while (0)
+
+/** Exit status of a test: 0 if every check passed. */
+#define TEST_RESULT() (test_failures ? (fprintf(stderr, "%d check(s) failed\n", test_failures), 1) : 0)
+
+/**
+ * @brief Walks the blocks of every Memchunk of a chain and checks the heap
+ * invariants: the blocks tile the pool, free blocks are never adjacent and
+ * end in their size footer, PREV_FREE matches the previous block, and the
+ * used/free counters match the blocks.
+ *
+ * Not for arenas and buddy Memchunks, which have no block headers.
+ */
+static inline void check_heap(const Memchunk* chunk) {
+    for (; chunk; chunk = chunk->next) {
+        const char* end = (const char*)(chunk->memory_pool + 1) + chunk->total_size;
+        const Memory* block = chunk->memory_pool;
+        size_t used = 0;
+        int prev_free = 0;
+        while ((const char*)block < end) {
+            size_t size = block->size & ~(size_t)CEIT_BLOCK_FLAGS;
+            int is_free = (block->size & CEIT_BLOCK_FREE) != 0;
+            CHECK(size % CEIT_ALIGN == 0 && size > 0);
+            CHECK(((block->size & CEIT_BLOCK_PREV_FREE) != 0) == prev_free);
+            CHECK(!(is_free && prev_free));
+            const Memory* next = (const Memory*)((const char*)(block + 1) + size);
+            if (is_free) CHECK(((const size_t*)next)[-1] == size);
+            else used += size;
+            prev_free = is_free;
+            block = next;
+        }
+        CHECK((const char*)block == end);
+        CHECK(chunk->used_memory == used);
+        CHECK(chunk->free_memory == chunk->total_size - chunk->used_memory);
+    }
+}
+
+/** Fills a block with a pattern derived from `seed`. */
+static inline void fill_pattern(void* ptr, size_t size, unsigned seed) {
+    for (size_t i = 0; i < size; i++) ((unsigned char*)ptr)[i] = (unsigned char)(seed * 31 + i);
+}
+
+/** Checks that a block still holds the pattern of `seed`. */
+static inline int has_pattern(const void* ptr, size_t size, unsigned seed) {
+    for (size_t i = 0; i < size; i++) {
+        if (((const unsigned char*)ptr)[i] != (unsigned char)(seed * 31 + i)) return 0;
+    }
+    return 1;
+}
+
+/** Returns what memc_dbg prints for a Memchunk; the caller frees it. */
+static inline char* dbg_output(Memchunk* chunk) {
+    char* buffer = malloc(1 << 16);
+    FILE* file = tmpfile();
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    dup2(fileno(file), STDOUT_FILENO);
+    memc_dbg(1, chunk);
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    rewind(file);
+    size_t length = fread(buffer, 1, (1 << 16) - 1, file);
+    buffer[length] = '\0';
+    fclose(file);
+    return buffer;
+}
+
+#endif
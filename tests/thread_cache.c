@@ -0,0 +1,157 @@
+// Thread-safe Memchunks: per-thread caches, double frees through the cache, flushing and thread exit.
+#include "test.h"
+#include <pthread.h>
+#include <sched.h>
+
+#define THREADS 8
+#define ROUNDS 20000
+
+static Memchunk* shared;
+
+static void* worker(void* arg) {
+    unsigned seed = (unsigned)(size_t)arg;
+    void* blocks[64] = {0};
+    size_t sizes[64] = {0};
+    unsigned tags[64] = {0};
+    for (int round = 0; round < ROUNDS; round++) {
+        int i = rand_r(&seed) % 64;
+        if (blocks[i]) {
+            if (!has_pattern(blocks[i], sizes[i], tags[i])) __atomic_add_fetch(&test_failures, 1, __ATOMIC_RELAXED);
+            memory_free_ptr(shared, blocks[i]);
+            blocks[i] = NULL;
+        } else {
+            sizes[i] = 1 + rand_r(&seed) % (round % 10 ? 256 : 4096);
+            blocks[i] = memory_alloc(shared, sizes[i], NULL);
+            if (!blocks[i]) __atomic_add_fetch(&test_failures, 1, __ATOMIC_RELAXED);
+            else fill_pattern(blocks[i], sizes[i], tags[i] = (unsigned)round);
+        }
+    }
+    for (int i = 0; i < 64; i++) memory_free_ptr(shared, blocks[i]);
+    return NULL;  // Exiting flushes this thread's cache
+}
+
+static void test_threads(void) {
+    shared = memc_init_flags("threads", 16 << 20, MEMC_THREAD_SAFE);
+    pthread_t threads[THREADS];
+    for (size_t i = 0; i < THREADS; i++) pthread_create(&threads[i], NULL, worker, (void*)(i * 7919 + 1));
+    for (int i = 0; i < THREADS; i++) pthread_join(threads[i], NULL);
+    check_heap(shared);
+    CHECK(shared->used_memory == 0);
+    CHECK(shared->memory_pool->size == (shared->total_size | CEIT_BLOCK_FREE));
+    memc_dealloc(shared);
+}
+
+static void test_double_free(void) {
+    Memchunk* chunk = memc_init_flags("double_free", 1 << 20, MEMC_THREAD_SAFE);
+    void* a = memory_alloc(chunk, 64, NULL);
+    memory_free_ptr(chunk, a);
+    memory_free_ptr(chunk, a);  // Already in this thread's cache
+    mem_free(a);
+    void* batch[1] = {a};
+    memory_free_batch(chunk, batch, 1);
+    void* first = memory_alloc(chunk, 64, NULL);
+    void* second = memory_alloc(chunk, 64, NULL);
+    CHECK(first == a);
+    CHECK(second != first);  // The block was cached once, so it is handed out once
+
+    memory_free_ptr(chunk, first);
+    memory_free_ptr(chunk, second);
+    memc_flush(chunk);
+    memory_free_ptr(chunk, first);  // Already back in the free lists
+    memory_free_ptr(chunk, second);
+    void* blocks[40];
+    for (int i = 0; i < 40; i++) {
+        blocks[i] = memory_alloc(chunk, 64, NULL);
+        for (int j = 0; j < i; j++) CHECK(blocks[j] != blocks[i]);
+    }
+    for (int i = 0; i < 40; i++) memory_free_ptr(chunk, blocks[i]);
+    memc_flush(chunk);
+    check_heap(chunk);
+    CHECK(chunk->used_memory == 0);
+    memc_dealloc(chunk);
+}
+
+static void* free_elsewhere(void* ptr) {
+    memory_free_ptr(shared, ptr);  // Cached by the main thread: ignored here
+    return NULL;
+}
+
+static void test_double_free_across_threads(void) {
+    shared = memc_init_flags("double_free_threads", 1 << 20, MEMC_THREAD_SAFE);
+    void* a = memory_alloc(shared, 64, NULL);
+    memory_free_ptr(shared, a);
+    pthread_t thread;
+    pthread_create(&thread, NULL, free_elsewhere, a);
+    pthread_join(thread, NULL);
+    memc_flush(shared);
+    check_heap(shared);
+    CHECK(shared->used_memory == 0);
+    memc_dealloc(shared);
+}
+
+static void test_stale_header(void) {
+    // Header bytes left over from a free-list link (CEIT_NIL) are not the cache mark
+    unsigned flags[] = {0, MEMC_THREAD_SAFE};
+    for (int f = 0; f < 2; f++) {
+        Memchunk* chunk = memc_init_flags("stale_header", 1 << 20, flags[f]);
+        void* blocks[8];
+        for (int i = 0; i < 8; i++) {
+            blocks[i] = memory_alloc(chunk, 64, NULL);
+            ((Memory*)blocks[i] - 1)->name_hash = (size_t)-1;
+        }
+        memory_free_batch(chunk, blocks, 4);
+        for (int i = 4; i < 8; i++) memory_free_ptr(chunk, blocks[i]);
+        memc_flush(chunk);
+        CHECK(chunk->used_memory == 0);
+        check_heap(chunk);
+        memc_dealloc(chunk);
+    }
+}
+
+static int worker_done;
+
+static void* cache_and_exit(void* arg) {
+    (void)arg;
+    for (int i = 0; i < 100; i++) memory_free_ptr(shared, memory_alloc(shared, 64, NULL));
+    __atomic_store_n(&worker_done, 1, __ATOMIC_RELEASE);
+    return NULL;  // The exit flush may run while the main thread resets
+}
+
+static void test_reset_during_exit(void) {
+    // A thread's exit flush and memc_reset take their locks in the same order
+    shared = memc_init_flags("reset_exit", 1 << 20, MEMC_THREAD_SAFE);
+    for (int round = 0; round < 200; round++) {
+        __atomic_store_n(&worker_done, 0, __ATOMIC_RELAXED);
+        pthread_t thread;
+        pthread_create(&thread, NULL, cache_and_exit, NULL);
+        while (!__atomic_load_n(&worker_done, __ATOMIC_ACQUIRE)) sched_yield();
+        memc_reset(shared);
+        pthread_join(thread, NULL);
+    }
+    memc_reset(shared);
+    check_heap(shared);
+    CHECK(shared->used_memory == 0);
+    memc_dealloc(shared);
+}
+
+static void test_flush(void) {
+    Memchunk* chunk = memc_init_flags("flush", 1 << 20, MEMC_THREAD_SAFE);
+    void* blocks[10];
+    for (int i = 0; i < 10; i++) blocks[i] = memory_alloc(chunk, 100, NULL);
+    for (int i = 0; i < 10; i++) memory_free_ptr(chunk, blocks[i]);
+    CHECK(chunk->used_memory > 0);  // The blocks wait in the cache
+    memc_flush(chunk);
+    CHECK(chunk->used_memory == 0);
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    test_threads();
+    test_double_free();
+    test_double_free_across_threads();
+    test_stale_header();
+    test_reset_during_exit();
+    test_flush();
+    return TEST_RESULT();
+}
@@ -0,0 +1,79 @@
+// TLSF engine: bitmaps that match the lists, heap invariants under random traffic, and O(1) lookups that still fit.
+#include "test.h"
+
+#define SL 16
+#define BLOCKS 3000
+
+/** Checks that every TLSF bitmap bit is set exactly when its list is non-empty. */
+static void check_maps(const Memchunk* chunk) {
+    for (int cls = 0; cls < CEIT_SIZE_CLASSES; cls++) {
+        unsigned map = 0;
+        for (int second = 0; second < SL; second++) {
+            if (chunk->tlsf_lists[cls * SL + second] != (size_t)-1) map |= 1U << second;
+        }
+        CHECK(chunk->tlsf_maps[cls] == map);
+        CHECK(((chunk->free_map >> cls) & 1) == (map != 0));
+    }
+}
+
+static void test_random_traffic(void) {
+    Memchunk* chunk = memc_init_flags("tlsf", 16 << 20, MEMC_TLSF);
+    CHECK(chunk->tlsf_lists != NULL);
+    static void* blocks[BLOCKS];
+    static size_t sizes[BLOCKS];
+    srand(4);
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < BLOCKS; i++) {
+            if (blocks[i]) {
+                CHECK(has_pattern(blocks[i], sizes[i], i));
+                memory_free_ptr(chunk, blocks[i]);
+                blocks[i] = NULL;
+            }
+            if (rand() % 2) {
+                sizes[i] = rand() % 4 ? 1 + rand() % 512 : 1 + rand() % 32768;
+                blocks[i] = memory_alloc(chunk, sizes[i], NULL);
+                CHECK(blocks[i] != NULL);
+                if (blocks[i]) fill_pattern(blocks[i], sizes[i], i);
+            }
+        }
+        check_heap(chunk);
+        check_maps(chunk);
+    }
+    for (int i = 0; i < BLOCKS; i++) memory_free_ptr(chunk, blocks[i]);
+    check_heap(chunk);
+    check_maps(chunk);
+    CHECK(chunk->memory_pool->size == (chunk->total_size | CEIT_BLOCK_FREE));
+    memc_dealloc(chunk);
+}
+
+static void test_good_fit(void) {
+    // Free blocks of one size class: a request is served from the first list whose blocks all fit
+    Memchunk* chunk = memc_init_flags("tlsf_fit", 1 << 20, MEMC_TLSF);
+    void* small[100];
+    void* spacers[100];
+    for (int i = 0; i < 100; i++) {
+        small[i] = memory_alloc(chunk, 528, NULL);
+        spacers[i] = memory_alloc(chunk, 16, NULL);
+    }
+    void* large = memory_alloc(chunk, 1008, NULL);
+    memory_alloc(chunk, 16, NULL);
+    while (memory_alloc(chunk, 4096, NULL)) {}  // Use up the tail
+    while (memory_alloc(chunk, 32, NULL)) {}
+    CHECK(chunk->free_map == 0);
+    for (int i = 0; i < 100; i++) memory_free_ptr(chunk, small[i]);
+    memory_free_ptr(chunk, large);
+
+    CHECK(memory_alloc(chunk, 960, NULL) == large);  // Found without walking the 528-byte blocks
+    CHECK(memory_alloc(chunk, 600, NULL) == NULL);    // A 528-byte block cannot serve it
+    CHECK(memory_alloc(chunk, 500, NULL) != NULL);
+    check_heap(chunk);
+    check_maps(chunk);
+    (void)spacers;
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    test_random_traffic();
+    test_good_fit();
+    return TEST_RESULT();
+}
@@ -0,0 +1,117 @@
+// Returning free memory to the OS: memc_trim, decay of blocks that stay free, and arenas.
+#include "test.h"
+#include <time.h>
+
+static size_t rss_kb(void) {
+    size_t pages = 0, resident = 0;
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (!file) return 0;
+    if (fscanf(file, "%zu %zu", &pages, &resident) != 2) resident = 0;
+    fclose(file);
+    return resident * 4;
+}
+
+static void test_trim(void) {
+    Memchunk* chunk = memc_init_flags("trim", 64 << 20, MEMC_MMAP);
+    void* keep = memory_alloc(chunk, 100, NULL);
+    void* big = memory_alloc(chunk, 32 << 20, NULL);
+    memset(big, 1, 32 << 20);
+    size_t before = rss_kb();
+    memory_free_ptr(chunk, big);
+    size_t purged = memc_trim(chunk);
+    CHECK(purged >= (size_t)31 << 20);
+    CHECK(chunk->purged_memory == purged);
+    CHECK(before - rss_kb() >= 30 << 10);
+    CHECK(memc_trim(chunk) == 0);  // Nothing left to purge
+
+    // Purged pages come back as zero, and the data of live blocks is untouched
+    fill_pattern(keep, 100, 1);
+    unsigned char* again = memory_calloc(chunk, 1, 16 << 20, NULL);
+    CHECK(again != NULL);
+    size_t nonzero = 0;
+    for (size_t i = 0; i < (16 << 20); i++) nonzero += again[i] != 0;
+    CHECK(nonzero == 0);
+    CHECK(has_pattern(keep, 100, 1));
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+static void test_small_blocks_not_purged(void) {
+    Memchunk* chunk = memc_init("trim_small", 1 << 20);
+    void* blocks[3];
+    for (int i = 0; i < 3; i++) blocks[i] = memory_alloc(chunk, 1000, NULL);
+    memory_free_ptr(chunk, blocks[1]);  // Holds no whole page
+    size_t purged = memc_trim(chunk);
+    CHECK(purged < (1 << 20));  // Only the tail block's pages
+    check_heap(chunk);
+    memc_dealloc(chunk);
+}
+
+static void test_decay(void) {
+    Memchunk* chunk = memc_init_flags("decay", 64 << 20, MEMC_MMAP);
+    CHECK(memc_set_decay(chunk, 20) == 0);
+    void* big = memory_alloc(chunk, 8 << 20, NULL);
+    void* guard = memory_alloc(chunk, 100, NULL);
+    void* other = memory_alloc(chunk, 1 << 20, NULL);
+    void* guard2 = memory_alloc(chunk, 100, NULL);
+    memset(big, 1, 8 << 20);
+    size_t resident = rss_kb();
+    memory_free_ptr(chunk, big);
+    size_t purged = chunk->purged_memory;  // The tail, free since the start, may go; big is too recent
+    CHECK(rss_kb() + 1024 > resident);
+
+    struct timespec pause = {0, 60 * 1000000};
+    nanosleep(&pause, NULL);
+    // Decay runs lazily, from the next free of a large block
+    memory_free_ptr(chunk, other);
+    CHECK(chunk->purged_memory - purged >= (size_t)7 << 20);
+    check_heap(chunk);
+    memory_free_ptr(chunk, guard);
+    memory_free_ptr(chunk, guard2);
+    CHECK(memc_set_decay(NULL, 20) == -1);
+    memc_dealloc(chunk);
+}
+
+static void test_decay_without_frees(void) {
+    // After a burst, small allocations alone or reading the statistics purge what the burst freed
+    struct timespec pause = {0, 60 * 1000000};
+    for (int poll = 0; poll < 2; poll++) {
+        Memchunk* chunk = memc_init_flags("decay_idle", 64 << 20, MEMC_MMAP);
+        CHECK(memc_set_decay(chunk, 20) == 0);
+        void* big = memory_alloc(chunk, 8 << 20, NULL);
+        memory_alloc(chunk, 100, NULL);  // Keeps big from merging with the tail
+        memset(big, 1, 8 << 20);
+        memory_free_ptr(chunk, big);
+        size_t purged = chunk->purged_memory;
+        nanosleep(&pause, NULL);
+        if (poll == 0) {
+            for (int i = 0; i < 64; i++) memory_alloc(chunk, 32, NULL);
+        } else {
+            Memstats stats;
+            memc_stats(chunk, &stats);
+        }
+        CHECK(chunk->purged_memory - purged >= (size_t)7 << 20);
+        check_heap(chunk);
+        memc_dealloc(chunk);
+    }
+}
+
+static void test_arena(void) {
+    Memchunk* chunk = memc_init_flags("trim_arena", 16 << 20, MEMC_ARENA | MEMC_MMAP);
+    void* data = memory_alloc(chunk, 8 << 20, NULL);
+    memset(data, 1, 8 << 20);
+    memc_reset(chunk);
+    CHECK(memc_trim(chunk) >= (size_t)7 << 20);  // Everything above the top
+    unsigned char* zero = memory_calloc(chunk, 1, 8 << 20, NULL);
+    CHECK(zero && zero[0] == 0 && zero[(8 << 20) - 1] == 0);
+    memc_dealloc(chunk);
+}
+
+int main(void) {
+    test_trim();
+    test_small_blocks_not_purged();
+    test_decay();
+    test_decay_without_frees();
+    test_arena();
+    return TEST_RESULT();
+}